@@ -20,6 +20,7 @@
 // THE SOFTWARE.
 //===----------------------------------------------------------------------===//
 
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <string>
@@ -129,7 +130,23 @@ auto Binder::BindIndex(duckdb_libpgquery::PGIndexStmt *stmt) -> std::unique_ptr<
     }
   }
 
-  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols));
+  // The parser has no INCLUDE clause, so covering columns are given as `WITH (include = 'col1, col2')`.
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols;
+  if (stmt->options != nullptr) {
+    for (auto cell = stmt->options->head; cell != nullptr; cell = cell->next) {
+      auto option = reinterpret_cast<duckdb_libpgquery::PGDefElem *>(cell->data.ptr_value);
+      auto value = reinterpret_cast<duckdb_libpgquery::PGValue *>(option->arg);
+      if (strcmp(option->defname, "include") != 0 || value == nullptr || value->type != duckdb_libpgquery::T_PGString) {
+        throw NotImplementedException(fmt::format("unsupported index option {}", option->defname));
+      }
+      for (const auto &name : StringUtil::Split(value->val.str, ',')) {
+        auto column_ref = ResolveColumn(*table, std::vector{StringUtil::Strip(name, ' ')});
+        include_cols.emplace_back(std::make_unique<BoundColumnRef>(dynamic_cast<const BoundColumnRef &>(*column_ref)));
+      }
+    }
+  }
+
+  return std::make_unique<IndexStatement>(stmt->idxname, std::move(table), std::move(cols), std::move(include_cols));
 }
 
 }  // namespace bustub
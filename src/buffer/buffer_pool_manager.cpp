@@ -12,180 +12,978 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <thread>  // NOLINT
+
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/macros.h"
+#include "fmt/format.h"
 #include "storage/page/page.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
 
+BufferPoolManager::BufferPoolShard::BufferPoolShard(frame_id_t frame_offset, size_t num_frames, size_t replacer_k,
+                                                    size_t num_partitions)
+    : frame_offset_(frame_offset),
+      num_frames_(num_frames),
+      page_index_buckets_((2 * num_frames + PAGE_INDEX_WAYS - 1) / PAGE_INDEX_WAYS),
+      replacer_(std::make_unique<LRUKReplacer>(num_frames, replacer_k)),
+      free_lists_(num_partitions),
+      access_log_(std::make_unique<std::atomic<uint64_t>[]>(ACCESS_LOG_SIZE)),
+      unpin_log_(std::make_unique<std::atomic<frame_id_t>[]>(num_frames)) {
+  // Initially, every frame of the shard is in the free list of its partition.
+  for (size_t i = 0; i < num_frames; ++i) {
+    PushFreeFrame(frame_offset_ + static_cast<frame_id_t>(i));
+    unpin_log_[i] = INVALID_FRAME_ID;
+  }
+  page_index_ = std::make_unique<std::atomic<uint64_t>[]>(page_index_buckets_ * PAGE_INDEX_WAYS);
+  for (size_t i = 0; i < page_index_buckets_ * PAGE_INDEX_WAYS; ++i) {
+    page_index_[i] = EMPTY_SLOT;
+  }
+  for (size_t i = 0; i < static_cast<size_t>(ACCESS_LOG_SIZE); ++i) {
+    access_log_[i] = EMPTY_SLOT;
+  }
+}
+
+auto BufferPoolManager::BufferPoolShard::HasFreeFrame() const -> bool {
+  return std::any_of(free_lists_.begin(), free_lists_.end(), [](const auto &free_list) { return !free_list.empty(); });
+}
+
+auto BufferPoolManager::BufferPoolShard::PopFreeFrame(size_t partition) -> frame_id_t {
+  if (partition >= free_lists_.size() || free_lists_[partition].empty()) {
+    partition = 0;
+    while (free_lists_[partition].empty()) {
+      partition++;
+    }
+  }
+  frame_id_t frame_id = free_lists_[partition].front();
+  free_lists_[partition].pop_front();
+  return frame_id;
+}
+
+void BufferPoolManager::BufferPoolShard::MapPage(page_id_t page_id, frame_id_t frame_id) {
+  page_table_[page_id] = frame_id;
+  auto *bucket = IndexBucket(page_id);
+  for (size_t i = 0; i < PAGE_INDEX_WAYS; i++) {
+    if (bucket[i].load(std::memory_order_relaxed) == EMPTY_SLOT) {
+      bucket[i].store(static_cast<uint64_t>(static_cast<uint32_t>(page_id)) << 32 | static_cast<uint32_t>(frame_id));
+      return;
+    }
+  }
+}
+
+void BufferPoolManager::BufferPoolShard::UnmapPage(page_id_t page_id) {
+  page_table_.erase(page_id);
+  auto *bucket = IndexBucket(page_id);
+  for (size_t i = 0; i < PAGE_INDEX_WAYS; i++) {
+    if (bucket[i].load(std::memory_order_relaxed) >> 32 == static_cast<uint32_t>(page_id)) {
+      bucket[i].store(EMPTY_SLOT);
+      return;
+    }
+  }
+}
+
+auto BufferPoolManager::BufferPoolShard::FindFrame(page_id_t page_id) const -> frame_id_t {
+  const auto *bucket = IndexBucket(page_id);
+  for (size_t i = 0; i < PAGE_INDEX_WAYS; i++) {
+    uint64_t slot = bucket[i].load();
+    if (slot >> 32 == static_cast<uint32_t>(page_id)) {
+      return static_cast<frame_id_t>(static_cast<uint32_t>(slot));
+    }
+  }
+  return INVALID_FRAME_ID;
+}
+
+auto BufferPoolManager::BufferPoolShard::TryLogAccess(frame_id_t frame_id, AccessType access_type) -> bool {
+  size_t tail = access_log_tail_.load();
+  do {
+    if (tail - access_log_head_.load() >= static_cast<size_t>(ACCESS_LOG_SIZE)) {
+      return false;
+    }
+  } while (!access_log_tail_.compare_exchange_weak(tail, tail + 1));
+  // The slot was consumed before the head moved past it, so it is free.
+  access_log_[tail % ACCESS_LOG_SIZE].store(static_cast<uint64_t>(static_cast<uint32_t>(frame_id)) << 32 |
+                                            static_cast<uint32_t>(access_type));
+  return true;
+}
+
 BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
-  // TODO(students): remove this line after you have implemented the buffer pool manager
+                                     LogManager *log_manager, size_t num_shards, size_t second_tier_bytes,
+                                     NumaMode numa_mode)
+    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager), numa_mode_(numa_mode) {
+  BUSTUB_ENSURE(num_shards > 0 && num_shards <= pool_size_, "number of shards must be in [1, pool_size]");
+
+  // we allocate a consecutive memory space for the buffer pool, and a single arena for the data of its pages
+  arena_ = std::make_unique<FrameArena>(pool_size_);
+  pages_ = static_cast<Page *>(::operator new[](pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < pool_size_; ++i) {
+    new (&pages_[i]) Page(arena_->GetFrame(i));
+  }
+
+  // Split the frames into contiguous ranges, the first (pool_size % num_shards) shards get one extra frame.
+  size_t frame_offset = 0;
+  for (size_t i = 0; i < num_shards; ++i) {
+    size_t num_frames = pool_size_ / num_shards + (i < pool_size_ % num_shards ? 1 : 0);
+    size_t num_partitions = numa_mode_ == NumaMode::Partition ? std::min(NumaUtil::NodeCount(), num_frames) : 1;
+    shards_.emplace_back(std::make_unique<BufferPoolShard>(static_cast<frame_id_t>(frame_offset), num_frames,
+                                                           replacer_k, num_partitions));
+    frame_offset += num_frames;
+  }
 
-  // we allocate a consecutive memory space for the buffer pool
-  pages_ = new Page[pool_size_];
-  replacer_ = std::make_unique<LRUKReplacer>(pool_size, replacer_k);
+  // No frame has been touched yet, so the kernel can still place all of them. Placement is best effort: it does
+  // nothing for simulated nodes, and the buffer pool works the same wherever its frames are.
+  if (numa_mode_ == NumaMode::Interleave) {
+    arena_->InterleaveFrames();
+  } else if (numa_mode_ == NumaMode::Partition) {
+    for (auto &shard : shards_) {
+      size_t first_frame = shard->frame_offset_;
+      for (size_t i = 0; i < shard->num_frames_; i++) {
+        auto frame_id = static_cast<frame_id_t>(shard->frame_offset_ + i);
+        if (i + 1 == shard->num_frames_ || shard->PartitionOf(frame_id + 1) != shard->PartitionOf(frame_id)) {
+          arena_->BindFrames(first_frame, frame_id + 1 - first_frame, shard->PartitionOf(frame_id));
+          first_frame = frame_id + 1;
+        }
+      }
+    }
+  }
+  if (second_tier_bytes > 0) {
+    second_tier_ = std::make_unique<CompressedPageCache>(second_tier_bytes);
+  }
+}
 
-  // Initially, every page is in the free list.
+BufferPoolManager::~BufferPoolManager() {
+  StopBackgroundFlusher();
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
   for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+    pages_[i].~Page();
   }
+  ::operator delete[](pages_);
 }
 
-BufferPoolManager::~BufferPoolManager() { delete[] pages_; }
+void BufferPoolManager::ApplyAccessLog(BufferPoolShard *shard) {
+  size_t head = shard->access_log_head_.load();
+  while (head != shard->access_log_tail_.load()) {
+    auto &slot = shard->access_log_[head % ACCESS_LOG_SIZE];
+    uint64_t entry = slot.load();
+    if (entry == BufferPoolShard::EMPTY_SLOT) {
+      // A hit has claimed the slot but not filled it yet, see the unpin log below.
+      std::this_thread::yield();
+      continue;
+    }
+    slot.store(BufferPoolShard::EMPTY_SLOT);
+    shard->access_log_head_.store(++head);
+    auto frame_id = static_cast<frame_id_t>(entry >> 32);
+    auto access_type = static_cast<AccessType>(static_cast<uint32_t>(entry));
+    shard->stats_.Access(access_type).hits_++;
+    // An optimistic hit holds no pin, so its frame may have been freed since. The replacer must not track a free frame.
+    if (pages_[frame_id].page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    shard->replacer_->RecordAccess(shard->LocalFrameId(frame_id), access_type);
+    // A hit may have pinned an evictable frame. If it has already unpinned it, the frame is evictable still or waits in
+    // the unpin log. A hit that pins it after this check makes AcquireFrame() pass over the frame.
+    if (pages_[frame_id].GetPinCount() > 0) {
+      shard->replacer_->SetEvictable(shard->LocalFrameId(frame_id), false);
+    }
+  }
 
-auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
-  std::lock_guard<std::mutex> lock(latch_);
-  if (free_list_.empty() && replacer_->Size() == 0) {
-    return nullptr;
+  while (true) {
+    auto &slot = shard->unpin_log_[shard->unpin_log_head_ % shard->num_frames_];
+    frame_id_t frame_id = slot.load();
+    if (frame_id == INVALID_FRAME_ID) {
+      if (shard->unpin_log_head_ == shard->unpin_log_tail_.load()) {
+        break;
+      }
+      // An unpinner has claimed the slot but not filled it yet. It is about to, and until it has, every frame logged
+      // after it would look pinned, so wait for it rather than leave them behind.
+      std::this_thread::yield();
+      continue;
+    }
+    slot.store(INVALID_FRAME_ID);
+    shard->unpin_log_head_++;
+    // Take the frame out of the log before looking at its pin count: an unpin that we don't see logs it again.
+    Page *page_ptr = &pages_[frame_id];
+    page_ptr->unpin_logged_.store(false);
+    if (page_ptr->GetPinCount() == 0) {
+      shard->replacer_->SetEvictable(shard->LocalFrameId(frame_id), true);
+    }
   }
-  Page *page_ptr;
-  frame_id_t new_frame_id;
-  if (!free_list_.empty()) {
-    new_frame_id = free_list_.front();
-    free_list_.pop_front();
-    page_ptr = &pages_[new_frame_id];
-  } else {
-    replacer_->Evict(&new_frame_id);
-    page_ptr = &pages_[new_frame_id];
-    page_id_t old_page_id = page_ptr->GetPageId();
-    if (page_ptr->IsDirty()) {
-      disk_manager_->WritePage(old_page_id, page_ptr->GetData());
-      page_ptr->is_dirty_ = false;
+}
+
+void BufferPoolManager::LogAccess(BufferPoolShard *shard, frame_id_t frame_id, AccessType access_type) {
+  while (!shard->TryLogAccess(frame_id, access_type)) {
+    ApplyAccessLog(shard);
+  }
+}
+
+auto BufferPoolManager::HasAvailableFrame(BufferPoolShard *shard) -> bool {
+  ApplyAccessLog(shard);
+  return shard->HasFreeFrame() || shard->replacer_->Size() > 0;
+}
+
+auto BufferPoolManager::AcquireFrame(BufferPoolShard *shard, page_id_t *write_back_page_id, page_id_t *cache_page_id)
+    -> frame_id_t {
+  *write_back_page_id = INVALID_PAGE_ID;
+  *cache_page_id = INVALID_PAGE_ID;
+  // Without partitions, every frame is local.
+  size_t node = numa_mode_ == NumaMode::Partition ? NumaUtil::CurrentNode() : 0;
+  if (shard->HasFreeFrame()) {
+    frame_id_t frame_id = shard->PopFreeFrame(node);
+    // A lock-free hit that found the frame through a stale index entry drops its pin as soon as it sees that the frame
+    // holds no page.
+    while (!ClaimFrame(&pages_[frame_id])) {
+      std::this_thread::yield();
     }
-    page_ptr->ResetMemory();
-    page_table_.erase(old_page_id);
+    CountFrameLocality(shard, frame_id, node);
+    pages_[frame_id].BumpVersion();
+    return frame_id;
+  }
+  frame_id_t local_frame_id;
+  while (true) {
+    if (!shard->replacer_->Evict(&local_frame_id)) {
+      return INVALID_FRAME_ID;
+    }
+    if (ClaimFrame(&pages_[shard->frame_offset_ + local_frame_id])) {
+      break;
+    }
+    // A lock-free hit has pinned the victim since the access log was applied. Track the frame again, as pinned, and
+    // let the unpin log make it evictable once the hit is done with it.
+    shard->replacer_->RecordAccess(local_frame_id);
+  }
+  shard->stats_.evictions_++;
+  frame_id_t frame_id = shard->frame_offset_ + local_frame_id;
+  CountFrameLocality(shard, frame_id, node);
+  Page *page_ptr = &pages_[frame_id];
+  // Optimistic readers of the old page must notice that the frame is about to hold another one.
+  page_ptr->BumpVersion();
+  page_id_t old_page_id = page_ptr->GetPageId();
+  if (page_ptr->IsDirty()) {
+    // The frame still holds the only up-to-date copy of the old page. Until FillFrame() has written it back, readers
+    // of old_page_id have to wait instead of reading a stale version from disk.
+    *write_back_page_id = old_page_id;
+    shard->write_back_pages_.insert(old_page_id);
+    page_ptr->is_dirty_ = false;
+  }
+  if (second_tier_ != nullptr) {
+    // Readers of old_page_id wait for the copy as well: a read from disk could still be overtaken by the insertion,
+    // which would then replace a newer copy.
+    *cache_page_id = old_page_id;
+    shard->write_back_pages_.insert(old_page_id);
+  }
+  shard->UnmapPage(old_page_id);
+  return frame_id;
+}
+
+auto BufferPoolManager::FillFrame(BufferPoolShard *shard, std::unique_lock<std::mutex> *lock, Page *page,
+                                  page_id_t write_back_page_id, page_id_t cache_page_id, bool read_page) -> bool {
+  // The victim that readers wait for, if any.
+  page_id_t pending_page_id = write_back_page_id != INVALID_PAGE_ID ? write_back_page_id : cache_page_id;
+  if (pending_page_id == INVALID_PAGE_ID && !read_page) {
+    page->ResetMemory();
+    page->io_in_progress_ = false;
+    return false;
   }
+  page_id_t page_id = page->page_id_;
+  lock->unlock();
+
+  if (write_back_page_id != INVALID_PAGE_ID) {
+    try {
+      disk_manager_->WritePage(write_back_page_id, page->GetData());
+    } catch (const std::exception &e) {
+      // The frame still holds the only up-to-date copy of the victim, so it must not be lost. Only this fetch fails.
+      lock->lock();
+      RestoreVictim(shard, page, write_back_page_id);
+      throw Exception(fmt::format("can't make room for page {}: {}", page_id, e.what()));
+    }
+    foreground_write_cnt_++;
+  }
+  bool second_tier_hit = false;
+  try {
+    if (cache_page_id != INVALID_PAGE_ID) {
+      second_tier_->Insert(cache_page_id, page->GetData());
+    }
+    page->ResetMemory();
+    if (read_page) {
+      second_tier_hit = second_tier_ != nullptr && second_tier_->Take(page_id, page->GetData());
+      if (!second_tier_hit) {
+        disk_manager_->ReadPage(page_id, page->GetData());
+      }
+    }
+  } catch (...) {
+    // E.g. a page that fails its checksum. Don't leave the frame in-flight, or its waiters would hang.
+    lock->lock();
+    if (pending_page_id != INVALID_PAGE_ID) {
+      shard->write_back_pages_.erase(pending_page_id);
+    }
+    FailFrame(shard, page);
+    throw;
+  }
+
+  lock->lock();
+  if (pending_page_id != INVALID_PAGE_ID) {
+    shard->write_back_pages_.erase(pending_page_id);
+  }
+  page->io_in_progress_ = false;
+  shard->io_cv_.notify_all();
+  return second_tier_hit;
+}
+
+void BufferPoolManager::FailFrame(BufferPoolShard *shard, Page *page) {
+  shard->UnmapPage(page->page_id_);
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  page->io_in_progress_ = false;
+  UnpinFailedFrame(shard, page);
+  shard->io_cv_.notify_all();
+}
+
+void BufferPoolManager::RestoreVictim(BufferPoolShard *shard, Page *page, page_id_t victim_page_id) {
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  shard->UnmapPage(page->page_id_);
+  shard->MapPage(victim_page_id, frame_id);
+  shard->write_back_pages_.erase(victim_page_id);
+  page->page_id_ = victim_page_id;
+  page->is_dirty_ = true;
+  page->io_in_progress_ = false;
+  UnpinFailedFrame(shard, page);
+  shard->io_cv_.notify_all();
+}
+
+void BufferPoolManager::UnpinFailedFrame(BufferPoolShard *shard, Page *page) {
+  if (--page->pin_count_ > 0) {
+    return;
+  }
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  if (page->page_id_ != INVALID_PAGE_ID) {
+    // The frame holds its victim again, see RestoreVictim().
+    shard->replacer_->SetEvictable(shard->LocalFrameId(frame_id), true);
+    return;
+  }
+  // Hits on the frame while it was in-flight must not track it again once it is free.
+  ApplyAccessLog(shard);
+  shard->replacer_->SetEvictable(shard->LocalFrameId(frame_id), true);
+  shard->replacer_->Remove(shard->LocalFrameId(frame_id));
+  page->ResetMemory();
+  shard->PushFreeFrame(frame_id);
+}
+
+auto BufferPoolManager::NewPage(page_id_t *page_id) -> Page * {
   page_id_t new_page_id = AllocatePage();
+  auto &shard = GetShard(new_page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  page_id_t write_back_page_id;
+  page_id_t cache_page_id;
+  frame_id_t new_frame_id =
+      HasAvailableFrame(&shard) ? AcquireFrame(&shard, &write_back_page_id, &cache_page_id) : INVALID_FRAME_ID;
+  if (new_frame_id == INVALID_FRAME_ID) {
+    // Give the page back, so that a failed NewPage does not burn an id.
+    DeallocatePage(new_page_id);
+    shard.stats_.new_page_failures_++;
+    return nullptr;
+  }
+  shard.stats_.new_pages_++;
+  Page *page_ptr = &pages_[new_frame_id];
   *page_id = new_page_id;
   page_ptr->page_id_ = new_page_id;
-  page_table_[new_page_id] = new_frame_id;
-  page_ptr->pin_count_++;
-  replacer_->RecordAccess(new_frame_id);
-  replacer_->SetEvictable(new_frame_id, false);
+  page_ptr->io_in_progress_ = true;
+  shard.MapPage(new_page_id, new_frame_id);
+  // Trade the claim for our pin. Lock-free hits may pin the frame from now on, and see that it is in-flight.
+  page_ptr->pin_count_ = 1;
+  shard.replacer_->RecordAccess(shard.LocalFrameId(new_frame_id));
+  shard.replacer_->SetEvictable(shard.LocalFrameId(new_frame_id), false);
+  try {
+    FillFrame(&shard, &lock, page_ptr, write_back_page_id, cache_page_id, false);
+  } catch (...) {
+    DeallocatePage(new_page_id);
+    throw;
+  }
   return page_ptr;
 }
 
-auto BufferPoolManager::FetchPage(page_id_t page_id, [[maybe_unused]] AccessType access_type) -> Page * {
-  std::lock_guard<std::mutex> lock(latch_);
-  Page *page_ptr;
-  frame_id_t new_frame_id;
-  if (page_table_.find(page_id) != page_table_.end()) {
-    frame_id_t frame_id = page_table_[page_id];
+auto BufferPoolManager::FetchPage(page_id_t page_id, AccessType access_type) -> Page * {
+  auto &shard = GetShard(page_id);
+  if (Page *page_ptr = TryPinResident(&shard, page_id, access_type); page_ptr != nullptr) {
+    return page_ptr;
+  }
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  // If the page has just been evicted, its newest version may not have reached the disk yet.
+  shard.io_cv_.wait(lock, [&shard, page_id] { return shard.write_back_pages_.count(page_id) == 0; });
+  auto it = shard.page_table_.find(page_id);
+  if (it != shard.page_table_.end()) {
+    frame_id_t frame_id = it->second;
     Page *page_ptr = &pages_[frame_id];
     page_ptr->pin_count_++;
-    replacer_->SetEvictable(frame_id, false);
+    LogAccess(&shard, frame_id, access_type);
+    // The pin keeps the frame from being reused, so it still holds page_id once the load has finished, unless the load
+    // has failed. In that case try the read again ourselves, which will most likely throw as well.
+    WaitForIo(&shard, &lock, page_ptr);
+    if (page_ptr->page_id_ != page_id) {
+      UnpinFailedFrame(&shard, page_ptr);
+      lock.unlock();
+      return FetchPage(page_id, access_type);
+    }
     return page_ptr;
   }
-  if (free_list_.empty() && replacer_->Size() == 0) {
+  auto &access_stats = shard.stats_.Access(access_type);
+  if (!HasAvailableFrame(&shard)) {
+    access_stats.failures_++;
     return nullptr;
   }
-  if (!free_list_.empty()) {
-    new_frame_id = free_list_.front();
-    free_list_.pop_front();
-    page_ptr = &pages_[new_frame_id];
-  } else {
-    replacer_->Evict(&new_frame_id);
-    page_ptr = &pages_[new_frame_id];
-    page_id_t old_page_id = page_ptr->GetPageId();
-    if (page_ptr->IsDirty()) {
-      disk_manager_->WritePage(old_page_id, page_ptr->GetData());
-      page_ptr->is_dirty_ = false;
-    }
-    page_ptr->ResetMemory();
-    page_table_.erase(old_page_id);
+  auto start = std::chrono::steady_clock::now();
+  bool evicting = !shard.HasFreeFrame();
+  page_id_t write_back_page_id;
+  page_id_t cache_page_id;
+  frame_id_t new_frame_id = AcquireFrame(&shard, &write_back_page_id, &cache_page_id);
+  if (new_frame_id == INVALID_FRAME_ID) {
+    access_stats.failures_++;
+    return nullptr;
   }
+  access_stats.misses_++;
+  if (evicting) {
+    access_stats.evictions_++;
+  }
+  if (write_back_page_id != INVALID_PAGE_ID) {
+    access_stats.write_backs_++;
+  }
+  Page *page_ptr = &pages_[new_frame_id];
   page_ptr->page_id_ = page_id;
-  page_table_[page_id] = new_frame_id;
-  disk_manager_->ReadPage(page_id, page_ptr->GetData());
-  page_ptr->pin_count_++;
-  replacer_->RecordAccess(new_frame_id);
-  replacer_->SetEvictable(new_frame_id, false);
+  page_ptr->io_in_progress_ = true;
+  shard.MapPage(page_id, new_frame_id);
+  page_ptr->pin_count_ = 1;
+  shard.replacer_->RecordAccess(shard.LocalFrameId(new_frame_id), access_type);
+  shard.replacer_->SetEvictable(shard.LocalFrameId(new_frame_id), false);
+  if (FillFrame(&shard, &lock, page_ptr, write_back_page_id, cache_page_id, true)) {
+    access_stats.second_tier_hits_++;
+  }
+  access_stats.miss_latency_.Record(std::chrono::steady_clock::now() - start);
+  return page_ptr;
+}
+
+auto BufferPoolManager::TryPinResident(BufferPoolShard *shard, page_id_t page_id, AccessType access_type) -> Page * {
+  frame_id_t frame_id = shard->FindFrame(page_id);
+  if (frame_id == INVALID_FRAME_ID) {
+    return nullptr;
+  }
+  Page *page_ptr = &pages_[frame_id];
+  int pin_count = page_ptr->pin_count_.load();
+  do {
+    if (pin_count < 0) {
+      return nullptr;
+    }
+  } while (!page_ptr->pin_count_.compare_exchange_weak(pin_count, pin_count + 1));
+  // The pin keeps the frame from being claimed for another page, but the index may be stale: the frame may hold
+  // another page already, or be reading this one in, which only the slow path waits for.
+  if (page_ptr->page_id_ != page_id || page_ptr->io_in_progress_ || !shard->TryLogAccess(frame_id, access_type)) {
+    UnpinPage(page_ptr, false);
+    return nullptr;
+  }
   return page_ptr;
 }
 
 auto BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty, [[maybe_unused]] AccessType access_type) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
+  auto &shard = GetShard(page_id);
+  std::lock_guard<std::mutex> lock(shard.latch_);
+  auto it = shard.page_table_.find(page_id);
+  if (it == shard.page_table_.end()) {
     return false;
   }
-  Page *page_ptr = &pages_[page_table_[page_id]];
-  if (page_ptr->GetPinCount() <= 0) {
+  return UnpinPage(&pages_[it->second], is_dirty);
+}
+
+auto BufferPoolManager::UnpinPage(Page *page, bool is_dirty) -> bool {
+  int pin_count = page->GetPinCount();
+  if (pin_count <= 0) {
     return false;
   }
-  page_ptr->pin_count_--;
-  if (page_ptr->GetPinCount() == 0) {
-    replacer_->SetEvictable(page_table_[page_id], true);
+  // Mark the page dirty while it is still pinned, so that whoever evicts or flushes it sees the flag.
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+  while (!page->pin_count_.compare_exchange_weak(pin_count, pin_count - 1)) {
+    if (pin_count <= 0) {
+      return false;
+    }
   }
-  if (!page_ptr->is_dirty_) {
-    page_ptr->is_dirty_ = is_dirty;
+  if (pin_count > 1 || page->unpin_logged_.exchange(true)) {
+    return true;
   }
+  // The last pin is gone. The frame stays unevictable until the shard applies its unpin log. Without a pin the page
+  // can be deleted or replaced right now, so the shard is found from the frame rather than from page_id_.
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  auto &shard = GetFrameShard(frame_id);
+  shard.unpin_log_[shard.unpin_log_tail_++ % shard.num_frames_].store(frame_id);
   return true;
 }
 
 auto BufferPoolManager::FlushPage(page_id_t page_id) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  auto it = shard.page_table_.end();
+  // An earlier write of the page must not land after this one, or an older image would win.
+  shard.io_cv_.wait(lock, [&] {
+    it = shard.page_table_.find(page_id);
+    return it == shard.page_table_.end() ||
+           (!pages_[it->second].io_in_progress_ && !pages_[it->second].write_in_progress_);
+  });
+  if (it == shard.page_table_.end()) {
     return false;
   }
-  Page *page_ptr = &pages_[page_table_[page_id]];
-  disk_manager_->WritePage(page_id, page_ptr->GetData());
+  // Pin the frame so that it keeps holding the page while the write runs without the shard latch. A writer that
+  // modifies the page meanwhile marks it dirty again when it unpins it.
+  Page *page_ptr = &pages_[it->second];
+  page_ptr->pin_count_++;
+  shard.replacer_->SetEvictable(shard.LocalFrameId(it->second), false);
+  page_ptr->write_in_progress_ = true;
   page_ptr->is_dirty_ = false;
+  lock.unlock();
+
+  // Write a copy taken under the page's read latch. The disk manager checksums the bytes before it writes them, so it
+  // must not see a writer change them in between.
+  std::vector<char> buffer(BUSTUB_PAGE_SIZE);
+  page_ptr->RLatch();
+  memcpy(buffer.data(), page_ptr->GetData(), BUSTUB_PAGE_SIZE);
+  page_ptr->RUnlatch();
+  try {
+    disk_manager_->WritePage(page_id, buffer.data());
+  } catch (...) {
+    lock.lock();
+    page_ptr->is_dirty_ = true;
+    FinishWrite(&shard, page_ptr);
+    throw;
+  }
+  lock.lock();
+  FinishWrite(&shard, page_ptr);
   return true;
 }
 
 void BufferPoolManager::FlushAllPages() {
-  std::lock_guard<std::mutex> lock(latch_);
-  for (auto it : page_table_) {
-    Page *page_ptr = &pages_[it.first];
-    disk_manager_->WritePage(it.first, page_ptr->GetData());
-    page_ptr->is_dirty_ = false;
+  for (auto &shard : shards_) {
+    std::vector<page_id_t> page_ids;
+    {
+      std::lock_guard<std::mutex> lock(shard->latch_);
+      for (auto [page_id, frame_id] : shard->page_table_) {
+        page_ids.push_back(page_id);
+      }
+    }
+    // A page that has been evicted since was written back by the eviction.
+    for (auto page_id : page_ids) {
+      FlushPage(page_id);
+    }
   }
 }
 
+void BufferPoolManager::FinishWrite(BufferPoolShard *shard, Page *page) {
+  page->write_in_progress_ = false;
+  if (--page->pin_count_ == 0) {
+    shard->replacer_->SetEvictable(shard->LocalFrameId(static_cast<frame_id_t>(page - pages_)), true);
+  }
+  shard->io_cv_.notify_all();
+}
+
 auto BufferPoolManager::DeletePage(page_id_t page_id) -> bool {
-  std::lock_guard<std::mutex> lock(latch_);
-  if (page_table_.find(page_id) == page_table_.end()) {
+  auto &shard = GetShard(page_id);
+  std::unique_lock<std::mutex> lock(shard.latch_);
+  // A write that lands after the page has been freed could overwrite the page's next incarnation.
+  auto it = shard.page_table_.end();
+  shard.io_cv_.wait(lock, [&] {
+    it = shard.page_table_.find(page_id);
+    return shard.write_back_pages_.count(page_id) == 0 &&
+           (it == shard.page_table_.end() || !pages_[it->second].write_in_progress_);
+  });
+  if (it == shard.page_table_.end()) {
+    // The page id may be handed out again, so its old copy must not be found by the next incarnation.
+    if (second_tier_ != nullptr) {
+      second_tier_->Erase(page_id);
+    }
+    DeallocatePage(page_id);
     return true;
   }
-  frame_id_t frame_id = page_table_[page_id];
+  frame_id_t frame_id = it->second;
   Page *page_ptr = &pages_[frame_id];
-  if (page_ptr->GetPinCount() > 0) {
+  if (!ClaimFrame(page_ptr)) {
     return false;
   }
-  page_table_.erase(page_id);
-  replacer_->Remove(frame_id);
-  free_list_.push_back(frame_id);
+  // A buffered hit must not track the frame again once it is free. The last unpin may not have reached the unpin log
+  // yet, though, so the frame may still look pinned to the replacer.
+  ApplyAccessLog(&shard);
+  shard.UnmapPage(page_id);
+  shard.replacer_->SetEvictable(shard.LocalFrameId(frame_id), true);
+  shard.replacer_->Remove(shard.LocalFrameId(frame_id));
+  shard.PushFreeFrame(frame_id);
   page_ptr->ResetMemory();
-  page_ptr->pin_count_ = 0;
   page_ptr->is_dirty_ = false;
   page_ptr->page_id_ = INVALID_PAGE_ID;
+  page_ptr->pin_count_ = 0;
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManager::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManager::Prefetch(const std::vector<page_id_t> &page_ids) {
+  {
+    std::lock_guard<std::mutex> lock(prefetch_latch_);
+    if (!prefetch_thread_.joinable()) {
+      prefetch_thread_ = std::thread(&BufferPoolManager::PrefetchLoop, this);
+    }
+    // Prefetching is only a hint: when the I/O thread falls behind, drop the requests that don't fit in the pool.
+    for (auto page_id : page_ids) {
+      if (prefetch_queue_.size() >= pool_size_) {
+        break;
+      }
+      prefetch_queue_.push_back(page_id);
+    }
+  }
+  prefetch_cv_.notify_one();
+}
+
+auto BufferPoolManager::IsPageResident(page_id_t page_id) -> bool {
+  auto &shard = GetShard(page_id);
+  std::lock_guard<std::mutex> lock(shard.latch_);
+  auto it = shard.page_table_.find(page_id);
+  return it != shard.page_table_.end() && !pages_[it->second].io_in_progress_;
+}
+
+auto BufferPoolManager::GetStats() -> BufferPoolStats {
+  BufferPoolStats stats;
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->latch_);
+    // Count the hits that are still in the access log.
+    ApplyAccessLog(shard.get());
+    stats += shard->stats_;
+  }
+  stats.foreground_writes_ = foreground_write_cnt_;
+  stats.background_writes_ = background_write_cnt_;
+  if (second_tier_ != nullptr) {
+    stats.second_tier_ = second_tier_->GetStats();
+  }
+  return stats;
+}
+
+auto BufferPoolManager::GetFrameNode(frame_id_t frame_id) -> size_t {
+  for (auto &shard : shards_) {
+    if (frame_id < shard->frame_offset_ + static_cast<frame_id_t>(shard->num_frames_)) {
+      return shard->PartitionOf(frame_id);
+    }
+  }
+  return 0;
+}
+
+auto BufferPoolManager::GetLatchStats() -> std::vector<std::pair<page_id_t, LatchStats>> {
+  std::vector<std::pair<page_id_t, LatchStats>> stats;
+  stats.reserve(pool_size_);
+  for (auto &shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->latch_);
+    for (size_t i = 0; i < shard->num_frames_; i++) {
+      Page &page = pages_[shard->frame_offset_ + i];
+      stats.emplace_back(page.page_id_, page.GetLatchStats());
+    }
+  }
+  return stats;
+}
+
+void BufferPoolManager::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+    if (prefetch_stop_) {
+      return;
+    }
+    std::vector<page_id_t> page_ids(prefetch_queue_.begin(), prefetch_queue_.end());
+    prefetch_queue_.clear();
+    lock.unlock();
+    PrefetchPages(page_ids);
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::SubmitRequests(std::vector<DiskRequest> requests) {
+  try {
+    disk_manager_->Submit(std::move(requests));
+  } catch (...) {
+    // Reported through the futures of the requests.
+  }
+}
+
+void BufferPoolManager::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  struct PrefetchFrame {
+    BufferPoolShard *shard_;
+    Page *page_;
+    page_id_t write_back_page_id_;
+    page_id_t cache_page_id_;
+  };
+  std::vector<PrefetchFrame> frames;
+  for (auto page_id : page_ids) {
+    auto &shard = GetShard(page_id);
+    std::lock_guard<std::mutex> lock(shard.latch_);
+    // A page may have been deleted since it was asked for. Loading it would bring it back under an id that NewPage()
+    // can hand out again, so freed pages are skipped. DeletePage() frees pages under the shard latch.
+    if (shard.page_table_.count(page_id) > 0 || shard.write_back_pages_.count(page_id) > 0 ||
+        !HasAvailableFrame(&shard) || !disk_manager_->IsPageAllocated(page_id)) {
+      continue;
+    }
+    page_id_t write_back_page_id;
+    page_id_t cache_page_id;
+    frame_id_t new_frame_id = AcquireFrame(&shard, &write_back_page_id, &cache_page_id);
+    if (new_frame_id == INVALID_FRAME_ID) {
+      continue;
+    }
+    Page *page_ptr = &pages_[new_frame_id];
+    page_ptr->page_id_ = page_id;
+    page_ptr->io_in_progress_ = true;
+    shard.MapPage(page_id, new_frame_id);
+    // Pin the frame while it is filled, like FetchPage() does, and leave it evictable afterwards.
+    page_ptr->pin_count_ = 1;
+    shard.replacer_->RecordPrefetch(shard.LocalFrameId(new_frame_id));
+    shard.replacer_->SetEvictable(shard.LocalFrameId(new_frame_id), false);
+    frames.push_back({&shard, page_ptr, write_back_page_id, cache_page_id});
+  }
+  if (frames.empty()) {
+    return;
+  }
+
+  // The frames are overwritten by the reads, so the dirty victims have to reach the disk first. A frame whose victim
+  // can't be written back holds on to the victim, a frame whose read fails is dropped: prefetching is only a hint.
+  std::vector<bool> write_back_failed(frames.size(), false);
+  std::vector<bool> failed(frames.size(), false);
+  std::vector<DiskRequest> write_backs;
+  std::vector<std::pair<size_t, std::future<void>>> futures;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (frames[i].write_back_page_id_ != INVALID_PAGE_ID) {
+      write_backs.push_back(DiskRequest{true, frames[i].write_back_page_id_, frames[i].page_->GetData(), 1, {}});
+      futures.emplace_back(i, write_backs.back().callback_.get_future());
+    }
+  }
+  if (!write_backs.empty()) {
+    foreground_write_cnt_ += write_backs.size();
+    SubmitRequests(std::move(write_backs));
+  }
+  // Any error fails the frame, e.g. a std::system_error of the I/O backend or a broken promise, and not only the
+  // disk manager's own exceptions. Letting one escape would leave the frames in-flight and their waiters hanging.
+  for (auto &[i, future] : futures) {
+    try {
+      future.get();
+    } catch (const std::exception &) {
+      write_back_failed[i] = true;
+    }
+  }
+  futures.clear();
+  std::vector<DiskRequest> reads;
+  for (size_t i = 0; i < frames.size(); i++) {
+    if (write_back_failed[i]) {
+      continue;
+    }
+    Page *page_ptr = frames[i].page_;
+    bool second_tier_hit = false;
+    try {
+      if (frames[i].cache_page_id_ != INVALID_PAGE_ID) {
+        second_tier_->Insert(frames[i].cache_page_id_, page_ptr->GetData());
+      }
+      page_ptr->ResetMemory();
+      second_tier_hit = second_tier_ != nullptr && second_tier_->Take(page_ptr->page_id_, page_ptr->GetData());
+    } catch (...) {
+      // E.g. std::bad_alloc while compressing. The victim is clean by now, so only its second tier copy is lost, as in
+      // FillFrame().
+      failed[i] = true;
+      continue;
+    }
+    if (!second_tier_hit) {
+      reads.push_back(DiskRequest{false, page_ptr->page_id_, page_ptr->GetData(), 1, {}});
+      futures.emplace_back(i, reads.back().callback_.get_future());
+    }
+  }
+  if (!reads.empty()) {
+    SubmitRequests(std::move(reads));
+  }
+  for (auto &[i, future] : futures) {
+    try {
+      future.get();
+    } catch (const std::exception &) {
+      failed[i] = true;
+    }
+  }
+
+  for (size_t i = 0; i < frames.size(); i++) {
+    auto *shard = frames[i].shard_;
+    Page *page_ptr = frames[i].page_;
+    std::lock_guard<std::mutex> lock(shard->latch_);
+    if (write_back_failed[i]) {
+      RestoreVictim(shard, page_ptr, frames[i].write_back_page_id_);
+      continue;
+    }
+    shard->write_back_pages_.erase(frames[i].write_back_page_id_);
+    shard->write_back_pages_.erase(frames[i].cache_page_id_);
+    if (failed[i]) {
+      FailFrame(shard, page_ptr);
+      continue;
+    }
+    page_ptr->io_in_progress_ = false;
+    shard->io_cv_.notify_all();
+    if (--page_ptr->pin_count_ == 0) {
+      shard->replacer_->SetEvictable(shard->LocalFrameId(shard->page_table_[page_ptr->page_id_]), true);
+    }
+  }
+}
+
+void BufferPoolManager::StartBackgroundFlusher(double clean_share, std::chrono::milliseconds interval) {
+  BUSTUB_ENSURE(clean_share > 0 && clean_share <= 1, "clean share must be in (0, 1]");
+  std::lock_guard<std::mutex> lock(flusher_latch_);
+  if (flusher_thread_.joinable()) {
+    return;
+  }
+  flusher_stop_ = false;
+  flusher_thread_ = std::thread(&BufferPoolManager::FlusherLoop, this, clean_share, interval);
+}
+
+void BufferPoolManager::StopBackgroundFlusher() {
+  std::thread flusher_thread;
+  {
+    std::lock_guard<std::mutex> lock(flusher_latch_);
+    flusher_stop_ = true;
+    flusher_thread = std::move(flusher_thread_);
+  }
+  flusher_cv_.notify_all();
+  if (flusher_thread.joinable()) {
+    flusher_thread.join();
+  }
+}
 
-auto BufferPoolManager::FetchPageBasic(page_id_t page_id) -> BasicPageGuard {
-  auto page_ptr = FetchPage(page_id);
+void BufferPoolManager::FlusherLoop(double clean_share, std::chrono::milliseconds interval) {
+  std::unique_lock<std::mutex> lock(flusher_latch_);
+  while (!flusher_cv_.wait_for(lock, interval, [this] { return flusher_stop_; })) {
+    lock.unlock();
+    for (auto &shard : shards_) {
+      CleanShard(shard.get(), static_cast<size_t>(clean_share * shard->num_frames_ + 0.5));
+    }
+    lock.lock();
+  }
+}
+
+void BufferPoolManager::CleanShard(BufferPoolShard *shard, size_t max_frames) {
+  // Pin the dirty candidates and mark them clean under the shard latch. A writer that modifies one of them from now on
+  // marks it dirty again when it unpins it, and a FlushPage() of it waits for this write, so no update can be lost.
+  std::vector<std::pair<page_id_t, Page *>> dirty_pages;
+  {
+    std::lock_guard<std::mutex> lock(shard->latch_);
+    ApplyAccessLog(shard);
+    for (auto local_frame_id : shard->replacer_->EvictionCandidates(max_frames)) {
+      Page *page_ptr = &pages_[shard->frame_offset_ + local_frame_id];
+      if (!page_ptr->is_dirty_ || page_ptr->write_in_progress_) {
+        continue;
+      }
+      page_ptr->pin_count_++;
+      page_ptr->is_dirty_ = false;
+      page_ptr->write_in_progress_ = true;
+      shard->replacer_->SetEvictable(local_frame_id, false);
+      dirty_pages.emplace_back(page_ptr->page_id_, page_ptr);
+    }
+  }
+  if (dirty_pages.empty()) {
+    return;
+  }
+
+  // Write runs of adjacent page ids with one I/O each.
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+  std::vector<char> buffer(dirty_pages.size() * BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < dirty_pages.size(); i++) {
+    Page *page_ptr = dirty_pages[i].second;
+    page_ptr->RLatch();
+    memcpy(buffer.data() + i * BUSTUB_PAGE_SIZE, page_ptr->GetData(), BUSTUB_PAGE_SIZE);
+    page_ptr->RUnlatch();
+  }
+  std::vector<DiskRequest> requests;
+  std::vector<std::pair<size_t, size_t>> runs;
+  std::vector<std::future<void>> futures;
+  for (size_t run_begin = 0, run_end; run_begin < dirty_pages.size(); run_begin = run_end) {
+    run_end = run_begin + 1;
+    while (run_end < dirty_pages.size() && dirty_pages[run_end].first == dirty_pages[run_end - 1].first + 1) {
+      run_end++;
+    }
+    requests.push_back(DiskRequest{true, dirty_pages[run_begin].first, buffer.data() + run_begin * BUSTUB_PAGE_SIZE,
+                                   run_end - run_begin, {}});
+    runs.emplace_back(run_begin, run_end);
+    futures.push_back(requests.back().callback_.get_future());
+  }
+  SubmitRequests(std::move(requests));
+  // The pages of a run that failed (e.g. the disk is full, or Submit() threw) stay dirty, so that eviction tries them
+  // again.
+  std::vector<bool> failed(dirty_pages.size(), false);
+  for (size_t i = 0; i < futures.size(); i++) {
+    try {
+      futures[i].get();
+    } catch (...) {
+      std::fill(failed.begin() + runs[i].first, failed.begin() + runs[i].second, true);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(shard->latch_);
+  for (size_t i = 0; i < dirty_pages.size(); i++) {
+    Page *page_ptr = dirty_pages[i].second;
+    if (failed[i]) {
+      page_ptr->is_dirty_ = true;
+    } else {
+      background_write_cnt_++;
+    }
+    FinishWrite(shard, page_ptr);
+  }
+}
+
+auto BufferPoolManager::FetchPageBasic(page_id_t page_id, AccessType access_type) -> BasicPageGuard {
+  auto page_ptr = FetchPage(page_id, access_type);
   return {this, page_ptr};
 }
 
-auto BufferPoolManager::FetchPageRead(page_id_t page_id) -> ReadPageGuard {
-  auto page_ptr = FetchPage(page_id);
+auto BufferPoolManager::FetchPageRead(page_id_t page_id, AccessType access_type) -> ReadPageGuard {
+  auto page_ptr = FetchPage(page_id, access_type);
   page_ptr->RLatch();
   return ReadPageGuard{this, page_ptr};
 }
 
-auto BufferPoolManager::FetchPageWrite(page_id_t page_id) -> WritePageGuard {
-  auto page_ptr = FetchPage(page_id);
+auto BufferPoolManager::FetchPageWrite(page_id_t page_id, AccessType access_type) -> WritePageGuard {
+  auto page_ptr = FetchPage(page_id, access_type);
   page_ptr->WLatch();
   return WritePageGuard{this, page_ptr};
 }
 
+auto BufferPoolManager::FetchPageOptimistic(page_id_t page_id, AccessType access_type) -> OptimisticPageGuard {
+  auto &shard = GetShard(page_id);
+  if (frame_id_t frame_id = shard.FindFrame(page_id); frame_id != INVALID_FRAME_ID) {
+    // The index may be stale. The frame is only taken if it holds the page with its data in place as of the version,
+    // since a frame is bumped to a new version before it gets another page or its data is read in.
+    Page *page_ptr = &pages_[frame_id];
+    uint64_t version = page_ptr->GetVersion();
+    if (page_ptr->page_id_ == page_id && !page_ptr->io_in_progress_ && shard.TryLogAccess(frame_id, access_type)) {
+      return OptimisticPageGuard{page_ptr, page_id, version};
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(shard.latch_);
+    auto it = shard.page_table_.find(page_id);
+    if (it != shard.page_table_.end() && !pages_[it->second].io_in_progress_) {
+      Page *page_ptr = &pages_[it->second];
+      LogAccess(&shard, it->second, access_type);
+      return OptimisticPageGuard{page_ptr, page_id, page_ptr->GetVersion()};
+    }
+  }
+  // Read the page in, then let go of it right away. It may well be evicted again before the caller gets to read it,
+  // which Validate() will then report.
+  auto page_ptr = FetchPage(page_id, access_type);
+  if (page_ptr == nullptr) {
+    return OptimisticPageGuard{};
+  }
+  OptimisticPageGuard guard{page_ptr, page_id, page_ptr->GetVersion()};
+  UnpinPage(page_id, false, access_type);
+  return guard;
+}
+
 auto BufferPoolManager::NewPageGuarded(page_id_t *page_id) -> BasicPageGuard {
   auto page_ptr = NewPage(page_id);
   if (page_id == nullptr) {
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.cpp
+//
+// Identification: src/buffer/buffer_pool_stats.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_stats.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace bustub {
+
+auto AccessTypeToString(AccessType access_type) -> std::string {
+  switch (access_type) {
+    case AccessType::Unknown:
+      return "unknown";
+    case AccessType::Get:
+      return "get";
+    case AccessType::Scan:
+      return "scan";
+  }
+  return "invalid";
+}
+
+void LatencyHistogram::Record(std::chrono::nanoseconds latency) {
+  auto micros = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)) / 1000;
+  size_t bucket = 0;
+  while (bucket < NUM_BUCKETS - 1 && micros >= BucketUpperBound(bucket)) {
+    bucket++;
+  }
+  buckets_[bucket]++;
+}
+
+auto LatencyHistogram::Count() const -> uint64_t {
+  uint64_t count = 0;
+  for (auto bucket_count : buckets_) {
+    count += bucket_count;
+  }
+  return count;
+}
+
+auto LatencyHistogram::Percentile(double percentile) const -> uint64_t {
+  uint64_t count = Count();
+  if (count == 0) {
+    return 0;
+  }
+  // The rank of the latency we are looking for, counting from 1.
+  auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(percentile / 100 * count)), 1);
+  uint64_t seen = 0;
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+    seen += buckets_[bucket];
+    if (seen >= rank) {
+      return BucketUpperBound(bucket);
+    }
+  }
+  return BucketUpperBound(NUM_BUCKETS - 1);
+}
+
+auto LatencyHistogram::operator+=(const LatencyHistogram &other) -> LatencyHistogram & {
+  for (size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+    buckets_[bucket] += other.buckets_[bucket];
+  }
+  return *this;
+}
+
+auto BufferPoolStats::AccessStats::operator+=(const AccessStats &other) -> AccessStats & {
+  hits_ += other.hits_;
+  misses_ += other.misses_;
+  second_tier_hits_ += other.second_tier_hits_;
+  evictions_ += other.evictions_;
+  write_backs_ += other.write_backs_;
+  failures_ += other.failures_;
+  miss_latency_ += other.miss_latency_;
+  return *this;
+}
+
+auto BufferPoolStats::AllAccesses() const -> AccessStats {
+  AccessStats all;
+  for (const auto &access_stats : accesses_) {
+    all += access_stats;
+  }
+  return all;
+}
+
+auto BufferPoolStats::operator+=(const BufferPoolStats &other) -> BufferPoolStats & {
+  for (size_t i = 0; i < NUM_ACCESS_TYPES; i++) {
+    accesses_[i] += other.accesses_[i];
+  }
+  new_pages_ += other.new_pages_;
+  new_page_failures_ += other.new_page_failures_;
+  evictions_ += other.evictions_;
+  foreground_writes_ += other.foreground_writes_;
+  background_writes_ += other.background_writes_;
+  local_frames_ += other.local_frames_;
+  remote_frames_ += other.remote_frames_;
+  return *this;
+}
+
+}  // namespace bustub
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <iterator>
+#include <utility>
+
+#include "common/util/compression_util.h"
+
+namespace bustub {
+
+CompressedPageCache::CompressedPageCache(size_t budget_bytes) { stats_.budget_bytes_ = budget_bytes; }
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *data) {
+  // Compress outside the latch. A page that does not shrink by a quarter is not worth a slot.
+  std::vector<char> compressed(BUSTUB_PAGE_SIZE * 3 / 4);
+  size_t size = CompressionUtil::Lz4Compress(data, BUSTUB_PAGE_SIZE, compressed.data(), compressed.size());
+  compressed.resize(size);
+  compressed.shrink_to_fit();
+
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    EraseEntry(it);
+  }
+  if (size == 0 || size > stats_.budget_bytes_) {
+    stats_.rejects_++;
+    return;
+  }
+  while (stats_.used_bytes_ + size > stats_.budget_bytes_) {
+    EraseEntry(entries_.find(lru_list_.front()));
+    stats_.evictions_++;
+  }
+  lru_list_.push_back(page_id);
+  entries_.emplace(page_id, Entry{std::move(compressed), std::prev(lru_list_.end())});
+  stats_.used_bytes_ += size;
+  stats_.inserts_++;
+}
+
+auto CompressedPageCache::Take(page_id_t page_id, char *data) -> bool {
+  std::vector<char> compressed;
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) {
+      stats_.misses_++;
+      return false;
+    }
+    compressed = EraseEntry(it);
+    stats_.hits_++;
+  }
+  bool decompressed = CompressionUtil::Lz4Decompress(compressed.data(), compressed.size(), data, BUSTUB_PAGE_SIZE);
+  BUSTUB_ENSURE(decompressed, "compressed page cache is corrupted");
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    EraseEntry(it);
+  }
+}
+
+auto CompressedPageCache::GetStats() -> SecondTierStats {
+  std::lock_guard<std::mutex> lock(latch_);
+  SecondTierStats stats = stats_;
+  stats.pages_ = entries_.size();
+  return stats;
+}
+
+auto CompressedPageCache::EraseEntry(std::unordered_map<page_id_t, Entry>::iterator it) -> std::vector<char> {
+  std::vector<char> data = std::move(it->second.data_);
+  stats_.used_bytes_ -= data.size();
+  lru_list_.erase(it->second.lru_it_);
+  entries_.erase(it);
+  return data;
+}
+
+}  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sanitizer/asan_interface.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdint>
+
+#include "common/exception.h"
+#include "common/util/numa_util.h"
+
+namespace bustub {
+
+#if defined(__SANITIZE_ADDRESS__)
+#define BUSTUB_ASAN 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define BUSTUB_ASAN 1
+#endif
+#endif
+
+/** The distance between two frames, with room for a poisoned gap after each frame under AddressSanitizer. */
+#ifdef BUSTUB_ASAN
+static constexpr size_t FRAME_STRIDE = 2 * BUSTUB_PAGE_SIZE;
+#else
+static constexpr size_t FRAME_STRIDE = BUSTUB_PAGE_SIZE;
+#endif
+
+FrameArena::FrameArena(size_t frame_cnt) {
+  size_t size = frame_cnt * FRAME_STRIDE;
+  if (size >= HUGE_PAGE_SIZE) {
+    size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+    if (base != MAP_FAILED) {
+      base_ = static_cast<char *>(base);
+      huge_pages_ = true;
+    } else {
+      // No huge pages reserved. Map 2 MB more than needed and trim the mapping to a 2 MB boundary, which transparent
+      // huge pages require.
+      base = mmap(nullptr, size_ + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base == MAP_FAILED) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate the buffer pool");
+      }
+      auto address = reinterpret_cast<uintptr_t>(base);
+      size_t head = (HUGE_PAGE_SIZE - address % HUGE_PAGE_SIZE) % HUGE_PAGE_SIZE;
+      if (head > 0) {
+        munmap(base, head);
+      }
+      munmap(static_cast<char *>(base) + head + size_, HUGE_PAGE_SIZE - head);
+      base_ = static_cast<char *>(base) + head;
+#ifdef MADV_HUGEPAGE
+      madvise(base_, size_, MADV_HUGEPAGE);
+#endif
+    }
+  } else if (size > 0) {
+    size_ = size;
+    void *base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate the buffer pool");
+    }
+    base_ = static_cast<char *>(base);
+  }
+#ifdef BUSTUB_ASAN
+  for (size_t i = 0; i < frame_cnt; i++) {
+    ASAN_POISON_MEMORY_REGION(GetFrame(i) + BUSTUB_PAGE_SIZE, FRAME_STRIDE - BUSTUB_PAGE_SIZE);
+  }
+#endif
+}
+
+FrameArena::~FrameArena() {
+  if (base_ != nullptr) {
+    // The shadow memory outlives the mapping, and the address range may be mapped again for something else.
+    ASAN_UNPOISON_MEMORY_REGION(base_, size_);
+    munmap(base_, size_);
+  }
+}
+
+auto FrameArena::GetFrame(size_t frame_id) -> char * { return base_ + frame_id * FRAME_STRIDE; }
+
+auto FrameArena::BindFrames(size_t first_frame, size_t frame_cnt, size_t node) -> bool {
+  size_t begin = first_frame * FRAME_STRIDE;
+  size_t end = std::min((first_frame + frame_cnt) * FRAME_STRIDE, size_);
+  if (begin >= end) {
+    return false;
+  }
+  return NumaUtil::BindMemory(base_ + begin, end - begin, node);
+}
+
+auto FrameArena::InterleaveFrames() -> bool { return base_ != nullptr && NumaUtil::InterleaveMemory(base_, size_); }
+
+}  // namespace bustub
@@ -11,138 +11,218 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/lru_k_replacer.h"
-#include <algorithm>
-#include <iterator>
-#include <memory>
-#include <type_traits>
+
+#include <queue>
 #include <utility>
+
 #include "common/config.h"
 #include "common/exception.h"
 
 namespace bustub {
 
-LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k) : replacer_size_(num_frames), k_(k) {}
+LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
+    : replacer_size_(num_frames),
+      k_(k),
+      history_(num_frames * k),
+      access_count_(num_frames, 0),
+      history_pos_(num_frames, 0),
+      scan_only_(num_frames, false),
+      prefetched_(num_frames, false),
+      heap_pos_(num_frames, INVALID_HEAP_POS) {
+  BUSTUB_ENSURE(k_ > 0, "k must be positive");
+  heap_.reserve(num_frames);
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::lock_guard<std::mutex> lock(latch_);
-  if (evictable_size_ == 0) {
+  if (heap_.empty()) {
     return false;
   }
-  for (auto temp_it : temp_pool_) {
-    if (!node_store_[temp_it]->GetEvictable()) {
-      continue;
-    }
-    *frame_id = temp_it;
-    temp_pool_.erase(temp_pool_map_[temp_it]);
-    temp_pool_map_.erase(temp_it);
-    node_store_[temp_it].reset();
-    node_store_.erase(temp_it);
-    evictable_size_--;
-    return true;
-  }
-  for (auto it = cache_pool_.begin(); it != cache_pool_.end(); it++) {
-    auto cache_it = *it;
-    if (!node_store_[cache_it.first]->GetEvictable()) {
-      continue;
-    }
-    *frame_id = cache_it.first;
-    cache_pool_.erase(cache_pool_map_[cache_it.first]);
-    cache_pool_map_.erase(cache_it.first);
-    node_store_[cache_it.first].reset();
-    node_store_.erase(cache_it.first);
-    evictable_size_--;
-    return true;
-  }
-  return false;
+  *frame_id = heap_.front();
+  HeapErase(*frame_id);
+  access_count_[*frame_id] = 0;
+  history_pos_[*frame_id] = 0;
+  scan_only_[*frame_id] = false;
+  prefetched_[*frame_id] = false;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id, [[maybe_unused]] AccessType access_type) {
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, AccessType access_type) {
   std::lock_guard<std::mutex> lock(latch_);
-  BUSTUB_ENSURE(static_cast<size_t>(frame_id) <= replacer_size_, "frame id is invalid(larger than replacer_size_)");
-  ++current_timestamp_;
-  auto it = node_store_.find(frame_id);
-  // 不存在页面，创建并加入到temp_pool中
-  if (it == node_store_.end()) {
-    auto newnode = std::make_shared<LRUKNode>(k_, frame_id);
-    node_store_[frame_id] = newnode;
-    newnode->PushFront(current_timestamp_);
-    temp_pool_.push_back(frame_id);
-    temp_pool_map_[frame_id] = std::prev(temp_pool_.end());
-    return;
+  CheckFrameId(frame_id);
+  if (prefetched_[frame_id]) {
+    prefetched_[frame_id] = false;
+    access_count_[frame_id] = 0;
+    history_pos_[frame_id] = 0;
   }
-  // 更新访问
-  it->second->PushFront(current_timestamp_);
-  auto backk = it->second->BackK();
-
-  auto temp_it = temp_pool_map_.find(frame_id);
-  auto cache_it = cache_pool_map_.find(frame_id);
-  // 页面在temp_pool中
-  if (temp_it != temp_pool_map_.end()) {
-    // 若访问次数少于k次，则只更新访问记录，无需调整排序
-    // 若访问次数等于或大于k次(backk 不为 0)，从temp_pool删除并加入到cache_pool中
-    if (backk != 0) {
-      temp_pool_.erase(temp_it->second);
-      temp_pool_map_.erase(temp_it);
-      auto new_pair = std::make_pair(frame_id, backk);
-      auto insert_pos = std::upper_bound(cache_pool_.begin(), cache_pool_.end(), new_pair,
-                                         [](const std::pair<frame_id_t, size_t> &a,
-                                            const std::pair<frame_id_t, size_t> &b) { return a.second < b.second; });
-      auto insert_it = cache_pool_.insert(insert_pos, new_pair);
-      cache_pool_map_[new_pair.first] = insert_it;
+  if (access_type == AccessType::Scan) {
+    if (access_count_[frame_id] > 0 && !scan_only_[frame_id]) {
+      return;
     }
-  } else {
-    // 页面在cache_pool中，先把cache_pool中原来的删除，然后再插入cache中合适的位置，使得list从小到大排序
-    cache_pool_.erase(cache_it->second);
-    cache_pool_map_.erase(cache_it);
-    auto new_pair = std::make_pair(frame_id, backk);
-    auto insert_pos = std::upper_bound(cache_pool_.begin(), cache_pool_.end(), new_pair,
-                                       [](const std::pair<frame_id_t, size_t> &a,
-                                          const std::pair<frame_id_t, size_t> &b) { return a.second < b.second; });
-    auto insert_it = cache_pool_.insert(insert_pos, new_pair);
-    cache_pool_map_[new_pair.first] = insert_it;
+    scan_only_[frame_id] = true;
+  } else if (scan_only_[frame_id]) {
+    // The first non-scan access starts a fresh history, so that earlier scans don't count towards k.
+    scan_only_[frame_id] = false;
+    access_count_[frame_id] = 0;
+    history_pos_[frame_id] = 0;
+  }
+  ++current_timestamp_;
+  history_[frame_id * k_ + history_pos_[frame_id]] = current_timestamp_;
+  history_pos_[frame_id] = (history_pos_[frame_id] + 1) % k_;
+  if (access_count_[frame_id] < k_) {
+    access_count_[frame_id]++;
+  }
+  // The new access pushes the frame back in the eviction order, unless it turned a prefetched frame into a scan-only
+  // frame.
+  if (heap_pos_[frame_id] != INVALID_HEAP_POS) {
+    SiftUp(heap_pos_[frame_id]);
+    SiftDown(heap_pos_[frame_id]);
   }
 }
 
+void LRUKReplacer::RecordPrefetch(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  CheckFrameId(frame_id);
+  BUSTUB_ENSURE(access_count_[frame_id] == 0, "RecordPrefetch is called on a tracked frame");
+  history_[frame_id * k_] = ++current_timestamp_;
+  history_pos_[frame_id] = 1 % k_;
+  access_count_[frame_id] = 1;
+  prefetched_[frame_id] = true;
+}
+
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   std::lock_guard<std::mutex> lock(latch_);
-  BUSTUB_ENSURE(static_cast<size_t>(frame_id) <= replacer_size_, "frame id is invalid(larger than replacer_size_)");
-  auto frame_it = node_store_.find(frame_id);
-  if (frame_it == node_store_.end()) {
+  CheckFrameId(frame_id);
+  if (access_count_[frame_id] == 0) {
     return;
   }
-  auto frame_ptr = frame_it->second;
-  if (frame_ptr->GetEvictable() && !set_evictable) {
-    frame_ptr->SetEvictable(set_evictable);
-    evictable_size_--;
-  } else if (!frame_ptr->GetEvictable() && set_evictable) {
-    frame_ptr->SetEvictable(set_evictable);
-    evictable_size_++;
+  bool is_evictable = heap_pos_[frame_id] != INVALID_HEAP_POS;
+  if (is_evictable && !set_evictable) {
+    HeapErase(frame_id);
+  } else if (!is_evictable && set_evictable) {
+    HeapPush(frame_id);
   }
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   std::lock_guard<std::mutex> lock(latch_);
-  auto frame_it = node_store_.find(frame_id);
-  if (frame_it == node_store_.end()) {
+  CheckFrameId(frame_id);
+  if (access_count_[frame_id] == 0) {
     return;
   }
-  auto frame_ptr = frame_it->second;
-  BUSTUB_ENSURE(frame_ptr->GetEvictable() == true, "Remove is called on a non-evictable frame");
-  auto temp_it = temp_pool_map_.find(frame_id);
-  if (temp_it != temp_pool_map_.end()) {
-    temp_pool_.erase(temp_it->second);
-    temp_pool_map_.erase(temp_it);
+  BUSTUB_ENSURE(heap_pos_[frame_id] != INVALID_HEAP_POS, "Remove is called on a non-evictable frame");
+  HeapErase(frame_id);
+  access_count_[frame_id] = 0;
+  history_pos_[frame_id] = 0;
+  scan_only_[frame_id] = false;
+  prefetched_[frame_id] = false;
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return heap_.size();
+}
+
+auto LRUKReplacer::EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::lock_guard<std::mutex> lock(latch_);
+  // Best-first walk of the heap: the next candidate is always the best frame among the children of the frames taken.
+  auto worse = [this](size_t a, size_t b) { return EvictsBefore(heap_[b], heap_[a]); };
+  std::priority_queue<size_t, std::vector<size_t>, decltype(worse)> frontier(worse);
+  std::vector<frame_id_t> candidates;
+  if (!heap_.empty()) {
+    frontier.push(0);
+  }
+  while (!frontier.empty() && candidates.size() < max_frames) {
+    size_t pos = frontier.top();
+    frontier.pop();
+    candidates.push_back(heap_[pos]);
+    for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); child++) {
+      frontier.push(child);
+    }
+  }
+  return candidates;
+}
+
+void LRUKReplacer::CheckFrameId(frame_id_t frame_id) const {
+  BUSTUB_ENSURE(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_,
+                "frame id is invalid(larger than replacer_size_)");
+}
+
+auto LRUKReplacer::EvictsBefore(frame_id_t lhs, frame_id_t rhs) const -> bool {
+  // Scan-only frames go first. Then frames with less than k accesses, which have +inf backward k-distance, and finally
+  // the others. Within each class, EvictionTimestamp() decides.
+  auto eviction_class = [this](frame_id_t frame_id) {
+    if (scan_only_[frame_id]) {
+      return 0;
+    }
+    return access_count_[frame_id] < k_ ? 1 : 2;
+  };
+  int lhs_class = eviction_class(lhs);
+  int rhs_class = eviction_class(rhs);
+  if (lhs_class != rhs_class) {
+    return lhs_class < rhs_class;
   }
-  auto cache_it = cache_pool_map_.find(frame_id);
-  if (cache_it != cache_pool_map_.end()) {
-    cache_pool_.erase(cache_it->second);
-    cache_pool_map_.erase(cache_it);
+  return EvictionTimestamp(lhs) < EvictionTimestamp(rhs);
+}
+
+auto LRUKReplacer::EvictionTimestamp(frame_id_t frame_id) const -> size_t {
+  if (scan_only_[frame_id]) {
+    return history_[frame_id * k_ + (history_pos_[frame_id] + k_ - 1) % k_];
   }
-  node_store_.erase(frame_id);
-  frame_ptr.reset();
-  evictable_size_--;
+  // Until the ring is full, its oldest entry is slot 0. Afterwards, it is the slot about to be overwritten.
+  size_t slot = access_count_[frame_id] < k_ ? 0 : history_pos_[frame_id];
+  return history_[frame_id * k_ + slot];
+}
+
+void LRUKReplacer::HeapPush(frame_id_t frame_id) {
+  heap_.push_back(frame_id);
+  heap_pos_[frame_id] = heap_.size() - 1;
+  SiftUp(heap_.size() - 1);
 }
 
-auto LRUKReplacer::Size() -> size_t { return evictable_size_; }
+void LRUKReplacer::HeapErase(frame_id_t frame_id) {
+  size_t pos = heap_pos_[frame_id];
+  HeapSwap(pos, heap_.size() - 1);
+  heap_.pop_back();
+  heap_pos_[frame_id] = INVALID_HEAP_POS;
+  if (pos < heap_.size()) {
+    frame_id_t moved = heap_[pos];
+    SiftUp(pos);
+    SiftDown(heap_pos_[moved]);
+  }
+}
+
+void LRUKReplacer::HeapSwap(size_t a, size_t b) {
+  std::swap(heap_[a], heap_[b]);
+  heap_pos_[heap_[a]] = a;
+  heap_pos_[heap_[b]] = b;
+}
+
+void LRUKReplacer::SiftUp(size_t pos) {
+  while (pos > 0) {
+    size_t parent = (pos - 1) / 2;
+    if (!EvictsBefore(heap_[pos], heap_[parent])) {
+      break;
+    }
+    HeapSwap(pos, parent);
+    pos = parent;
+  }
+}
+
+void LRUKReplacer::SiftDown(size_t pos) {
+  while (true) {
+    size_t smallest = pos;
+    for (size_t child = 2 * pos + 1; child <= 2 * pos + 2 && child < heap_.size(); child++) {
+      if (EvictsBefore(heap_[child], heap_[smallest])) {
+        smallest = child;
+      }
+    }
+    if (smallest == pos) {
+      return;
+    }
+    HeapSwap(pos, smallest);
+    pos = smallest;
+  }
+}
 
 }  // namespace bustub
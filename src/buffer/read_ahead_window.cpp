@@ -0,0 +1,50 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_window.cpp
+//
+// Identification: src/buffer/read_ahead_window.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/read_ahead_window.h"
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+void ReadAheadWindow::Advance(page_id_t page_id) {
+  if (bpm_ == nullptr) {
+    return;
+  }
+  if (frontier_distance_ == 0) {
+    // The iterator caught up with the window, or this is its first page: restart from where it is.
+    frontier_page_id_ = page_id;
+  } else {
+    frontier_distance_--;
+  }
+
+  while (frontier_distance_ < window_size_ && frontier_page_id_ != INVALID_PAGE_ID) {
+    if (!bpm_->IsPageResident(frontier_page_id_)) {
+      // Still being read, or evicted before we got to it. Asking again is a no-op in the former case.
+      bpm_->Prefetch({frontier_page_id_});
+      return;
+    }
+    Page *page = bpm_->FetchPage(frontier_page_id_, AccessType::Scan);
+    if (page == nullptr) {
+      return;
+    }
+    page->RLatch();
+    page_id_t next_page_id = next_page_id_fn_(page->GetData());
+    page->RUnlatch();
+    bpm_->UnpinPage(frontier_page_id_, false, AccessType::Scan);
+    frontier_page_id_ = next_page_id;
+    frontier_distance_++;
+  }
+}
+
+}  // namespace bustub
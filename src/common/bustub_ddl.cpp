@@ -61,6 +61,14 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
     }
   }
   auto key_schema = Schema::CopySchema(&stmt.table_->schema_, col_ids);
+  std::vector<uint32_t> include_col_ids;
+  for (const auto &col : stmt.include_cols_) {
+    auto idx = stmt.table_->schema_.GetColIdx(col->col_name_.back());
+    include_col_ids.push_back(idx);
+    if (stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
+      throw NotImplementedException("only support including integer columns in an index");
+    }
+  }
 
   // TODO(spring2023): If you want to support composite index key for leaderboard optimization, remove this assertion
   // and create index with different key type that can hold multiple keys based on number of index columns.
@@ -70,11 +78,15 @@ void BustubInstance::HandleIndexStatement(Transaction *txn, const IndexStatement
   if (col_ids.empty() || col_ids.size() > 2) {
     throw NotImplementedException("only support creating index with exactly one or two columns");
   }
+  // Included columns are stored in the key slot after the key columns, so they share its two integers.
+  if (col_ids.size() + include_col_ids.size() > 2) {
+    throw NotImplementedException("only support indexes of at most two columns, included ones counted");
+  }
 
   std::unique_lock<std::shared_mutex> l(catalog_lock_);
   auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
       txn, stmt.index_name_, stmt.table_->table_, stmt.table_->schema_, key_schema, col_ids, TWO_INTEGER_SIZE,
-      IntegerHashFunctionType{});
+      IntegerHashFunctionType{}, include_col_ids);
   l.unlock();
 
   if (info == nullptr) {
@@ -34,6 +34,7 @@
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_posix.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -42,11 +43,21 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn, bool is_modify) -> st
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_, is_modify);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+BustubInstance::BustubInstance(const std::string &db_file_name, DiskBackend disk_backend) {
   enable_logging = false;
 
   // Storage related.
-  disk_manager_ = new DiskManager(db_file_name);
+  switch (disk_backend) {
+    case DiskBackend::Fstream:
+      disk_manager_ = new DiskManager(db_file_name);
+      break;
+    case DiskBackend::Posix:
+      disk_manager_ = new DiskManagerPosix(db_file_name);
+      break;
+    case DiskBackend::PosixDirect:
+      disk_manager_ = new DiskManagerPosix(db_file_name, true);
+      break;
+  }
 
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
@@ -163,6 +174,67 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayBpmStats(ResultWriter &writer) {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception("buffer pool manager is not available");
+  }
+  auto stats = buffer_pool_manager_->GetStats();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  for (const auto *header : {"access_type", "hits", "misses", "hit_ratio", "second_tier_hits", "evictions",
+                             "write_backs", "failures", "miss_p50_us", "miss_p99_us"}) {
+    writer.WriteHeaderCell(header);
+  }
+  writer.EndHeader();
+  auto write_access_stats = [&writer](const std::string &name, const BufferPoolStats::AccessStats &access_stats) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(fmt::format("{}", access_stats.hits_));
+    writer.WriteCell(fmt::format("{}", access_stats.misses_));
+    writer.WriteCell(fmt::format("{:.4f}", access_stats.HitRatio()));
+    writer.WriteCell(fmt::format("{}", access_stats.second_tier_hits_));
+    writer.WriteCell(fmt::format("{}", access_stats.evictions_));
+    writer.WriteCell(fmt::format("{}", access_stats.write_backs_));
+    writer.WriteCell(fmt::format("{}", access_stats.failures_));
+    // The histogram only knows the bucket of a percentile, so show the bucket's upper bound.
+    for (double percentile : {50.0, 99.0}) {
+      const auto &latency = access_stats.miss_latency_;
+      writer.WriteCell(latency.Count() == 0 ? "-" : fmt::format("<{}", latency.Percentile(percentile)));
+    }
+    writer.EndRow();
+  };
+  for (size_t i = 0; i < NUM_ACCESS_TYPES; i++) {
+    auto access_type = static_cast<AccessType>(i);
+    write_access_stats(AccessTypeToString(access_type), stats.Access(access_type));
+  }
+  write_access_stats("all", stats.AllAccesses());
+  writer.EndTable();
+
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("counter");
+  writer.WriteHeaderCell("value");
+  writer.EndHeader();
+  for (const auto &[name, value] :
+       {std::make_pair("pool_size", static_cast<uint64_t>(buffer_pool_manager_->GetPoolSize())),
+        std::make_pair("new_pages", stats.new_pages_), std::make_pair("new_page_failures", stats.new_page_failures_),
+        std::make_pair("evictions", stats.evictions_), std::make_pair("foreground_writes", stats.foreground_writes_),
+        std::make_pair("background_writes", stats.background_writes_),
+        std::make_pair("local_frames", stats.local_frames_), std::make_pair("remote_frames", stats.remote_frames_),
+        std::make_pair("second_tier_budget_bytes", static_cast<uint64_t>(stats.second_tier_.budget_bytes_)),
+        std::make_pair("second_tier_used_bytes", static_cast<uint64_t>(stats.second_tier_.used_bytes_)),
+        std::make_pair("second_tier_pages", static_cast<uint64_t>(stats.second_tier_.pages_)),
+        std::make_pair("second_tier_inserts", stats.second_tier_.inserts_),
+        std::make_pair("second_tier_evictions", stats.second_tier_.evictions_),
+        std::make_pair("second_tier_rejects", stats.second_tier_.rejects_)}) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(fmt::format("{}", value));
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -176,6 +248,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\stats bpm: show the buffer pool counters
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -216,6 +289,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\stats bpm") {
+      CmdDisplayBpmStats(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
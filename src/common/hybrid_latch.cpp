@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_latch.cpp
+//
+// Identification: src/common/hybrid_latch.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/hybrid_latch.h"
+
+#include <algorithm>
+#include <climits>
+#include <thread>  // NOLINT
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bustub {
+
+static constexpr uint32_t MIN_SPIN_LIMIT = 16;
+static constexpr uint32_t MAX_SPIN_LIMIT = 1024;
+
+/** Spinning only helps if the holder of the latch can run at the same time. */
+static const bool SPIN_ENABLED = std::thread::hardware_concurrency() > 1;
+
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+void HybridLatch::WLockSlow() {
+  uint32_t spins = 0;
+  bool parked = false;
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & (WRITER | READER_MASK)) == 0) {
+      if (state_.compare_exchange_weak(state, (state | WRITER) & ~WRITER_WAITING, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    if (prefer_writers_ && (state & WRITER_WAITING) == 0) {
+      // Keep new readers out, so that the current ones drain.
+      if (state_.compare_exchange_weak(state, state | WRITER_WAITING, std::memory_order_relaxed)) {
+        state |= WRITER_WAITING;
+      }
+      continue;
+    }
+    parked = Wait(state, &spins) || parked;
+    state = state_.load(std::memory_order_relaxed);
+  }
+  Acquired(spins, parked);
+}
+
+void HybridLatch::RLockSlow() {
+  uint32_t spins = 0;
+  bool parked = false;
+  uint32_t state = state_.load(std::memory_order_relaxed);
+  while (true) {
+    if ((state & ReaderBlockers()) == 0) {
+      if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+        break;
+      }
+      continue;
+    }
+    parked = Wait(state, &spins) || parked;
+    state = state_.load(std::memory_order_relaxed);
+  }
+  Acquired(spins, parked);
+}
+
+/**
+ * The parked thread sleeps for as long as the latch word still holds the value it saw, with the PARKED bit set, so a
+ * release that clears the bit after the thread decided to park either wakes it up or keeps it from sleeping at all.
+ */
+auto HybridLatch::Wait(uint32_t state, uint32_t *spins) -> bool {
+  if (SPIN_ENABLED && *spins < spin_limit_.load(std::memory_order_relaxed)) {
+    ++*spins;
+    CpuRelax();
+    return false;
+  }
+  if ((state & PARKED) == 0 && !state_.compare_exchange_strong(state, state | PARKED, std::memory_order_relaxed)) {
+    return false;
+  }
+  parks_.fetch_add(1, std::memory_order_relaxed);
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAIT_PRIVATE, state | PARKED, nullptr, nullptr, 0);
+#else
+  std::this_thread::yield();
+#endif
+  return true;
+}
+
+/**
+ * Spin longer on a latch where spinning got the latch, and shorter on one where the waiter had to park anyway.
+ */
+void HybridLatch::Acquired(uint32_t spins, bool parked) {
+  spins_.fetch_add(spins, std::memory_order_relaxed);
+  auto limit = spin_limit_.load(std::memory_order_relaxed);
+  if (parked) {
+    spin_limit_.store(std::max(limit / 2, MIN_SPIN_LIMIT), std::memory_order_relaxed);
+  } else if (spins > 0) {
+    spin_limit_.store(std::min(limit * 2, MAX_SPIN_LIMIT), std::memory_order_relaxed);
+  }
+}
+
+void HybridLatch::WakeAll() {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+}
+
+}  // namespace bustub
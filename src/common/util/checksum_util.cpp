@@ -0,0 +1,160 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.cpp
+//
+// Identification: src/common/util/checksum_util.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/checksum_util.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The CRC32C polynomial, bit-reversed. */
+constexpr uint32_t CRC32C_POLY = 0x82F63B78;
+
+/** Lookup tables for slicing-by-8: table[k][b] is the CRC of byte b followed by k zero bytes. */
+auto MakeCrc32cTable() -> std::array<std::array<uint32_t, 256>, 8> {
+  std::array<std::array<uint32_t, 256>, 8> table{};
+  for (uint32_t b = 0; b < 256; b++) {
+    uint32_t crc = b;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLY : 0);
+    }
+    table[0][b] = crc;
+  }
+  for (uint32_t b = 0; b < 256; b++) {
+    for (size_t k = 1; k < 8; k++) {
+      table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xFF];
+    }
+  }
+  return table;
+}
+
+/** Multiplies two polynomials modulo the CRC32C polynomial, all bit-reversed. */
+auto MultiplyModPoly(uint32_t a, uint32_t b) -> uint32_t {
+  uint32_t product = 0;
+  for (int i = 31; i >= 0; i--) {
+    product ^= b & (0U - ((a >> i) & 1));
+    b = (b >> 1) ^ (CRC32C_POLY & (0U - (b & 1)));
+  }
+  return product;
+}
+
+/** @return x^(8 * size) modulo the CRC32C polynomial, which shifts a CRC register over size zero bytes */
+auto ShiftOperator(size_t size) -> uint32_t {
+  uint32_t result = 1U << 31;  // x^0
+  uint32_t power = 1U << 23;   // x^8
+  for (; size > 0; size >>= 1) {
+    if ((size & 1) != 0) {
+      result = MultiplyModPoly(result, power);
+    }
+    power = MultiplyModPoly(power, power);
+  }
+  return result;
+}
+
+#if defined(__x86_64__) || (defined(__aarch64__) && defined(__ARM_FEATURE_CRC32))
+#if defined(__x86_64__)
+#define BUSTUB_CRC32C_TARGET __attribute__((target("sse4.2")))
+BUSTUB_CRC32C_TARGET inline auto Crc32cWord(uint32_t crc, uint64_t word) -> uint32_t {
+  return static_cast<uint32_t>(_mm_crc32_u64(crc, word));
+}
+BUSTUB_CRC32C_TARGET inline auto Crc32cByte(uint32_t crc, uint8_t byte) -> uint32_t { return _mm_crc32_u8(crc, byte); }
+auto DetectHardwareCrc32c() -> bool { return __builtin_cpu_supports("sse4.2") != 0; }
+#else
+#define BUSTUB_CRC32C_TARGET
+inline auto Crc32cWord(uint32_t crc, uint64_t word) -> uint32_t { return __crc32cd(crc, word); }
+inline auto Crc32cByte(uint32_t crc, uint8_t byte) -> uint32_t { return __crc32cb(crc, byte); }
+auto DetectHardwareCrc32c() -> bool { return true; }
+#endif
+
+/**
+ * Each stripe of a page-sized buffer is checksummed as three independent streams. The CRC instruction has a latency of
+ * about three cycles but can start one every cycle, so the streams run in parallel; their CRCs are then combined.
+ */
+constexpr size_t STRIPE_WORDS = 170;
+constexpr size_t STRIPE_SIZE = STRIPE_WORDS * sizeof(uint64_t);
+
+inline auto LoadWord(const char *data) -> uint64_t {
+  uint64_t word;
+  memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+BUSTUB_CRC32C_TARGET auto Crc32cHardware(const char *data, size_t size, uint32_t crc) -> uint32_t {
+  static const uint32_t stripe_shift = ShiftOperator(STRIPE_SIZE);
+  crc = ~crc;
+  for (; size >= 3 * STRIPE_SIZE; data += 3 * STRIPE_SIZE, size -= 3 * STRIPE_SIZE) {
+    uint32_t crc1 = 0;
+    uint32_t crc2 = 0;
+    for (size_t i = 0; i < STRIPE_SIZE; i += sizeof(uint64_t)) {
+      crc = Crc32cWord(crc, LoadWord(data + i));
+      crc1 = Crc32cWord(crc1, LoadWord(data + STRIPE_SIZE + i));
+      crc2 = Crc32cWord(crc2, LoadWord(data + 2 * STRIPE_SIZE + i));
+    }
+    // The CRC register is linear: shifting the first stream's register over the next stripe and adding the register
+    // of that stripe, computed from zero, gives the register of the two stripes together.
+    crc = MultiplyModPoly(crc, stripe_shift) ^ crc1;
+    crc = MultiplyModPoly(crc, stripe_shift) ^ crc2;
+  }
+  for (; size >= sizeof(uint64_t); data += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+    crc = Crc32cWord(crc, LoadWord(data));
+  }
+  for (; size > 0; data++, size--) {
+    crc = Crc32cByte(crc, static_cast<uint8_t>(*data));
+  }
+  return ~crc;
+}
+#undef BUSTUB_CRC32C_TARGET
+#else
+auto Crc32cHardware(const char *data, size_t size, uint32_t crc) -> uint32_t {
+  return ChecksumUtil::Crc32cSoftware(data, size, crc);
+}
+
+auto DetectHardwareCrc32c() -> bool { return false; }
+#endif
+
+}  // namespace
+
+auto ChecksumUtil::Crc32c(const char *data, size_t size, uint32_t crc) -> uint32_t {
+  static const bool has_hardware_crc32c = DetectHardwareCrc32c();
+  return has_hardware_crc32c ? Crc32cHardware(data, size, crc) : Crc32cSoftware(data, size, crc);
+}
+
+auto ChecksumUtil::HasHardwareCrc32c() -> bool { return DetectHardwareCrc32c(); }
+
+auto ChecksumUtil::Crc32cSoftware(const char *data, size_t size, uint32_t crc) -> uint32_t {
+  static const auto table = MakeCrc32cTable();
+  crc = ~crc;
+  // Slicing-by-8 assumes a little-endian machine, like the rest of the storage layer.
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    word ^= crc;
+    crc = table[7][word & 0xFF] ^ table[6][(word >> 8) & 0xFF] ^ table[5][(word >> 16) & 0xFF] ^
+          table[4][(word >> 24) & 0xFF] ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF] ^
+          table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+  }
+  for (; size > 0; data++, size--) {
+    crc = (crc >> 8) ^ table[0][(crc ^ static_cast<uint8_t>(*data)) & 0xFF];
+  }
+  return ~crc;
+}
+
+}  // namespace bustub
@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.cpp
+//
+// Identification: src/common/util/compression_util.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/compression_util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** The shortest match the format can encode. */
+constexpr size_t MIN_MATCH = 4;
+/** The format requires the last bytes of a block to be literals. */
+constexpr size_t LAST_LITERALS = 5;
+/** A match must start at least this many bytes before the end of the block. */
+constexpr size_t MATCH_START_LIMIT = 12;
+/** The longest distance a match offset can encode. */
+constexpr size_t MAX_OFFSET = 65535;
+/** A length nibble with this value is continued in the following bytes. */
+constexpr size_t LENGTH_NIBBLE_MAX = 15;
+constexpr size_t HASH_BITS = 12;
+
+auto Read32(const uint8_t *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> size_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Writes the compressed stream, failing once it would exceed the capacity. */
+class Lz4Writer {
+ public:
+  Lz4Writer(uint8_t *dst, size_t capacity) : dst_(dst), capacity_(capacity) {}
+
+  auto Put(uint8_t byte) -> bool {
+    if (pos_ == capacity_) {
+      return false;
+    }
+    dst_[pos_++] = byte;
+    return true;
+  }
+
+  /** Write the part of a length that did not fit into its token nibble. */
+  auto PutLengthTail(size_t length) -> bool {
+    if (length < LENGTH_NIBBLE_MAX) {
+      return true;
+    }
+    length -= LENGTH_NIBBLE_MAX;
+    while (length >= 255) {
+      if (!Put(255)) {
+        return false;
+      }
+      length -= 255;
+    }
+    return Put(static_cast<uint8_t>(length));
+  }
+
+  auto PutBytes(const uint8_t *src, size_t size) -> bool {
+    if (capacity_ - pos_ < size) {
+      return false;
+    }
+    memcpy(dst_ + pos_, src, size);
+    pos_ += size;
+    return true;
+  }
+
+  /** Write a sequence: the literals, then a match of match_length bytes at offset, unless match_length is 0. */
+  auto PutSequence(const uint8_t *literals, size_t literal_length, size_t offset, size_t match_length) -> bool {
+    size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    auto token = static_cast<uint8_t>((std::min(literal_length, LENGTH_NIBBLE_MAX) << 4) |
+                                      std::min(match_code, LENGTH_NIBBLE_MAX));
+    if (!Put(token) || !PutLengthTail(literal_length) || !PutBytes(literals, literal_length)) {
+      return false;
+    }
+    if (match_length == 0) {
+      return true;
+    }
+    return Put(static_cast<uint8_t>(offset & 0xFF)) && Put(static_cast<uint8_t>(offset >> 8)) &&
+           PutLengthTail(match_code);
+  }
+
+  auto Size() const -> size_t { return pos_; }
+
+ private:
+  uint8_t *dst_;
+  size_t capacity_;
+  size_t pos_{0};
+};
+
+/** Reads the continuation bytes of a length nibble. */
+auto ReadLengthTail(const uint8_t *src, size_t size, size_t *pos, size_t *length) -> bool {
+  if (*length != LENGTH_NIBBLE_MAX) {
+    return true;
+  }
+  uint8_t byte;
+  do {
+    if (*pos == size) {
+      return false;
+    }
+    byte = src[(*pos)++];
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+auto CompressionUtil::Lz4Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  Lz4Writer writer(reinterpret_cast<uint8_t *>(dst), capacity);
+  // Last position each hashed 4-byte sequence was seen at. Candidates are verified, so stale entries are harmless.
+  std::array<uint32_t, 1 << HASH_BITS> table{};
+  size_t anchor = 0;
+  if (size > MATCH_START_LIMIT) {
+    size_t match_end_limit = size - LAST_LITERALS;
+    size_t pos = 0;
+    while (pos + MATCH_START_LIMIT <= size) {
+      uint32_t sequence = Read32(in + pos);
+      size_t hash = Hash(sequence);
+      size_t candidate = table[hash];
+      table[hash] = static_cast<uint32_t>(pos);
+      if (candidate >= pos || pos - candidate > MAX_OFFSET || Read32(in + candidate) != sequence) {
+        pos++;
+        continue;
+      }
+      size_t match_length = MIN_MATCH;
+      while (pos + match_length < match_end_limit && in[candidate + match_length] == in[pos + match_length]) {
+        match_length++;
+      }
+      if (!writer.PutSequence(in + anchor, pos - anchor, pos - candidate, match_length)) {
+        return 0;
+      }
+      pos += match_length;
+      anchor = pos;
+    }
+  }
+  if (!writer.PutSequence(in + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+  return writer.Size();
+}
+
+auto CompressionUtil::Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  size_t in_pos = 0;
+  size_t out_pos = 0;
+  while (in_pos < size) {
+    uint8_t token = in[in_pos++];
+    size_t literal_length = token >> 4;
+    if (!ReadLengthTail(in, size, &in_pos, &literal_length) || size - in_pos < literal_length ||
+        dst_size - out_pos < literal_length) {
+      return false;
+    }
+    memcpy(out + out_pos, in + in_pos, literal_length);
+    in_pos += literal_length;
+    out_pos += literal_length;
+    if (in_pos == size) {
+      // The last sequence has no match.
+      break;
+    }
+    if (size - in_pos < 2) {
+      return false;
+    }
+    size_t offset = in[in_pos] | (static_cast<size_t>(in[in_pos + 1]) << 8);
+    in_pos += 2;
+    size_t match_length = token & 0xF;
+    if (offset == 0 || offset > out_pos || !ReadLengthTail(in, size, &in_pos, &match_length)) {
+      return false;
+    }
+    match_length += MIN_MATCH;
+    if (dst_size - out_pos < match_length) {
+      return false;
+    }
+    // The match may overlap the bytes it produces, so copy byte by byte.
+    for (size_t i = 0; i < match_length; i++) {
+      out[out_pos + i] = out[out_pos - offset + i];
+    }
+    out_pos += match_length;
+  }
+  return out_pos == dst_size;
+}
+
+}  // namespace bustub
@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.cpp
+//
+// Identification: src/common/util/numa_util.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/numa_util.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/util/string_util.h"
+
+namespace bustub {
+
+namespace {
+
+/** The memory policies of mbind(2), see <numaif.h>. */
+constexpr int MPOL_PREFERRED_POLICY = 1;
+constexpr int MPOL_INTERLEAVE_POLICY = 3;
+
+/** The NUMA topology of the machine, read once from /sys. Nodes are numbered densely, in the order of their ids. */
+struct Topology {
+  /** The online CPUs. */
+  std::vector<int> cpus_;
+  /** The kernel's id of each node. */
+  std::vector<int> node_ids_;
+  /** The CPUs of each node. */
+  std::vector<std::vector<int>> node_cpus_;
+};
+
+/** Parse a list like "0-3,8,10-11", as used by /sys. */
+auto ParseCpuList(const std::string &list) -> std::vector<int> {
+  std::vector<int> ids;
+  for (const auto &range : StringUtil::Split(list, ',')) {
+    auto bounds = StringUtil::Split(range, '-');
+    if (bounds.empty() || bounds[0].empty()) {
+      continue;
+    }
+    int first = std::stoi(bounds[0]);
+    int last = bounds.size() > 1 ? std::stoi(bounds[1]) : first;
+    for (int id = first; id <= last; id++) {
+      ids.push_back(id);
+    }
+  }
+  return ids;
+}
+
+auto ReadFile(const std::string &path) -> std::string {
+  std::ifstream file(path);
+  std::string content;
+  std::getline(file, content);
+  return content;
+}
+
+auto LoadTopology() -> Topology {
+  Topology topology;
+  topology.cpus_ = ParseCpuList(ReadFile("/sys/devices/system/cpu/online"));
+  if (topology.cpus_.empty()) {
+    for (unsigned cpu = 0; cpu < std::max(std::thread::hardware_concurrency(), 1U); cpu++) {
+      topology.cpus_.push_back(static_cast<int>(cpu));
+    }
+  }
+  for (int node_id : ParseCpuList(ReadFile("/sys/devices/system/node/online"))) {
+    auto cpus = ParseCpuList(ReadFile("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist"));
+    topology.node_ids_.push_back(node_id);
+    topology.node_cpus_.push_back(std::move(cpus));
+  }
+  if (topology.node_ids_.empty()) {
+    // No NUMA support in the kernel: the whole machine is one node.
+    topology.node_ids_.push_back(0);
+    topology.node_cpus_.push_back(topology.cpus_);
+  }
+  return topology;
+}
+
+auto GetTopology() -> const Topology & {
+  static const Topology TOPOLOGY = LoadTopology();
+  return TOPOLOGY;
+}
+
+std::atomic<size_t> simulated_node_cnt{0};
+
+/** The node the thread was pinned to by PinThread(), if any. */
+thread_local size_t pinned_node = SIZE_MAX;
+
+auto Mbind(void *addr, size_t size, int policy, const std::vector<uint64_t> &node_mask) -> bool {
+#ifdef SYS_mbind
+  // The kernel reads one bit less than maxnode.
+  return syscall(SYS_mbind, addr, size, policy, node_mask.data(), node_mask.size() * 64 + 1, 0) == 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+auto NumaUtil::NodeCount() -> size_t {
+  size_t simulated = simulated_node_cnt.load();
+  return simulated > 0 ? simulated : SystemNodeCount();
+}
+
+auto NumaUtil::SystemNodeCount() -> size_t { return GetTopology().node_ids_.size(); }
+
+void NumaUtil::SimulateNodes(size_t node_cnt) { simulated_node_cnt = node_cnt; }
+
+auto NumaUtil::NodeCpus(size_t node) -> std::vector<int> {
+  const auto &topology = GetTopology();
+  size_t simulated = simulated_node_cnt.load();
+  if (simulated == 0) {
+    return node < topology.node_cpus_.size() ? topology.node_cpus_[node] : std::vector<int>{};
+  }
+  std::vector<int> cpus;
+  for (size_t i = node; i < topology.cpus_.size(); i += simulated) {
+    cpus.push_back(topology.cpus_[i]);
+  }
+  return cpus;
+}
+
+auto NumaUtil::CurrentNode() -> size_t {
+  size_t node_cnt = NodeCount();
+  if (pinned_node < node_cnt) {
+    return pinned_node;
+  }
+  int cpu = sched_getcpu();
+  if (cpu < 0) {
+    return 0;
+  }
+  const auto &topology = GetTopology();
+  if (simulated_node_cnt.load() > 0) {
+    for (size_t i = 0; i < topology.cpus_.size(); i++) {
+      if (topology.cpus_[i] == cpu) {
+        return i % node_cnt;
+      }
+    }
+    return 0;
+  }
+  for (size_t node = 0; node < topology.node_cpus_.size(); node++) {
+    for (int node_cpu : topology.node_cpus_[node]) {
+      if (node_cpu == cpu) {
+        return node;
+      }
+    }
+  }
+  return 0;
+}
+
+auto NumaUtil::PinThread(size_t worker_id) -> size_t {
+  size_t node_cnt = NodeCount();
+  size_t node = worker_id % node_cnt;
+  auto cpus = NodeCpus(node);
+  if (cpus.empty()) {
+    // A simulated node with more nodes than CPUs, or a node without CPUs. Let the thread run anywhere.
+    cpus = GetTopology().cpus_;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpus[worker_id / node_cnt % cpus.size()], &cpu_set);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+  pinned_node = node;
+  return node;
+}
+
+auto NumaUtil::BindMemory(void *addr, size_t size, size_t node) -> bool {
+  const auto &topology = GetTopology();
+  if (topology.node_ids_.size() < 2 || node >= topology.node_ids_.size()) {
+    return false;
+  }
+  auto node_id = static_cast<size_t>(topology.node_ids_[node]);
+  std::vector<uint64_t> node_mask(node_id / 64 + 1, 0);
+  node_mask[node_id / 64] |= uint64_t{1} << (node_id % 64);
+  return Mbind(addr, size, MPOL_PREFERRED_POLICY, node_mask);
+}
+
+auto NumaUtil::InterleaveMemory(void *addr, size_t size) -> bool {
+  const auto &topology = GetTopology();
+  if (topology.node_ids_.size() < 2) {
+    return false;
+  }
+  std::vector<uint64_t> node_mask(static_cast<size_t>(topology.node_ids_.back()) / 64 + 1, 0);
+  for (int node_id : topology.node_ids_) {
+    node_mask[node_id / 64] |= uint64_t{1} << (node_id % 64);
+  }
+  return Mbind(addr, size, MPOL_INTERLEAVE_POLICY, node_mask);
+}
+
+}  // namespace bustub
@@ -51,8 +51,8 @@ void TransactionManager::Abort(Transaction *txn) {
     // Metadata identifying the table that should be deleted from.
     TableInfo *table_info = catalog->GetTable(item.table_oid_);
     IndexInfo *index_info = catalog->GetIndex(item.index_oid_);
-    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                            index_info->index_->GetKeyAttrs());
+    auto new_key = item.tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetEntrySchema()),
+                                            index_info->index_->GetEntryAttrs());
     if (item.wtype_ == WType::DELETE) {
       index_info->index_->InsertEntry(new_key, item.rid_, txn);
     } else if (item.wtype_ == WType::INSERT) {
@@ -60,8 +60,8 @@ void TransactionManager::Abort(Transaction *txn) {
     } else if (item.wtype_ == WType::UPDATE) {
       // Delete the new key and insert the old key
       index_info->index_->DeleteEntry(new_key, item.rid_, txn);
-      auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetKeySchema()),
-                                                  index_info->index_->GetKeyAttrs());
+      auto old_key = item.old_tuple_.KeyFromTuple(table_info->schema_, *(index_info->index_->GetEntrySchema()),
+                                                  index_info->index_->GetEntryAttrs());
       index_info->index_->InsertEntry(old_key, item.rid_, txn);
     }
     index_write_set->pop_back();
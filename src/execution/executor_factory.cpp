@@ -20,6 +20,7 @@
 #include "execution/executors/delete_executor.h"
 #include "execution/executors/filter_executor.h"
 #include "execution/executors/hash_join_executor.h"
+#include "execution/executors/index_only_scan_executor.h"
 #include "execution/executors/index_scan_executor.h"
 #include "execution/executors/init_check_executor.h"
 #include "execution/executors/insert_executor.h"
@@ -56,7 +57,11 @@ auto ExecutorFactory::CreateExecutor(ExecutorContext *exec_ctx, const AbstractPl
 
     // Create a new index scan executor
     case PlanType::IndexScan: {
-      return std::make_unique<IndexScanExecutor>(exec_ctx, dynamic_cast<const IndexScanPlanNode *>(plan.get()));
+      const auto *index_scan_plan = dynamic_cast<const IndexScanPlanNode *>(plan.get());
+      if (index_scan_plan->index_only_) {
+        return std::make_unique<IndexOnlyScanExecutor>(exec_ctx, index_scan_plan);
+      }
+      return std::make_unique<IndexScanExecutor>(exec_ctx, index_scan_plan);
     }
 
     // Create a new insert executor
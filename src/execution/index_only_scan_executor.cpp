@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_only_scan_executor.cpp
+//
+// Identification: src/execution/index_only_scan_executor.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#include "execution/executors/index_only_scan_executor.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+IndexOnlyScanExecutor::IndexOnlyScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
+    : IndexScanExecutor(exec_ctx, plan) {}
+
+void IndexOnlyScanExecutor::Init() {
+  IndexScanExecutor::Init();
+  values_.clear();
+  for (const auto &column : GetOutputSchema().GetColumns()) {
+    values_.push_back(ValueFactory::GetNullValueByType(column.GetType()));
+  }
+}
+
+auto IndexOnlyScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
+  if (!SeekVisible()) {
+    return false;
+  }
+  const auto &[entry, entry_rid] = *itr_;
+  auto *entry_schema = index_info_->index_->GetEntrySchema();
+  const auto &entry_attrs = index_info_->index_->GetEntryAttrs();
+  for (uint32_t i = 0; i < entry_attrs.size(); i++) {
+    values_[entry_attrs[i]] = entry.ToValue(entry_schema, i);
+  }
+  *rid = entry_rid;
+  *tuple = Tuple(values_, &GetOutputSchema());
+  ++itr_;
+  return true;
+}
+
+}  // namespace bustub
@@ -18,25 +18,90 @@ IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanP
       plan_(plan),
       index_info_(exec_ctx_->GetCatalog()->GetIndex(plan_->GetIndexOid())),
       table_info_(exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_)),
-      tree_(dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info_->index_.get())),
-      itr_(tree_->GetBeginIterator()) {}
+      tree_(dynamic_cast<BPlusTreeIndexForTwoIntegerColumn *>(index_info_->index_.get())) {}
 
-void IndexScanExecutor::Init() {}
+void IndexScanExecutor::Init() {
+  Schema empty_schema({});
+  lower_ = std::nullopt;
+  upper_ = std::nullopt;
+  if (plan_->lower_.key_ != nullptr) {
+    lower_ = plan_->lower_.key_->Evaluate(nullptr, empty_schema);
+  }
+  if (plan_->upper_.key_ != nullptr) {
+    upper_ = plan_->upper_.key_->Evaluate(nullptr, empty_schema);
+  }
+
+  // The scan starts at the first key in range, or just before it. Keys outside the range are skipped in Next().
+  if (plan_->reverse_) {
+    itr_ = upper_.has_value() ? tree_->GetReverseBeginIterator(MakeStartKey(*upper_, plan_->upper_.inclusive_))
+                              : tree_->GetReverseBeginIterator();
+  } else {
+    itr_ = lower_.has_value() ? tree_->GetBeginIterator(MakeStartKey(*lower_, !plan_->lower_.inclusive_))
+                              : tree_->GetBeginIterator();
+  }
+}
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (itr_.IsEmpty() || itr_.IsEnd()) {
+  if (!SeekVisible()) {
     return false;
   }
-  while (table_info_->table_->GetTupleMeta((*itr_).second).is_deleted_) {
-    ++itr_;
-    if (itr_.IsEnd()) {
-      return false;
-    }
-  }
   *rid = (*itr_).second;
   *tuple = table_info_->table_->GetTuple(*rid).second;
   ++itr_;
   return true;
 }
 
+auto IndexScanExecutor::SeekVisible() -> bool {
+  for (; SeekInRange(); ++itr_) {
+    if (!table_info_->table_->GetTupleMeta((*itr_).second).is_deleted_) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto IndexScanExecutor::SeekInRange() -> bool {
+  for (; !itr_.IsEmpty() && !itr_.IsEnd(); ++itr_) {
+    if (!lower_.has_value() && !upper_.has_value()) {
+      return true;
+    }
+    Value key = (*itr_).first.ToValue(&index_info_->key_schema_, 0);
+    if (plan_->reverse_ ? BelowRange(key) : AboveRange(key)) {
+      return false;
+    }
+    if (!(plan_->reverse_ ? AboveRange(key) : BelowRange(key))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto IndexScanExecutor::MakeStartKey(const Value &bound, bool pad_with_max) -> IntegerKeyType {
+  const auto &key_schema = index_info_->key_schema_;
+  std::vector<Value> values{bound.CastAs(key_schema.GetColumn(0).GetType())};
+  for (uint32_t i = 1; i < key_schema.GetColumnCount(); i++) {
+    auto type_id = key_schema.GetColumn(i).GetType();
+    values.push_back(pad_with_max ? Type::GetMaxValue(type_id) : Type::GetMinValue(type_id));
+  }
+  IntegerKeyType key;
+  key.SetFromKey(Tuple(values, &key_schema));
+  return key;
+}
+
+auto IndexScanExecutor::BelowRange(const Value &value) const -> bool {
+  if (!lower_.has_value()) {
+    return false;
+  }
+  return plan_->lower_.inclusive_ ? value.CompareLessThan(*lower_) == CmpBool::CmpTrue
+                                  : value.CompareLessThanEquals(*lower_) == CmpBool::CmpTrue;
+}
+
+auto IndexScanExecutor::AboveRange(const Value &value) const -> bool {
+  if (!upper_.has_value()) {
+    return false;
+  }
+  return plan_->upper_.inclusive_ ? value.CompareGreaterThan(*upper_) == CmpBool::CmpTrue
+                                  : value.CompareGreaterThanEquals(*upper_) == CmpBool::CmpTrue;
+}
+
 }  // namespace bustub
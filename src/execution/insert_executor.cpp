@@ -12,6 +12,8 @@
 
 #include <iostream>
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "execution/executors/abstract_executor.h"
 #include "execution/executors/insert_executor.h"
@@ -51,6 +53,8 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     return false;
   }
 
+  // The index entries of all rows are inserted at the end, one batch per index.
+  std::vector<std::vector<std::pair<Tuple, RID>>> index_entries(table_indexes.size());
   while (child_executor_->Next(&child_tuple, &child_rid)) {
     auto tmp_rid = table_info->table_->InsertTuple(TupleMeta{INVALID_TXN_ID, INVALID_TXN_ID, false}, child_tuple,
                                                    exec_ctx_->GetLockManager(), txn, table_info->oid_);
@@ -58,10 +62,12 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
     write_record.wtype_ = WType::INSERT;
     exec_ctx_->GetTransaction()->AppendTableWriteRecord(write_record);
     if (tmp_rid.has_value()) {
-      for (auto index : table_indexes) {
-        index->index_->InsertEntry(
-            child_tuple.KeyFromTuple(table_info->schema_, index->key_schema_, index->index_->GetKeyAttrs()),
-            tmp_rid.value(), exec_ctx_->GetTransaction());
+      for (size_t i = 0; i < table_indexes.size(); i++) {
+        auto index = table_indexes[i];
+        index_entries[i].emplace_back(
+            child_tuple.KeyFromTuple(table_info->schema_, *index->index_->GetEntrySchema(),
+                                     index->index_->GetEntryAttrs()),
+            tmp_rid.value());
         IndexWriteRecord index_record{tmp_rid.value(), table_info->oid_,  WType::INSERT,
                                       child_tuple,     index->index_oid_, exec_ctx_->GetCatalog()};
         exec_ctx_->GetTransaction()->AppendIndexWriteRecord(index_record);
@@ -69,6 +75,9 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
       ++count_;
     }
   }
+  for (size_t i = 0; i < table_indexes.size(); i++) {
+    table_indexes[i]->index_->InsertEntries(index_entries[i], txn);
+  }
 
   std::vector<Value> values{};
   values.reserve(GetOutputSchema().GetColumnCount());
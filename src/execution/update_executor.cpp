@@ -55,9 +55,9 @@ auto UpdateExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
 
     if (tmp_rid.has_value()) {
       for (auto index : table_indexes) {
-        index->index_->InsertEntry(
-            child_tuple.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs()),
-            tmp_rid.value(), exec_ctx_->GetTransaction());
+        index->index_->InsertEntry(child_tuple.KeyFromTuple(table_info_->schema_, *index->index_->GetEntrySchema(),
+                                                            index->index_->GetEntryAttrs()),
+                                   tmp_rid.value(), exec_ctx_->GetTransaction());
       }
     }
     ++count_;
@@ -21,7 +21,8 @@ namespace bustub {
 class IndexStatement : public BoundStatement {
  public:
   explicit IndexStatement(std::string index_name, std::unique_ptr<BoundBaseTableRef> table,
-                          std::vector<std::unique_ptr<BoundColumnRef>> cols);
+                          std::vector<std::unique_ptr<BoundColumnRef>> cols,
+                          std::vector<std::unique_ptr<BoundColumnRef>> include_cols = {});
 
   /** Name of the index */
   std::string index_name_;
@@ -32,6 +33,9 @@ class IndexStatement : public BoundStatement {
   /** Name of the columns */
   std::vector<std::unique_ptr<BoundColumnRef>> cols_;
 
+  /** Name of the columns stored in the index besides the key */
+  std::vector<std::unique_ptr<BoundColumnRef>> include_cols_;
+
   auto ToString() const -> std::string override;
 };
 
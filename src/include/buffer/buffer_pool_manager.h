@@ -12,13 +12,25 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
+#include "common/util/numa_util.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -28,6 +40,29 @@ namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * The pool can be split into several shards. Each shard owns a contiguous range of frames together with its own page
+ * table, free list, replacer and latch, and caches exactly the pages whose id hashes to it. Operations on pages of
+ * different shards therefore never contend on the same latch. With a single shard (the default) the buffer pool
+ * behaves like a classic single-latch buffer pool.
+ *
+ * Disk I/O never happens while a shard latch is held (except for explicit flushes). A frame that is being filled is
+ * marked as in-flight: it is already in the page table and pinned, and other threads fetching the same page wait on
+ * the shard's condition variable until the I/O is done, while accesses to other pages proceed.
+ *
+ * Unpinning takes no latch at all: pin counts are atomic, and a frame whose pin count drops to zero is only noted in
+ * its shard's unpin log. Page hits don't touch the replacer either, they are buffered in the shard's access log. Both
+ * logs are applied to the replacer in batches, at the latest before it has to pick a victim. Hits take no latch either,
+ * for FetchPage() as well as for optimistic lookups: they find the frame through a lock-free index of the page table,
+ * pin it with a compare-and-swap, which fails while the shard claims the frame for another page, and append to the
+ * access log without a latch as well. Only misses, and hits on in-flight pages, take the shard latch.
+ *
+ * Optionally, evicted pages go to a second tier, a CompressedPageCache, and misses are served from there before they go
+ * to the disk.
+ *
+ * On NUMA machines, the frames can be spread over the nodes (NumaMode::Interleave), or each shard can split its frames
+ * into one partition per node (NumaMode::Partition). A partitioned shard hands out free frames of the calling thread's
+ * node first, so that threads pinned to a node mostly work on local memory.
  */
 class BufferPoolManager {
  public:
@@ -37,9 +72,13 @@ class BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param num_shards the number of partitions the frames are split into, must be in [1, pool_size]
+   * @param second_tier_bytes the memory budget of the compressed second tier in bytes, 0 for no second tier
+   * @param numa_mode how to place the frames on the NUMA nodes, see NumaUtil::NodeCount() for the number of nodes
    */
   BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                    LogManager *log_manager = nullptr);
+                    LogManager *log_manager = nullptr, size_t num_shards = 1, size_t second_tier_bytes = 0,
+                    NumaMode numa_mode = NumaMode::None);
 
   /**
    * @brief Destroy an existing BufferPoolManager.
@@ -52,6 +91,18 @@ class BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /** @brief Return the number of shards the buffer pool is partitioned into. */
+  auto GetNumShards() -> size_t { return shards_.size(); }
+
+  /** @brief Return how the frames are placed on the NUMA nodes. */
+  auto GetNumaMode() -> NumaMode { return numa_mode_; }
+
+  /**
+   * @brief Return the NUMA node a frame belongs to. Without NumaMode::Partition, every frame belongs to node 0.
+   * @param frame_id the index of the frame in GetPages()
+   */
+  auto GetFrameNode(frame_id_t frame_id) -> size_t;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -66,6 +117,9 @@ class BufferPoolManager {
    * so that the replacer wouldn't evict the frame before the buffer pool manager "Unpin"s it.
    * Also, remember to record the access history of the frame in the replacer for the lru-k algorithm to work.
    *
+   * With more than one shard, the new page lives in the shard its page id hashes to, so NewPage fails when that shard
+   * has no evictable frame even if other shards still have room.
+   *
    * @param[out] page_id id of created page
    * @return nullptr if no new pages could be created, otherwise pointer to new page
    */
@@ -98,8 +152,11 @@ class BufferPoolManager {
    *
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPage().
    *
+   * A hit on a resident page that is not in-flight takes no latch, see TryPinResident().
+   *
    * @param page_id id of page to be fetched
-   * @param access_type type of access to the page, only needed for leaderboard tests.
+   * @param access_type type of access to the page. Pass AccessType::Scan for sequential scans, so that they don't
+   * evict the pages of point lookups (see LRUKReplacer).
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
    */
   auto FetchPage(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> Page *;
@@ -115,11 +172,24 @@ class BufferPoolManager {
    * the returned page already has a read or write latch held, respectively.
    *
    * @param page_id, the id of the page to fetch
+   * @param access_type, type of access to the page, see FetchPage()
    * @return PageGuard holding the fetched page
    */
-  auto FetchPageBasic(page_id_t page_id) -> BasicPageGuard;
-  auto FetchPageRead(page_id_t page_id) -> ReadPageGuard;
-  auto FetchPageWrite(page_id_t page_id) -> WritePageGuard;
+  auto FetchPageBasic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> BasicPageGuard;
+  auto FetchPageRead(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> ReadPageGuard;
+  auto FetchPageWrite(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> WritePageGuard;
+
+  /**
+   * @brief Look at a page without latching or pinning it, see OptimisticPageGuard.
+   *
+   * A resident page is found without taking any latch, unless the shard's access log is full. Otherwise the page is
+   * read in like FetchPage() does and unpinned again before returning.
+   *
+   * @param page_id, the id of the page to fetch
+   * @param access_type, type of access to the page, see FetchPage()
+   * @return a guard for the page, which fails Validate() if the page could not be fetched
+   */
+  auto FetchPageOptimistic(page_id_t page_id, AccessType access_type = AccessType::Unknown) -> OptimisticPageGuard;
 
   /**
    * TODO(P1): Add implementation
@@ -132,11 +202,21 @@ class BufferPoolManager {
    *
    * @param page_id id of page to be unpinned
    * @param is_dirty true if the page should be marked as dirty, false otherwise
-   * @param access_type type of access to the page, only needed for leaderboard tests.
+   * @param access_type type of access to the page. Unused, accesses are recorded when the page is fetched.
    * @return false if the page is not in the page table or its pin count is <= 0 before this call, true otherwise
    */
   auto UnpinPage(page_id_t page_id, bool is_dirty, AccessType access_type = AccessType::Unknown) -> bool;
 
+  /**
+   * @brief Unpin a page the caller got from NewPage() or FetchPage(), without a page table lookup and without taking
+   * any latch. The page guards drop their pin this way.
+   *
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the pin count of the page is <= 0 before this call, true otherwise
+   */
+  auto UnpinPage(Page *page, bool is_dirty) -> bool;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -145,6 +225,9 @@ class BufferPoolManager {
    * Use the DiskManager::WritePage() method to flush a page to disk, REGARDLESS of the dirty flag.
    * Unset the dirty flag of the page after flushing.
    *
+   * The page stays pinned during the write, which runs without the shard latch, so that the other pages of the shard
+   * are served meanwhile.
+   *
    * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
    * @return false if the page could not be found in the page table, true otherwise
    */
@@ -160,53 +243,376 @@ class BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool and free it on disk. If page_id is not in the buffer pool, only free it
+   * on disk and return true. If the page is pinned and cannot be deleted, return false immediately.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
-   * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * back to the free list. Also, reset the page's memory and metadata. Finally, call DeallocatePage() to free the
+   * page on the disk, so that a later NewPage() may reuse its page id.
    *
    * @param page_id id of page to be deleted
    * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
    */
   auto DeletePage(page_id_t page_id) -> bool;
 
+  /**
+   * @brief Read the given pages into the buffer pool in the background, so that fetching them later does not have to
+   * wait for the disk.
+   *
+   * The pages are queued for a background I/O thread, which is started by the first call. Pages that are resident or
+   * already being read are skipped, and so are pages whose shard has no free or evictable frame at that time.
+   * Prefetched pages are not pinned, so they may be evicted again before they are fetched (see
+   * LRUKReplacer::RecordPrefetch()).
+   *
+   * @param page_ids ids of the pages to read, in the order they will be needed
+   */
+  void Prefetch(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Check whether fetching a page would be served from memory.
+   * @param page_id id of the page to check
+   * @return true if the page is in the buffer pool and no disk I/O is in progress on its frame
+   */
+  auto IsPageResident(page_id_t page_id) -> bool;
+
+  /**
+   * @brief Start a background thread that writes dirty frames back before they are chosen as victims, so that
+   * NewPage() and FetchPage() rarely have to write a page before reusing its frame.
+   *
+   * Every interval, the flusher looks at the next clean_share * (shard size) frames in each shard's eviction order and
+   * writes the dirty ones back. Pages with adjacent ids are written with a single DiskManager::WritePages() call. Does
+   * nothing if the flusher is already running.
+   *
+   * @param clean_share share of each shard's frames to keep clean at the head of the eviction order, in (0, 1]
+   * @param interval time between two rounds of the flusher
+   */
+  void StartBackgroundFlusher(double clean_share = 0.25,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+  /** @brief Stop the background flusher and wait for its current round to finish. */
+  void StopBackgroundFlusher();
+
+  /** @return the number of dirty pages NewPage() and FetchPage() had to write back to reuse their frame */
+  auto GetForegroundWriteCount() -> size_t { return foreground_write_cnt_; }
+
+  /** @return the number of pages written by the background flusher */
+  auto GetBackgroundWriteCount() -> size_t { return background_write_cnt_; }
+
+  /** @return a snapshot of the hit, miss, eviction and write-back counters of the buffer pool, summed over shards */
+  auto GetStats() -> BufferPoolStats;
+
+  /**
+   * @brief Collect the latch counters of all frames, see Page::GetLatchStats(). They stay zero unless the latch was
+   * built with BUSTUB_RWLATCH=hybrid.
+   * @return the id of the page in each frame, INVALID_PAGE_ID for a free one, with the counters of the frame's latch
+   */
+  auto GetLatchStats() -> std::vector<std::pair<page_id_t, LatchStats>>;
+
  private:
+  /**
+   * A partition of the buffer pool. The shard owns the frames [frame_offset_, frame_offset_ + num_frames_) of pages_.
+   * The page table and the free lists store global frame ids, the replacer works on shard-local frame ids.
+   *
+   * The frames are split into num_partitions contiguous partitions, partition i holds the frames of NUMA node i.
+   */
+  struct BufferPoolShard {
+    BufferPoolShard(frame_id_t frame_offset, size_t num_frames, size_t replacer_k, size_t num_partitions);
+
+    /** @return the replacer frame id of a global frame id owned by this shard */
+    auto LocalFrameId(frame_id_t frame_id) const -> frame_id_t { return frame_id - frame_offset_; }
+
+    /** @return the partition of a global frame id owned by this shard */
+    auto PartitionOf(frame_id_t frame_id) const -> size_t {
+      return static_cast<size_t>(LocalFrameId(frame_id)) * free_lists_.size() / num_frames_;
+    }
+
+    /** @return true if any partition has a free frame */
+    auto HasFreeFrame() const -> bool;
+
+    /** @brief Put a frame back on the free list of its partition. */
+    void PushFreeFrame(frame_id_t frame_id) { free_lists_[PartitionOf(frame_id)].push_back(frame_id); }
+
+    /**
+     * @brief Take a free frame, from the given partition if it has one. The shard must have a free frame.
+     * @param partition the preferred partition, may be out of range to prefer none
+     */
+    auto PopFreeFrame(size_t partition) -> frame_id_t;
+    /** @brief Add a page to the page table and to the page index. Caller must hold latch_. */
+    void MapPage(page_id_t page_id, frame_id_t frame_id);
+    /** @brief Remove a page from the page table and from the page index. Caller must hold latch_. */
+    void UnmapPage(page_id_t page_id);
+    /**
+     * @brief Look a page up in the page index, without any latch. The answer may be stale, or miss a resident page, so
+     * the caller must check the frame's page id before it trusts the frame.
+     * @return the frame that held the page when the index was last updated, or INVALID_FRAME_ID
+     */
+    auto FindFrame(page_id_t page_id) const -> frame_id_t;
+    /**
+     * @brief Append a page hit to the access log, without any latch.
+     * @return false if the log is full, then the hit has to be logged under latch_ with LogAccess()
+     */
+    auto TryLogAccess(frame_id_t frame_id, AccessType access_type) -> bool;
+    /** @return the first slot of the page index bucket of a page */
+    auto IndexBucket(page_id_t page_id) const -> std::atomic<uint64_t> * {
+      auto hash = static_cast<uint32_t>(page_id) * 0x9E3779B1U;
+      return &page_index_[(static_cast<uint64_t>(hash) * page_index_buckets_ >> 32) * PAGE_INDEX_WAYS];
+    }
+    /** Number of slots of a page index bucket, one cache line worth of them. */
+    static constexpr size_t PAGE_INDEX_WAYS = 8;
+    /** Marks a free slot of the page index and of the access log. */
+    static constexpr uint64_t EMPTY_SLOT = ~uint64_t{0};
+
+    /** Index of the first frame owned by this shard. */
+    const frame_id_t frame_offset_;
+    /** Number of frames owned by this shard. */
+    const size_t num_frames_;
+    /** Page table for keeping track of the pages cached by this shard. */
+    std::unordered_map<page_id_t, frame_id_t> page_table_;
+    /**
+     * A copy of page_table_ that readers search without latch_, in buckets of PAGE_INDEX_WAYS slots. A slot holds a
+     * page id in its upper and a frame id in its lower half, or EMPTY_SLOT. A page whose bucket is full is left out and
+     * only found through page_table_.
+     */
+    std::unique_ptr<std::atomic<uint64_t>[]> page_index_;
+    /** Number of buckets of page_index_, about two slots per frame. */
+    size_t page_index_buckets_;
+    /** Replacer to find unpinned frames of this shard for replacement. */
+    std::unique_ptr<LRUKReplacer> replacer_;
+    /** Lists of free frames of this shard that don't have any pages on them, one per partition. */
+    std::vector<std::list<frame_id_t>> free_lists_;
+    /**
+     * Evicted pages whose write-back, or insertion into the second tier, is still running. They must not be read until
+     * it finished.
+     */
+    std::unordered_set<page_id_t> write_back_pages_;
+    /** Protects the fields above, and the book-keeping fields of the pages held by this shard. */
+    std::mutex latch_;
+    /** Signalled whenever an in-flight frame becomes ready or a write-back finishes. */
+    std::condition_variable io_cv_;
+    /**
+     * Page hits not yet recorded in the replacer or counted in stats_. A ring of ACCESS_LOG_SIZE slots holding a frame
+     * id in the upper and an AccessType in the lower half, or EMPTY_SLOT. Hits append to it without any latch (see
+     * TryLogAccess()), ApplyAccessLog() consumes it under latch_.
+     */
+    std::unique_ptr<std::atomic<uint64_t>[]> access_log_;
+    /** Index of the next slot a hit claims. */
+    std::atomic<size_t> access_log_tail_{0};
+    /** Index of the next slot ApplyAccessLog() consumes. Only written under latch_. */
+    std::atomic<size_t> access_log_head_{0};
+    /**
+     * Frames whose pin count dropped to zero without the shard latch and that the replacer may still consider pinned.
+     * A ring of num_frames_ slots holding global frame ids, INVALID_FRAME_ID marks a free slot. Unpinners append to it
+     * without any latch, ApplyAccessLog() consumes it under latch_. A frame is in the ring at most once (see
+     * Page::unpin_logged_), so the ring never overflows.
+     */
+    std::unique_ptr<std::atomic<frame_id_t>[]> unpin_log_;
+    /** Index of the next slot an unpinner claims. */
+    std::atomic<size_t> unpin_log_tail_{0};
+    /** Index of the next slot ApplyAccessLog() consumes. Protected by latch_. */
+    size_t unpin_log_head_{0};
+    /**
+     * The counters of this shard, except for the write counts kept by the buffer pool. Hits are counted once they leave
+     * the access log. Protected by latch_.
+     */
+    BufferPoolStats stats_;
+  };
+
+  /** Marks a free slot of a shard's unpin log, and a frame that could not be acquired. */
+  static constexpr frame_id_t INVALID_FRAME_ID = -1;
+
+  /**
+   * @brief Claim an unpinned frame for the shard, so that lock-free hits can't pin it while it is given another page or
+   * freed. The claim is released by setting the pin count again. Caller must hold the shard latch.
+   * @return false if the frame is pinned
+   */
+  static auto ClaimFrame(Page *page) -> bool {
+    int unpinned = 0;
+    return page->pin_count_.compare_exchange_strong(unpinned, -1);
+  }
+
+  /**
+   * @brief Pin a resident page without any latch. The frame is found through the shard's page index and pinned unless
+   * it is claimed, then its page id is checked again. Pages that are in-flight are left to the slow path, which waits
+   * for them under the shard latch.
+   * @return the pinned page, or nullptr if the caller has to take the shard latch
+   */
+  auto TryPinResident(BufferPoolShard *shard, page_id_t page_id, AccessType access_type) -> Page *;
+
+  /** @return the shard that caches the given page */
+  auto GetShard(page_id_t page_id) -> BufferPoolShard & {
+    return *shards_[static_cast<size_t>(page_id) % shards_.size()];
+  }
+
+  /** @return the shard that owns the given frame, found from the frame alone, without looking at the page in it */
+  auto GetFrameShard(frame_id_t frame_id) -> BufferPoolShard & {
+    // The first (pool_size_ % shards) shards own one frame more than the others, see the constructor.
+    size_t frames = pool_size_ / shards_.size();
+    size_t larger = pool_size_ % shards_.size();
+    auto frame = static_cast<size_t>(frame_id);
+    if (frame < larger * (frames + 1)) {
+      return *shards_[frame / (frames + 1)];
+    }
+    return *shards_[larger + (frame - larger * (frames + 1)) / frames];
+  }
+
+  /**
+   * @brief Bring the replacer of a shard up to date: record the buffered page hits, and make the frames of the unpin
+   * log evictable if they are still unpinned. Caller must hold the shard latch.
+   */
+  void ApplyAccessLog(BufferPoolShard *shard);
+
+  /**
+   * @brief Note a page hit in the shard's access log, applying the log when it is full. Caller must hold the shard
+   * latch.
+   */
+  void LogAccess(BufferPoolShard *shard, frame_id_t frame_id, AccessType access_type);
+
+  /**
+   * @return true if a frame can be taken from the free list or the replacer. Applies the access log first, so that
+   * the replacer knows about every unpinned frame. Caller must hold the shard latch.
+   */
+  auto HasAvailableFrame(BufferPoolShard *shard) -> bool;
+
+  /**
+   * @brief Take a frame from the shard's free list, or evict one with the replacer, and remove the victim from the page
+   * table. A dirty victim is not written back here, nor is a victim put into the second tier: their ids are returned
+   * and recorded in the shard's write_back_pages_, the caller must pass them to FillFrame(). Caller must hold the shard
+   * latch and have checked HasAvailableFrame(shard). The frame is returned claimed (see ClaimFrame()): the caller sets
+   * its page id, marks it in-flight and then pins it.
+   * @param[out] write_back_page_id the dirty page still held by the frame, or INVALID_PAGE_ID
+   * @param[out] cache_page_id the page held by the frame that goes to the second tier, or INVALID_PAGE_ID
+   * @return the global id of the frame, or INVALID_FRAME_ID if lock-free hits have pinned every victim
+   */
+  auto AcquireFrame(BufferPoolShard *shard, page_id_t *write_back_page_id, page_id_t *cache_page_id) -> frame_id_t;
+
+  /** @brief Count a frame taken by a thread on the given node as local or remote. Caller must hold the shard latch. */
+  void CountFrameLocality(BufferPoolShard *shard, frame_id_t frame_id, size_t node) {
+    if (shard->PartitionOf(frame_id) == node) {
+      shard->stats_.local_frames_++;
+    } else {
+      shard->stats_.remote_frames_++;
+    }
+  }
+
+  /**
+   * @brief Fill a frame returned by AcquireFrame(): write back its old page and put it into the second tier if needed,
+   * then zero it and optionally read its new page, from the second tier if it is there. The caller must have installed
+   * the new page id in the page table, marked the frame in-flight and pinned it. If there is I/O or compression to do,
+   * the shard latch is released meanwhile; it is held again when this returns, the frame is no longer in-flight, and
+   * waiters have been notified.
+   * @return true if the new page was read from the second tier
+   */
+  auto FillFrame(BufferPoolShard *shard, std::unique_lock<std::mutex> *lock, Page *page, page_id_t write_back_page_id,
+                 page_id_t cache_page_id, bool read_page) -> bool;
+
+  /** @brief Body of the prefetch thread, reads queued pages until the buffer pool is destroyed. */
+  void PrefetchLoop();
+
+  /**
+   * @brief Read pages into unpinned frames, skipping those that are already there or whose shard is full. The reads,
+   * and the write-backs of dirty victims before them, go to the disk manager as one batch each.
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /**
+   * @brief Hand a batch of requests to the disk manager. If Submit() throws, the requests it did not take break
+   * their promises, so their futures report the failure instead.
+   */
+  void SubmitRequests(std::vector<DiskRequest> requests);
+
+  /** @brief Body of the background flusher thread. */
+  void FlusherLoop(double clean_share, std::chrono::milliseconds interval);
+
+  /**
+   * @brief Write back the dirty frames among the next max_frames eviction candidates of a shard, with one request per
+   * run of adjacent page ids, submitted to the disk manager as one batch.
+   */
+  void CleanShard(BufferPoolShard *shard, size_t max_frames);
+
+  /**
+   * @brief Take a frame whose page could not be read out of the page table and drop the caller's pin on it. Pins held
+   * by FetchPage() calls waiting for the frame are dropped by those calls, whoever drops the last one puts the frame
+   * back on the free list. Caller must hold the shard latch.
+   */
+  void FailFrame(BufferPoolShard *shard, Page *page);
+
+  /**
+   * @brief Give a frame whose victim could not be written back to the victim again, dirty as it was, and drop the
+   * caller's pin on it. Pins held by FetchPage() calls waiting for the frame are dropped by those calls. Caller must
+   * hold the shard latch.
+   */
+  void RestoreVictim(BufferPoolShard *shard, Page *page, page_id_t victim_page_id);
+
+  /**
+   * @brief Drop a pin on a failed frame. With the last one, the frame goes back to the free list, or becomes evictable
+   * if it holds its victim again. Caller must hold the shard latch.
+   */
+  void UnpinFailedFrame(BufferPoolShard *shard, Page *page);
+
+  /**
+   * @brief Drop the pin that a write outside the shard latch held on a frame, and wake up whoever waits for the write.
+   * Caller must hold the shard latch.
+   */
+  void FinishWrite(BufferPoolShard *shard, Page *page);
+
+  /** @brief Block until the frame is no longer in-flight. The caller must have pinned it. */
+  void WaitForIo(BufferPoolShard *shard, std::unique_lock<std::mutex> *lock, Page *page) {
+    shard->io_cv_.wait(*lock, [page] { return !page->io_in_progress_; });
+  }
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
-  std::atomic<page_id_t> next_page_id_ = 0;
-
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The data of the buffer pool pages. */
+  std::unique_ptr<FrameArena> arena_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
-  /** Replacer to find unpinned pages for replacement. */
-  std::unique_ptr<LRUKReplacer> replacer_;
-  /** List of free frames that don't have any pages on them. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::mutex latch_;
+  /** The partitions of the buffer pool. */
+  std::vector<std::unique_ptr<BufferPoolShard>> shards_;
+  /** Compressed copies of evicted pages, nullptr if the buffer pool has no second tier. */
+  std::unique_ptr<CompressedPageCache> second_tier_;
+  /** How the frames are placed on the NUMA nodes. */
+  const NumaMode numa_mode_;
+
+  /** Protects the prefetch queue and the prefetch thread. */
+  std::mutex prefetch_latch_;
+  /** Signalled when pages are queued for prefetching or the buffer pool is destroyed. */
+  std::condition_variable prefetch_cv_;
+  /** Pages waiting to be prefetched, at most pool_size_ entries. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** Set by the destructor to stop the prefetch thread. */
+  bool prefetch_stop_{false};
+  /** Reads the pages of prefetch_queue_ in batches, started by the first Prefetch() call. */
+  std::thread prefetch_thread_;
+
+  /** Protects the flusher thread. */
+  std::mutex flusher_latch_;
+  /** Signalled to stop the flusher. */
+  std::condition_variable flusher_cv_;
+  /** Set by StopBackgroundFlusher() to stop the flusher thread. */
+  bool flusher_stop_{false};
+  /** Writes dirty frames back ahead of eviction, see StartBackgroundFlusher(). */
+  std::thread flusher_thread_;
+
+  /** Number of dirty victims written back by NewPage() and FetchPage(). */
+  std::atomic<size_t> foreground_write_cnt_{0};
+  /** Number of pages written by the background flusher. */
+  std::atomic<size_t> background_write_cnt_{0};
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Allocate a page on disk, reusing a deallocated one if there is any.
    * @return the id of the allocated page
    */
-  auto AllocatePage() -> page_id_t;
+  auto AllocatePage() -> page_id_t { return disk_manager_->AllocatePage(); }
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Deallocate a page on disk, so that AllocatePage() can hand it out again. Caller should acquire the latch
+   * before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
-
-  // TODO(student): You may add additional private members and helper functions
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
 };
 }  // namespace bustub
@@ -0,0 +1,146 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_stats.h
+//
+// Identification: src/include/buffer/buffer_pool_stats.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <chrono>  // NOLINT
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "buffer/lru_k_replacer.h"
+
+namespace bustub {
+
+/** The number of AccessType values. */
+static constexpr size_t NUM_ACCESS_TYPES = 3;
+
+/** @return the name of an access type, e.g. "scan" */
+auto AccessTypeToString(AccessType access_type) -> std::string;
+
+/**
+ * LatencyHistogram counts latencies in power-of-two buckets of microseconds: bucket 0 holds latencies below 1 us,
+ * bucket i those in [2^(i-1), 2^i) us, and the last bucket everything longer.
+ */
+struct LatencyHistogram {
+  static constexpr size_t NUM_BUCKETS = 24;
+
+  /** @brief Count one latency. */
+  void Record(std::chrono::nanoseconds latency);
+
+  /** @return the number of latencies counted */
+  auto Count() const -> uint64_t;
+
+  /**
+   * @param percentile in [0, 100]
+   * @return the upper bound of the bucket that holds the given percentile in microseconds, 0 if nothing was counted
+   */
+  auto Percentile(double percentile) const -> uint64_t;
+
+  /** @return the exclusive upper bound of a bucket in microseconds */
+  static auto BucketUpperBound(size_t bucket) -> uint64_t { return uint64_t{1} << bucket; }
+
+  auto operator+=(const LatencyHistogram &other) -> LatencyHistogram &;
+
+  std::array<uint64_t, NUM_BUCKETS> buckets_{};
+};
+
+/** A snapshot of the counters of a CompressedPageCache. */
+struct SecondTierStats {
+  /** The most compressed bytes the cache holds. */
+  size_t budget_bytes_{0};
+  /** Compressed bytes held right now. */
+  size_t used_bytes_{0};
+  /** Pages held right now. */
+  size_t pages_{0};
+  /** Lookups served from the cache. */
+  uint64_t hits_{0};
+  /** Lookups of pages the cache did not hold. */
+  uint64_t misses_{0};
+  /** Pages stored. */
+  uint64_t inserts_{0};
+  /** Pages dropped to stay within the budget. */
+  uint64_t evictions_{0};
+  /** Pages not stored because they did not compress. */
+  uint64_t rejects_{0};
+
+  /** @return the share of lookups served from the cache, 0 if there were none */
+  auto HitRatio() const -> double {
+    return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(hits_ + misses_);
+  }
+};
+
+/** A snapshot of the counters of a buffer pool, see BufferPoolManager::GetStats(). */
+struct BufferPoolStats {
+  /** The counters of the FetchPage() calls with one access type. */
+  struct AccessStats {
+    /** Fetches served from the buffer pool. */
+    uint64_t hits_{0};
+    /** Fetches that had to read the page, from the second tier or from disk. */
+    uint64_t misses_{0};
+    /** Misses served from the second tier instead of the disk. */
+    uint64_t second_tier_hits_{0};
+    /** Misses that evicted another page to make room. */
+    uint64_t evictions_{0};
+    /** Misses whose victim was dirty and had to be written back first. */
+    uint64_t write_backs_{0};
+    /** Misses that failed because every frame of the shard was pinned. */
+    uint64_t failures_{0};
+    /** Time the successful misses took, including the write-back of their victim. */
+    LatencyHistogram miss_latency_;
+
+    /** @return the share of fetches served from the buffer pool, 0 if there were none */
+    auto HitRatio() const -> double {
+      return hits_ + misses_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(hits_ + misses_);
+    }
+
+    /** @return the share of misses served from the second tier, 0 if there were none */
+    auto SecondTierHitRatio() const -> double {
+      return misses_ == 0 ? 0 : static_cast<double>(second_tier_hits_) / static_cast<double>(misses_);
+    }
+
+    auto operator+=(const AccessStats &other) -> AccessStats &;
+  };
+
+  /** @return the counters of one access type */
+  auto Access(AccessType access_type) -> AccessStats & { return accesses_[static_cast<size_t>(access_type)]; }
+  auto Access(AccessType access_type) const -> const AccessStats & {
+    return accesses_[static_cast<size_t>(access_type)];
+  }
+
+  /** @return the counters of all access types added up */
+  auto AllAccesses() const -> AccessStats;
+
+  auto operator+=(const BufferPoolStats &other) -> BufferPoolStats &;
+
+  /** The counters of FetchPage(), indexed by AccessType. */
+  std::array<AccessStats, NUM_ACCESS_TYPES> accesses_;
+  /** Pages created by NewPage(). */
+  uint64_t new_pages_{0};
+  /** NewPage() calls that failed because every frame of the shard was pinned. */
+  uint64_t new_page_failures_{0};
+  /** Pages evicted by fetches, NewPage() and prefetching. */
+  uint64_t evictions_{0};
+  /** Dirty victims written back by fetches, NewPage() and prefetching. */
+  uint64_t foreground_writes_{0};
+  /** Pages written back by the background flusher. */
+  uint64_t background_writes_{0};
+  /** Frames taken (free or evicted) from the partition of the calling thread's NUMA node, see NumaMode::Partition. */
+  uint64_t local_frames_{0};
+  /** Frames taken from the partition of another NUMA node. */
+  uint64_t remote_frames_{0};
+  /** The counters of the second tier, all zero if the buffer pool has none. */
+  SecondTierStats second_tier_;
+};
+
+}  // namespace bustub
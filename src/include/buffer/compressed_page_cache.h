@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_stats.h"
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is the optional second tier of a BufferPoolManager: it keeps LZ4-compressed copies of pages the
+ * buffer pool evicted, within a budget of compressed bytes, so that fetching them again costs a decompression instead
+ * of a disk read.
+ *
+ * The cache is exclusive: a page is either in a frame or in the cache, Take() removes the copy it returns. The buffer
+ * pool inserts each victim once it is clean, so a copy is never newer than the disk, and may be dropped at any time.
+ * When the budget is exceeded, the least recently inserted pages are dropped.
+ */
+class CompressedPageCache {
+ public:
+  /**
+   * @param budget_bytes the most compressed bytes to hold
+   */
+  explicit CompressedPageCache(size_t budget_bytes);
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * @brief Store a copy of a page, replacing an older copy of it. Pages that don't compress are not stored.
+   * @param page_id the id of the page
+   * @param data the data of the page, BUSTUB_PAGE_SIZE bytes
+   */
+  void Insert(page_id_t page_id, const char *data);
+
+  /**
+   * @brief Remove a page from the cache and decompress it.
+   * @param page_id the id of the page
+   * @param[out] data the buffer for the page, BUSTUB_PAGE_SIZE bytes
+   * @return false if the cache does not hold the page, data is unchanged then
+   */
+  auto Take(page_id_t page_id, char *data) -> bool;
+
+  /** @brief Drop the copy of a page, if there is one. */
+  void Erase(page_id_t page_id);
+
+  /** @return a snapshot of the counters of the cache */
+  auto GetStats() -> SecondTierStats;
+
+ private:
+  struct Entry {
+    std::vector<char> data_;
+    /** The position of the page in lru_list_. */
+    std::list<page_id_t>::iterator lru_it_;
+  };
+
+  /** Remove an entry. Caller must hold latch_. @return the compressed data of the entry */
+  auto EraseEntry(std::unordered_map<page_id_t, Entry>::iterator it) -> std::vector<char>;
+
+  /** Protects all fields below. */
+  std::mutex latch_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  /** The cached pages, least recently inserted first. */
+  std::list<page_id_t> lru_list_;
+  SecondTierStats stats_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the data of all frames of a buffer pool in one zeroed, page-aligned allocation. Arenas of 2 MB or
+ * more are backed by huge pages, which cuts the TLB misses of a pool that is touched all over: by explicit huge pages
+ * (MAP_HUGETLB) if the system has reserved any, and by transparent huge pages otherwise.
+ *
+ * In builds with AddressSanitizer, every frame is followed by a poisoned gap of one page, so that a page overflow is
+ * still caught even though the frames are not separate allocations.
+ */
+class FrameArena {
+ public:
+  /**
+   * Allocates the arena.
+   * @param frame_cnt the number of frames
+   */
+  explicit FrameArena(size_t frame_cnt);
+
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of frame frame_id, BUSTUB_PAGE_SIZE bytes */
+  auto GetFrame(size_t frame_id) -> char *;
+
+  /**
+   * @brief Place the data of some frames on a NUMA node, see NumaUtil::BindMemory(). Only affects frames that have not
+   * been touched yet.
+   * @return false if the frames could not be placed, e.g. because the node does not exist
+   */
+  auto BindFrames(size_t first_frame, size_t frame_cnt, size_t node) -> bool;
+
+  /**
+   * @brief Spread the data of all frames over the NUMA nodes, see NumaUtil::InterleaveMemory(). Only affects frames
+   * that have not been touched yet.
+   * @return false if the frames could not be placed, e.g. on a single-node machine
+   */
+  auto InterleaveFrames() -> bool;
+
+  /** @return true if the arena is backed by explicit huge pages */
+  auto UsesHugePages() const -> bool { return huge_pages_; }
+
+  /** The size of a huge page on x86-64 and most ARM configurations. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+ private:
+  char *base_{nullptr};
+  /** The size of the mapping at base_. */
+  size_t size_{0};
+  bool huge_pages_{false};
+};
+
+}  // namespace bustub
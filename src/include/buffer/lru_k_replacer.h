@@ -14,11 +14,7 @@
 
 #include <cstddef>
 #include <limits>
-#include <list>
-#include <memory>
 #include <mutex>  // NOLINT
-#include <unordered_map>
-#include <utility>
 #include <vector>
 
 #include "common/config.h"
@@ -28,34 +24,6 @@ namespace bustub {
 
 enum class AccessType { Unknown = 0, Get, Scan };
 
-class LRUKNode {
- public:
-  explicit LRUKNode(size_t k, frame_id_t fid) : k_(k), fid_(fid) {}
-  void PushFront(size_t timestamp) { history_.push_front(timestamp); }
-  auto BackK() -> size_t {
-    if (history_.size() < k_) {
-      return 0;
-    }
-    auto it = history_.begin();
-    for (size_t i = 0; i < k_ - 1; i++) {
-      it++;
-    }
-    return *it;
-  }
-  auto GetFid() -> frame_id_t { return fid_; }
-  auto GetEvictable() -> bool { return is_evictable_; }
-  void SetEvictable(bool value) { is_evictable_ = value; }
-
- private:
-  /** History of last seen K timestamps of this page. Least recent timestamp stored in front. */
-  // Remove maybe_unused if you start using them. Feel free to change the member variables as you want.
-
-  std::list<size_t> history_;
-  size_t k_;
-  frame_id_t fid_;
-  bool is_evictable_{false};
-};
-
 /**
  * LRUKReplacer implements the LRU-k replacement policy.
  *
@@ -66,6 +34,15 @@ class LRUKNode {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multipe frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Frames that have only ever been accessed by scans (AccessType::Scan) are evicted before all
+ * others, least recently used first, so a large sequential scan recycles its own frames instead
+ * of flushing the working set. A scan access to a frame that has had other accesses is ignored.
+ *
+ * All metadata lives in arrays sized for num_frames when the replacer is created: the last k
+ * access timestamps of every frame are kept in a ring, and the evictable frames are kept in an
+ * indexed binary min-heap ordered by eviction priority. Evict, RecordAccess, SetEvictable and
+ * Remove are O(log n) and never allocate.
  */
 class LRUKReplacer {
  public:
@@ -115,11 +92,22 @@ class LRUKReplacer {
    * also use BUSTUB_ASSERT to abort the process if frame id is invalid.
    *
    * @param frame_id id of frame that received a new access.
-   * @param access_type type of access that was received. This parameter is only needed for
-   * leaderboard tests.
+   * @param access_type type of access that was received. Scan accesses do not promote a frame
+   * out of the scan class, see the class comment.
    */
   void RecordAccess(frame_id_t frame_id, AccessType access_type = AccessType::Unknown);
 
+  /**
+   * @brief Start tracking a frame that was filled by read-ahead and has not been accessed yet.
+   *
+   * Until its first access, the frame is ordered like a frame with a single access at the current timestamp, so that
+   * it is not evicted ahead of the scan-only frames that the reader is done with. The first RecordAccess() then
+   * starts the frame's history as if the prefetch never happened.
+   *
+   * @param frame_id id of a frame that is not tracked yet
+   */
+  void RecordPrefetch(frame_id_t frame_id);
+
   /**
    * TODO(P1): Add implementation
    *
@@ -167,18 +155,50 @@ class LRUKReplacer {
    */
   auto Size() -> size_t;
 
+  /**
+   * @brief List the frames that Evict() would return next, without evicting them.
+   * @param max_frames the maximum number of frames to return
+   * @return up to max_frames evictable frames, next victim first
+   */
+  auto EvictionCandidates(size_t max_frames) -> std::vector<frame_id_t>;
+
  private:
-  // TODO(student): implement me! You can replace these member variables as you like.
-  // Remove maybe_unused if you start using them.
-  std::unordered_map<frame_id_t, std::shared_ptr<LRUKNode>> node_store_;
-  std::list<frame_id_t> temp_pool_;
-  std::unordered_map<frame_id_t, std::list<frame_id_t>::iterator> temp_pool_map_;
-  std::list<std::pair<frame_id_t, size_t>> cache_pool_;
-  std::unordered_map<frame_id_t, std::list<std::pair<frame_id_t, size_t>>::iterator> cache_pool_map_;
+  /** Position in heap_ of a frame that is not evictable. */
+  static constexpr size_t INVALID_HEAP_POS = std::numeric_limits<size_t>::max();
+
+  /** @brief Throw if frame_id is not in [0, replacer_size_). */
+  void CheckFrameId(frame_id_t frame_id) const;
+  /** @return true if lhs should be evicted before rhs */
+  auto EvictsBefore(frame_id_t lhs, frame_id_t rhs) const -> bool;
+  /**
+   * @return the timestamp that orders a frame within its class: the most recent access for scan-only frames, the
+   * first access for frames with less than k accesses, the k-th most recent access otherwise
+   */
+  auto EvictionTimestamp(frame_id_t frame_id) const -> size_t;
+
+  void HeapPush(frame_id_t frame_id);
+  void HeapErase(frame_id_t frame_id);
+  void HeapSwap(size_t a, size_t b);
+  void SiftUp(size_t pos);
+  void SiftDown(size_t pos);
+
   size_t current_timestamp_{0};
-  size_t evictable_size_{0};
   size_t replacer_size_;
   size_t k_;
+  /** Ring of the last k access timestamps of each frame, frame i owns [i * k, (i + 1) * k). */
+  std::vector<size_t> history_;
+  /** Number of recorded accesses of each frame, saturated at k. Zero means the frame is not tracked. */
+  std::vector<size_t> access_count_;
+  /** Next slot of each frame's ring to be written. */
+  std::vector<size_t> history_pos_;
+  /** Whether each tracked frame has only seen scan accesses so far. */
+  std::vector<bool> scan_only_;
+  /** Whether each tracked frame was filled by RecordPrefetch() and has not been accessed since. */
+  std::vector<bool> prefetched_;
+  /** Min-heap of the evictable frames, the next victim is at the front. */
+  std::vector<frame_id_t> heap_;
+  /** Position of each frame in heap_, or INVALID_HEAP_POS if the frame is not evictable. */
+  std::vector<size_t> heap_pos_;
   std::mutex latch_;
 };
 
@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// read_ahead_window.h
+//
+// Identification: src/include/buffer/read_ahead_window.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * ReadAheadWindow keeps the next pages of a page chain (table heap pages, B+ tree leaves) prefetched ahead of a
+ * sequential iterator.
+ *
+ * The id of a page is only known once the page before it has been read, so the window is extended one page at a
+ * time: the frontier page is prefetched with BufferPoolManager::Prefetch(), and once it is resident the window reads
+ * its successor's id from it and moves on. The iterator itself keeps fetching its pages as usual.
+ */
+class ReadAheadWindow {
+ public:
+  /** Returns the id of the page following the page whose data is given, or INVALID_PAGE_ID at the end of the chain. */
+  using NextPageIdFn = page_id_t (*)(const char *page_data);
+
+  ReadAheadWindow() = default;
+
+  /**
+   * @param bpm the buffer pool to prefetch into
+   * @param next_page_id_fn reads the next page id from a page of the chain
+   * @param window_size how many pages to stay ahead of the iterator
+   */
+  ReadAheadWindow(BufferPoolManager *bpm, NextPageIdFn next_page_id_fn, size_t window_size = READ_AHEAD_PAGES)
+      : bpm_(bpm), next_page_id_fn_(next_page_id_fn), window_size_(window_size) {}
+
+  /**
+   * @brief Tell the window that the iterator moved to the given page, and extend the window as far as the pages
+   * already read allow. The iterator must move along the chain one page at a time.
+   * @param page_id the page the iterator is on now
+   */
+  void Advance(page_id_t page_id);
+
+ private:
+  BufferPoolManager *bpm_{nullptr};
+  NextPageIdFn next_page_id_fn_{nullptr};
+  size_t window_size_{0};
+  /** Furthest page of the chain that has been requested, INVALID_PAGE_ID once the end of the chain is reached. */
+  page_id_t frontier_page_id_{INVALID_PAGE_ID};
+  /** Number of pages between the iterator and frontier_page_id_. */
+  size_t frontier_distance_{0};
+};
+
+}  // namespace bustub
@@ -196,12 +196,15 @@ class Catalog {
    * @param key_attrs Key attributes
    * @param keysize Size of the key
    * @param hash_function The hash function for the index
+   * @param include_attrs Columns stored in the index entries after the key, so that scans reading only the key and
+   * these columns need not fetch the rows. The key and the included columns together must fit in keysize.
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
                    const Schema &key_schema, const std::vector<uint32_t> &key_attrs, std::size_t keysize,
-                   HashFunction<KeyType> hash_function) -> IndexInfo * {
+                   HashFunction<KeyType> hash_function, const std::vector<uint32_t> &include_attrs = {})
+      -> IndexInfo * {
     // Reject the creation request for nonexistent table
     if (table_names_.find(table_name) == table_names_.end()) {
       return NULL_INDEX_INFO;
@@ -218,7 +221,7 @@ class Catalog {
     }
 
     // Construct index metdata
-    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
+    auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs, include_attrs);
 
     // Construct the index, take ownership of metadata
     // TODO(Kyle): We should update the API for CreateIndex
@@ -228,12 +231,16 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap, sorting them and building the tree bottom-up
     auto *table_meta = GetTable(table_name);
+    auto builder = index->MakeBuilder();
     for (auto iter = table_meta->table_->MakeIterator(); !iter.IsEnd(); ++iter) {
       auto [meta, tuple] = iter.GetTuple();
-      index->InsertEntry(tuple.KeyFromTuple(schema, key_schema, key_attrs), tuple.GetRid(), txn);
+      KeyType index_key;
+      index_key.SetFromKey(tuple.KeyFromTuple(schema, *index->GetEntrySchema(), index->GetEntryAttrs()));
+      builder->Add(index_key, tuple.GetRid());
     }
+    builder->Finish();
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
@@ -298,7 +305,7 @@ class Catalog {
    * @param index_oid The OID of the index for which to query
    * @return A (non-owning) pointer to the metadata for the index
    */
-  auto GetIndex(index_oid_t index_oid) -> IndexInfo * {
+  auto GetIndex(index_oid_t index_oid) const -> IndexInfo * {
     auto index = indexes_.find(index_oid);
     if (index == indexes_.end()) {
       return NULL_INDEX_INFO;
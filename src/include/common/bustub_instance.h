@@ -210,6 +210,16 @@ class FortTableWriter : public ResultWriter {
   std::vector<std::string> tables_;
 };
 
+/** The disk manager a BusTub instance stores its database file with. */
+enum class DiskBackend {
+  /** DiskManager, std::fstream based. */
+  Fstream,
+  /** DiskManagerPosix, positional I/O through the OS page cache. */
+  Posix,
+  /** DiskManagerPosix with O_DIRECT. */
+  PosixDirect,
+};
+
 class BustubInstance {
  private:
   /**
@@ -218,7 +228,7 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn, bool is_modify) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  explicit BustubInstance(const std::string &db_file_name, DiskBackend disk_backend = DiskBackend::Fstream);
 
   BustubInstance();
 
@@ -279,6 +289,7 @@ class BustubInstance {
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  void CmdDisplayBpmStats(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
 
   void HandleCreateStatement(Transaction *txn, const CreateStatement &stmt, ResultWriter &writer);
@@ -27,15 +27,27 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** The page size is fixed at build time, see BUSTUB_PAGE_SIZE in CMakeLists.txt. */
+#ifndef BUSTUB_PAGE_SIZE_BYTES
+#define BUSTUB_PAGE_SIZE_BYTES 4096  // NOLINT
+#endif
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = BUSTUB_PAGE_SIZE_BYTES;                      // size of a data page in byte
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int READ_AHEAD_PAGES = 8;  // pages prefetched ahead of sequential iterators
+static constexpr int DISK_QUEUE_DEPTH = 32;  // page I/Os in flight at once in an asynchronous disk manager
+static constexpr int ACCESS_LOG_SIZE = 64;   // page hits buffered per shard before they reach the replacer
+static constexpr int BULK_LOAD_RUN_SIZE = 1 << 20;  // index entries sorted in memory at once by a bulk load
+static constexpr int BULK_LOAD_MERGE_WAYS = 8;      // sorted runs a bulk load merges at once, pinning a page each
+static constexpr double BULK_LOAD_FILL_FACTOR = 1.0;  // share of each page a bulk load fills
+static constexpr int VARLEN_KEY_MAX_SIZE = 512;  // longest key of a varlen B+ tree, so that every page holds several
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
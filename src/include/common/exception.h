@@ -49,6 +49,8 @@ enum class ExceptionType {
   NOT_IMPLEMENTED = 11,
   /** Execution exception. */
   EXECUTION = 12,
+  /** Data read from disk failed its integrity check. */
+  CORRUPTION = 13,
 };
 
 class Exception : public std::runtime_error {
@@ -109,6 +111,8 @@ class Exception : public std::runtime_error {
         return "Out of Memory";
       case ExceptionType::NOT_IMPLEMENTED:
         return "Not implemented";
+      case ExceptionType::CORRUPTION:
+        return "Corruption";
       default:
         return "Unknown";
     }
@@ -0,0 +1,133 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hybrid_latch.h
+//
+// Identification: src/include/common/hybrid_latch.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+/** A snapshot of the contention counters of a latch. */
+struct LatchStats {
+  /** The number of times the latch was acquired, in either mode. */
+  uint64_t acquisitions_{0};
+  /** The number of spin iterations spent waiting for the latch. */
+  uint64_t spins_{0};
+  /** The number of times a thread went to sleep waiting for the latch. */
+  uint64_t parks_{0};
+};
+
+/**
+ * HybridLatch is a reader-writer latch in a single 32-bit word. An uncontended acquire or release is one atomic
+ * instruction. A thread that finds the latch taken spins for a short while, as most page latches are held for a few
+ * hundred nanoseconds, and then parks on a futex until the latch is released. The number of spins adapts to how
+ * often spinning paid off on this latch, and is zero on a single CPU.
+ *
+ * If prefer_writers is set, new readers wait while a writer is waiting, so that a steady stream of readers can not
+ * starve the writers. A thread must then not take a read latch it already holds again.
+ *
+ * Every latch counts its acquisitions, spins and parks, see GetStats().
+ */
+class HybridLatch {
+ public:
+  explicit HybridLatch(bool prefer_writers = false) : prefer_writers_(prefer_writers) {}
+
+  DISALLOW_COPY_AND_MOVE(HybridLatch);
+
+  /** Acquire a write latch. */
+  void WLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & (WRITER | READER_MASK)) != 0 ||
+        !state_.compare_exchange_weak(state, (state | WRITER) & ~WRITER_WAITING, std::memory_order_acquire)) {
+      WLockSlow();
+    }
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Release a write latch. */
+  void WUnlock() {
+    if ((state_.fetch_and(~(WRITER | PARKED), std::memory_order_release) & PARKED) != 0) {
+      WakeAll();
+    }
+  }
+
+  /** Acquire a read latch. */
+  void RLock() {
+    uint32_t state = state_.load(std::memory_order_relaxed);
+    if ((state & ReaderBlockers()) != 0 || !state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire)) {
+      RLockSlow();
+    }
+    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /** Release a read latch. */
+  void RUnlock() {
+    uint32_t state = state_.fetch_sub(1, std::memory_order_release);
+    // Only the last reader can let anyone in.
+    if ((state & READER_MASK) == 1 && (state & PARKED) != 0 &&
+        (state_.fetch_and(~PARKED, std::memory_order_relaxed) & PARKED) != 0) {
+      WakeAll();
+    }
+  }
+
+  /** @return the contention counters of this latch */
+  auto GetStats() const -> LatchStats {
+    return {acquisitions_.load(std::memory_order_relaxed), spins_.load(std::memory_order_relaxed),
+            parks_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  /** Set while a writer holds the latch. */
+  static constexpr uint32_t WRITER = 1U << 31;
+  /** Set while a writer waits for the latch, when writers are preferred. */
+  static constexpr uint32_t WRITER_WAITING = 1U << 30;
+  /** Set if a thread may be parked on the latch, which then has to be woken up on release. */
+  static constexpr uint32_t PARKED = 1U << 29;
+  /** The number of readers holding the latch. */
+  static constexpr uint32_t READER_MASK = PARKED - 1;
+
+  /** The bits that keep a new reader out. */
+  auto ReaderBlockers() const -> uint32_t { return prefer_writers_ ? WRITER | WRITER_WAITING : WRITER; }
+
+  void WLockSlow();
+  void RLockSlow();
+
+  /**
+   * Spins once or parks until the latch is released, after it was found taken.
+   * @param state the state of the latch, as last seen
+   * @param spins the number of spins so far, incremented if this is a spin
+   * @return true if the thread was parked
+   */
+  auto Wait(uint32_t state, uint32_t *spins) -> bool;
+
+  /** Adjusts the spin limit after an acquire, and adds the spins to the counters. */
+  void Acquired(uint32_t spins, bool parked);
+
+  /** Wakes up all parked threads. */
+  void WakeAll();
+
+  std::atomic<uint32_t> state_{0};
+  /** How long a waiter spins before it parks. */
+  std::atomic<uint32_t> spin_limit_{INITIAL_SPIN_LIMIT};
+  bool prefer_writers_;
+
+  std::atomic<uint64_t> acquisitions_{0};
+  std::atomic<uint64_t> spins_{0};
+  std::atomic<uint64_t> parks_{0};
+
+  static constexpr uint32_t INITIAL_SPIN_LIMIT = 64;
+};
+
+}  // namespace bustub
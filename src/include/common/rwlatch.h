@@ -15,10 +15,27 @@
 #include <mutex>  // NOLINT
 #include <shared_mutex>
 
+#include "common/hybrid_latch.h"
 #include "common/macros.h"
 
 namespace bustub {
 
+#ifdef BUSTUB_HYBRID_RWLATCH
+
+/**
+ * Reader-Writer latch backed by HybridLatch, see BUSTUB_RWLATCH in CMakeLists.txt.
+ */
+class ReaderWriterLatch : public HybridLatch {
+ public:
+#ifdef BUSTUB_RWLATCH_PREFER_WRITERS
+  ReaderWriterLatch() : HybridLatch(true) {}
+#else
+  ReaderWriterLatch() : HybridLatch(false) {}
+#endif
+};
+
+#else
+
 /**
  * Reader-Writer latch backed by std::mutex.
  */
@@ -44,8 +61,15 @@ class ReaderWriterLatch {
    */
   void RUnlock() { mutex_.unlock_shared(); }
 
+  /**
+   * @return all zeros, this latch does not count its contention. Build with BUSTUB_RWLATCH=hybrid for that.
+   */
+  auto GetStats() const -> LatchStats { return {}; }
+
  private:
   std::shared_mutex mutex_;
 };
 
+#endif
+
 }  // namespace bustub
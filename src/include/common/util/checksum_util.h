@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.h
+//
+// Identification: src/include/common/util/checksum_util.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * ChecksumUtil provides the checksums used to detect corrupted or torn pages on disk.
+ */
+class ChecksumUtil {
+ public:
+  /**
+   * Compute the CRC32C (Castagnoli) checksum of a buffer. Uses the SSE4.2 / ARMv8 CRC instructions when the CPU has
+   * them, and a table-driven implementation otherwise.
+   * @param data the buffer
+   * @param size the size of the buffer in bytes
+   * @param crc the checksum of the data preceding the buffer, to checksum a buffer in pieces
+   * @return the checksum
+   */
+  static auto Crc32c(const char *data, size_t size, uint32_t crc = 0) -> uint32_t;
+
+  /** @return true if Crc32c() uses hardware instructions */
+  static auto HasHardwareCrc32c() -> bool;
+
+  /** The table-driven implementation of Crc32c(), exposed for testing. */
+  static auto Crc32cSoftware(const char *data, size_t size, uint32_t crc = 0) -> uint32_t;
+};
+
+}  // namespace bustub
@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.h
+//
+// Identification: src/include/common/util/compression_util.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * CompressionUtil provides a fast block compressor for in-memory copies of pages. The output is in the LZ4 block
+ * format, produced by a greedy single-pass matcher: it compresses less than the reference implementation, but any LZ4
+ * block decoder can read it.
+ */
+class CompressionUtil {
+ public:
+  /**
+   * Compress a buffer.
+   * @param src the data to compress
+   * @param size the size of the data in bytes
+   * @param[out] dst the buffer for the compressed data
+   * @param capacity the size of dst in bytes
+   * @return the size of the compressed data, or 0 if it does not fit into capacity bytes
+   */
+  static auto Lz4Compress(const char *src, size_t size, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * Decompress a buffer produced by Lz4Compress().
+   * @param src the compressed data
+   * @param size the size of the compressed data in bytes
+   * @param[out] dst the buffer for the decompressed data
+   * @param dst_size the size of the decompressed data in bytes
+   * @return false if src is malformed or does not decompress to exactly dst_size bytes
+   */
+  static auto Lz4Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool;
+};
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// numa_util.h
+//
+// Identification: src/include/common/util/numa_util.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace bustub {
+
+/** How a buffer pool places its frames on the NUMA nodes of the machine. */
+enum class NumaMode {
+  /** Leave placement to the operating system, usually the node of the thread that first touches a frame. */
+  None,
+  /** Spread the frames over all nodes. */
+  Interleave,
+  /** Split the frames of each shard into one partition per node, and prefer the fetching thread's partition. */
+  Partition,
+};
+
+/**
+ * NumaUtil reads the NUMA topology of the machine from /sys, places memory on nodes and pins threads to them, without
+ * depending on libnuma.
+ *
+ * For testing on single-node machines, a node count can be simulated: the CPUs are then dealt round-robin to the
+ * simulated nodes, and memory placement becomes a no-op for nodes that don't exist. Everything else behaves as on a
+ * machine with that many nodes.
+ */
+class NumaUtil {
+ public:
+  /** @return the number of NUMA nodes, the simulated one if there is one */
+  static auto NodeCount() -> size_t;
+
+  /** @return the number of NUMA nodes of the machine */
+  static auto SystemNodeCount() -> size_t;
+
+  /**
+   * @brief Simulate a machine with a number of NUMA nodes. Call this before any buffer pool is created.
+   * @param node_cnt the number of nodes, 0 to use the topology of the machine again
+   */
+  static void SimulateNodes(size_t node_cnt);
+
+  /** @return the CPUs of a node */
+  static auto NodeCpus(size_t node) -> std::vector<int>;
+
+  /** @return the node the calling thread is pinned to, or else the node of the CPU it is running on */
+  static auto CurrentNode() -> size_t;
+
+  /**
+   * @brief Pin the calling thread to the CPUs of one node. Workers are dealt round-robin to the nodes, and to the CPUs
+   * of their node, so that consecutive worker ids spread over the machine.
+   * @param worker_id the index of the worker thread
+   * @return the node the thread is pinned to
+   */
+  static auto PinThread(size_t worker_id) -> size_t;
+
+  /**
+   * @brief Ask the kernel to place the pages of a memory range on a node, where they are first touched. Falls back to
+   * other nodes when the node runs out of memory.
+   * @param addr the start of the range, page-aligned
+   * @param size the size of the range in bytes
+   * @param node the node
+   * @return false if the node does not exist on this machine or the kernel refused
+   */
+  static auto BindMemory(void *addr, size_t size, size_t node) -> bool;
+
+  /**
+   * @brief Ask the kernel to place the pages of a memory range round-robin on all nodes of the machine.
+   * @param addr the start of the range, page-aligned
+   * @param size the size of the range in bytes
+   * @return false if the machine has a single node or the kernel refused
+   */
+  static auto InterleaveMemory(void *addr, size_t size) -> bool;
+};
+
+}  // namespace bustub
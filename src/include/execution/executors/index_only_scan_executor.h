@@ -0,0 +1,47 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// index_only_scan_executor.h
+//
+// Identification: src/include/execution/executors/index_only_scan_executor.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/rid.h"
+#include "execution/executor_context.h"
+#include "execution/executors/index_scan_executor.h"
+#include "execution/plans/index_scan_plan.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * IndexOnlyScanExecutor executes an index scan whose rows are made from the index entries alone, without fetching
+ * them from the table. The columns the index stores, its key and included columns, are filled in from the entry, the
+ * others are NULL. Only the tuple metadata is read from the table, to skip entries of deleted rows.
+ */
+class IndexOnlyScanExecutor : public IndexScanExecutor {
+ public:
+  /**
+   * Creates a new index-only scan executor.
+   * @param exec_ctx the executor context
+   * @param plan the index scan plan to be executed, with index_only_ set
+   */
+  IndexOnlyScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan);
+
+  void Init() override;
+
+  auto Next(Tuple *tuple, RID *rid) -> bool override;
+
+ private:
+  /** Row values, with the columns the index does not store left NULL. */
+  std::vector<Value> values_;
+};
+}  // namespace bustub
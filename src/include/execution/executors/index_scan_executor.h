@@ -13,6 +13,7 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "common/rid.h"
@@ -42,7 +43,16 @@ class IndexScanExecutor : public AbstractExecutor {
 
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
- private:
+ protected:
+  /** Moves itr_ to the next pair in the key range, starting with the one it is on. @return false past the range */
+  auto SeekInRange() -> bool;
+
+  /**
+   * Moves itr_ to the next pair in the key range whose row is not deleted. An index built over a table holds entries
+   * of its deleted rows too. @return false past the range
+   */
+  auto SeekVisible() -> bool;
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
 
@@ -53,5 +63,20 @@ class IndexScanExecutor : public AbstractExecutor {
   BPlusTreeIndexForTwoIntegerColumn *tree_;
 
   BPlusTreeIndexIteratorForTwoIntegerColumn itr_;
+
+ private:
+  /**
+   * Builds the key a scan starts from: the bound in the first column, and the lowest or highest value of their type in
+   * the others, so that the scan starts before or after all keys with that first column.
+   */
+  auto MakeStartKey(const Value &bound, bool pad_with_max) -> IntegerKeyType;
+
+  /** Whether the first key column is below the lower bound, or above the upper bound. */
+  auto BelowRange(const Value &value) const -> bool;
+  auto AboveRange(const Value &value) const -> bool;
+
+  /** The values of the key range bounds, evaluated in Init(). */
+  std::optional<Value> lower_;
+  std::optional<Value> upper_;
 };
 }  // namespace bustub
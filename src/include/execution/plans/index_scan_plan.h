@@ -20,6 +20,15 @@
 #include "execution/plans/abstract_plan.h"
 
 namespace bustub {
+
+/** One end of the key range of an index scan, on the first column of the index key. */
+struct IndexScanBound {
+  /** The constant the first key column is compared with, nullptr for an end that is left open. */
+  AbstractExpressionRef key_;
+  /** Whether keys equal to key_ are in the range. */
+  bool inclusive_{true};
+};
+
 /**
  * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
  */
@@ -29,9 +38,20 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_oid the identifier of table to be scanned
+   * @param lower the lowest keys to scan, an open bound scans from the first key
+   * @param upper the highest keys to scan, an open bound scans to the last key
+   * @param reverse whether to scan from the highest key down to the lowest
+   * @param index_only whether the columns read above the scan are all stored in the index, so that rows are made
+   * from index entries without fetching them from the table
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, IndexScanBound lower = {}, IndexScanBound upper = {},
+                    bool reverse = false, bool index_only = false)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        lower_(std::move(lower)),
+        upper_(std::move(upper)),
+        reverse_(reverse),
+        index_only_(index_only) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
@@ -44,10 +64,31 @@ class IndexScanPlanNode : public AbstractPlanNode {
   index_oid_t index_oid_;
 
   // Add anything you want here for index lookup
+  /** The key range of the scan. */
+  IndexScanBound lower_;
+  IndexScanBound upper_;
+
+  /** Whether keys are scanned in descending order. */
+  bool reverse_;
+
+  /**
+   * Whether rows are made from the index entries alone. Columns the index does not store are NULL in them, which is
+   * only correct if nothing reads those columns.
+   */
+  bool index_only_;
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    std::string index_only = index_only_ ? ", index_only=true" : "";
+    if (lower_.key_ == nullptr && upper_.key_ == nullptr && !reverse_) {
+      return fmt::format("IndexScan {{ index_oid={}{} }}", index_oid_, index_only);
+    }
+    std::string range = fmt::format("{}{}, {}{}", lower_.inclusive_ ? '[' : '(',
+                                    lower_.key_ == nullptr ? "-inf" : lower_.key_->ToString(),
+                                    upper_.key_ == nullptr ? "+inf" : upper_.key_->ToString(),
+                                    upper_.inclusive_ ? ']' : ')');
+    return fmt::format("IndexScan {{ index_oid={}, range={}, reverse={}{} }}", index_oid_, range, reverse_,
+                       index_only);
   }
 };
 
@@ -79,10 +79,22 @@ class Optimizer {
   auto IsPredicateTrue(const AbstractExpressionRef &expr) -> bool;
 
   /**
-   * @brief optimize order by as index scan if there's an index on a table
+   * @brief optimize filter + seq scan as index scan over the key range the filter allows, if there's an index on a
+   * table whose leading key column the filter compares with constants
+   */
+  auto OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
+  /**
+   * @brief optimize order by as index scan if there's an index on a table. Descending orders become reverse scans.
    */
   auto OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief make an index scan index-only if every column read of its rows is stored in the index, as a key column or
+   * an included one, so that the rows need not be fetched from the table
+   */
+  auto OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /** @brief check if the index can be matched */
   auto MatchIndex(const std::string &table_name, uint32_t index_key_idx)
       -> std::optional<std::tuple<index_oid_t, std::string>>;
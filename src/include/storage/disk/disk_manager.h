@@ -15,13 +15,35 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <sys/types.h>
+#include <vector>
 
 #include "common/config.h"
+#include "storage/disk/free_space_map.h"
+#include "storage/disk/page_checksums.h"
 
 namespace bustub {
 
+/**
+ * A page I/O handed to DiskManager::Submit(). page_count_ consecutive pages starting at page_id_ are written from /
+ * read into data_, and callback_ is fulfilled once the I/O has finished, or gets the exception it failed with.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+  /** The first page of the request. */
+  page_id_t page_id_;
+  /** The buffer to write from or read into, page_count_ * BUSTUB_PAGE_SIZE bytes. */
+  char *data_;
+  /** The number of pages, only writes may span more than one. */
+  size_t page_count_{1};
+  /** Fulfilled when the I/O has finished. */
+  std::promise<void> callback_;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
@@ -42,7 +64,58 @@ class DiskManager {
   /**
    * Shut down the disk manager and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
+
+  /**
+   * Keep CRC32C checksums of the pages in a file next to the database file (`<name>.crc`). From now on, the checksum of
+   * a page is made durable before the page is written and checked whenever it is read back, and ReadPage() throws an
+   * Exception of type CORRUPTION on a mismatch, e.g. after a torn write. Call before any page I/O.
+   */
+  void EnableChecksums();
+
+  /**
+   * Check every page against its checksums after a crash of the machine, and forget the checksums of writes that did
+   * not reach the disk. A page written just before the crash reads back intact whether or not the write made it, and
+   * only a torn page fails. Pages that have no checksum yet, e.g. because the file was written without them, get the
+   * checksum of their current data. Call after EnableChecksums(), before any other page I/O.
+   * @return the ids of the torn pages, which keep failing verification until they are rewritten
+   */
+  auto RecoverChecksums() -> std::vector<page_id_t>;
+
+  /**
+   * Keep the free-space map in a file next to the database file (`<name>.fsm`), loading it if it exists, so that the
+   * pages freed by DeallocatePage() are still reused after the database has been reopened. Without it, the map is lost
+   * on shutdown and the next run allocates from page 0 again. The map also records the page size, and this throws if
+   * the database was created by a build with a different BUSTUB_PAGE_SIZE. Call before any page is allocated.
+   */
+  void EnableFreeSpaceMap();
+
+  /**
+   * Allocate a page of the database file, reusing the lowest free page if there is one.
+   * @return the id of the new page
+   */
+  auto AllocatePage() -> page_id_t;
+
+  /**
+   * Free a page, so that AllocatePage() can hand it out again. The page must not be read or written afterwards.
+   * @param page_id id of the page
+   */
+  virtual void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Truncate the database file after its last allocated page. Safe to call while the database is in use.
+   * @return the number of pages the file has shrunk by
+   */
+  auto ShrinkToFit() -> size_t;
+
+  /** @return one past the last allocated page, i.e. the number of pages the database file needs */
+  auto GetPageCount() -> page_id_t { return free_space_->GetPageCount(); }
+
+  /** @return whether the page has been allocated and not freed since */
+  auto IsPageAllocated(page_id_t page_id) -> bool { return free_space_->IsAllocated(page_id); }
+
+  /** @return the number of free pages that AllocatePage() will reuse before growing the file */
+  auto GetFreePageCount() -> size_t { return free_space_->GetFreePageCount(); }
 
   /**
    * Write a page to the database file.
@@ -51,6 +124,14 @@ class DiskManager {
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
+  /**
+   * Write a run of consecutive pages to the database file with a single I/O.
+   * @param start_page_id id of the first page
+   * @param page_count number of pages to write
+   * @param page_data raw data of the pages, page_count * BUSTUB_PAGE_SIZE bytes
+   */
+  virtual void WritePages(page_id_t start_page_id, size_t page_count, const char *page_data);
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -58,6 +139,30 @@ class DiskManager {
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Submit a batch of page I/Os. The disk manager may run them in any order and in parallel, so the caller must not
+   * touch the buffers before the callbacks have fired. The default implementation runs them one after the other before
+   * returning.
+   * @param requests the I/Os to run
+   */
+  virtual void Submit(std::vector<DiskRequest> requests);
+
+  /**
+   * Read a page from the database file asynchronously.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer, must stay valid until the future is ready
+   * @return a future that becomes ready once the page has been read
+   */
+  auto ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void>;
+
+  /**
+   * Write a page to the database file asynchronously.
+   * @param page_id id of the page
+   * @param page_data raw page data, must stay valid until the future is ready
+   * @return a future that becomes ready once the page has been written
+   */
+  auto WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void>;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -93,7 +198,15 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
+  /** @return the size of a file in bytes, -1 if it can't be read. A db file can be larger than 2 GiB. */
+  auto GetFileSize(const std::string &file_name) -> off_t;
+  /** Derives the log file name from db_file and opens (or creates) the log file. */
+  void OpenLogFile(const std::string &db_file);
+  /**
+   * Records the checksums of all writes in the batch and syncs them once, so that the writes themselves find their
+   * checksums synced. The pages of the batch must be distinct. Errors are left for the writes to report.
+   */
+  void PrepareChecksums(const std::vector<DiskRequest> &requests);
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
@@ -101,9 +214,13 @@ class DiskManager {
   std::fstream db_io_;
   std::string file_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
+  /** The page checksums, if enabled. */
+  std::unique_ptr<PageChecksums> checksums_;
+  /** Tracks the allocated pages. */
+  std::unique_ptr<FreeSpaceMap> free_space_{std::make_unique<FreeSpaceMap>()};
   // With multiple buffer pool instances, need to protect file access
   std::mutex db_io_latch_;
 };
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_async.h
+//
+// Identification: src/include/storage/disk/disk_manager_async.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager_posix.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+/**
+ * DiskManagerAsync keeps up to queue_depth page I/Os in flight at once. Requests handed to Submit() go to an io_uring
+ * instance in one batch and are completed by a reaper thread; where io_uring is not available (older kernels, seccomp
+ * sandboxes), a pool of queue_depth worker threads runs them with pread / pwrite instead. ReadPage() and WritePage()
+ * stay synchronous and bypass the queue.
+ */
+class DiskManagerAsync : public DiskManagerPosix {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io whether to bypass the OS page cache
+   * @param queue_depth the maximum number of I/Os in flight
+   * @param use_io_uring false to always use the thread pool
+   */
+  explicit DiskManagerAsync(const std::string &db_file, bool direct_io = false, size_t queue_depth = DISK_QUEUE_DEPTH,
+                            bool use_io_uring = true);
+
+  ~DiskManagerAsync() override;
+
+  void ShutDown() override;
+
+  void Submit(std::vector<DiskRequest> requests) override;
+
+  /** @return true if requests go through io_uring, false if they are run by the thread pool */
+  auto UsesIoUring() const -> bool { return ring_fd_ >= 0; }
+
+ private:
+  /** Sets up the io_uring instance and maps its rings. @return false if io_uring is not available */
+  auto SetUpIoUring() -> bool;
+
+  /** Queues the requests on the submission ring and submits them with as few system calls as the queue depth allows. */
+  void SubmitToRing(std::vector<DiskRequest> *requests);
+
+  /** Tells the kernel about count new submission queue entries. Must hold latch_. */
+  void EnterRing(unsigned count);
+
+  /**
+   * Reaps completions off the completion ring until StopIo() is called, or until io_uring fails for good. Then it
+   * cancels the requests still in flight and keeps reaping until all of them have completed, since the kernel may
+   * still write into their buffers. Later requests are run synchronously by Submit().
+   */
+  void CompletionLoop();
+
+  /**
+   * Stops queuing requests on the ring after a fatal io_uring error, and asks the kernel to cancel the ones in flight.
+   * Must hold latch_.
+   */
+  void CancelInFlight();
+
+  /**
+   * Gives up on io_uring after Submit() failed to enter the ring. Takes back the entries the kernel has not consumed
+   * and runs their requests synchronously, then cancels the ones it did consume. Must hold latch_.
+   */
+  void AbandonRing();
+
+  /** Runs queued requests for the thread-pool fallback until StopIo() is called. */
+  void WorkerLoop();
+
+  /** Verifies the checksums of a read that io_uring has run, and fulfills the callback of the request. */
+  void Complete(DiskRequest *request);
+
+  /** Runs the request synchronously and fulfills its callback. */
+  void Execute(DiskRequest *request);
+
+  /** Drains the in-flight requests and stops the I/O threads. */
+  void StopIo();
+
+  /** Marks the completions of the cancel requests CancelInFlight() submits. No DiskRequest lives at this address. */
+  static constexpr uint64_t CANCEL_USER_DATA = 1;
+
+  size_t queue_depth_;
+  /** Protects in_flight_, in_flight_requests_, stop_, ring_failed_, queue_ and the submission ring. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  size_t in_flight_{0};
+  bool stop_{false};
+  /** The requests handed to io_uring that have not been reaped yet. */
+  std::unordered_set<DiskRequest *> in_flight_requests_;
+  /** Set once the completion thread has given up on io_uring, it still reaps the requests in flight then. */
+  bool ring_failed_{false};
+  std::vector<std::thread> threads_;
+
+  /** The requests waiting for a worker thread, when running without io_uring. */
+  std::deque<DiskRequest> queue_;
+
+  /** The io_uring instance and its memory-mapped rings, see io_uring_setup(2). */
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_head_{nullptr};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+};
+
+}  // namespace bustub
@@ -46,6 +46,18 @@ class DiskManagerMemory : public DiskManager {
    */
   void WritePage(page_id_t page_id, const char *page_data) override;
 
+  /**
+   * Write a run of consecutive pages, one page at a time.
+   * @param start_page_id id of the first page
+   * @param page_count number of pages to write
+   * @param page_data raw data of the pages
+   */
+  void WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) override {
+    for (size_t i = 0; i < page_count; i++) {
+      WritePage(start_page_id + static_cast<page_id_t>(i), page_data + i * BUSTUB_PAGE_SIZE);
+    }
+  }
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -89,6 +101,18 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
   }
 
+  /**
+   * Write a run of consecutive pages, one page at a time.
+   * @param start_page_id id of the first page
+   * @param page_count number of pages to write
+   * @param page_data raw data of the pages
+   */
+  void WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) override {
+    for (size_t i = 0; i < page_count; i++) {
+      WritePage(start_page_id + static_cast<page_id_t>(i), page_data + i * BUSTUB_PAGE_SIZE);
+    }
+  }
+
   /**
    * Read a page from the database file.
    * @param page_id id of the page
@@ -115,6 +139,18 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
   }
 
+  /**
+   * Free a page and release its memory.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id) override {
+    DiskManager::DeallocatePage(page_id);
+    std::unique_lock<std::mutex> l(mutex_);
+    if (page_id >= 0 && page_id < static_cast<int>(data_.size())) {
+      data_[page_id] = nullptr;
+    }
+  }
+
   void SetLatency(size_t latency_ms) { latency_ = latency_ms; }
 
  private:
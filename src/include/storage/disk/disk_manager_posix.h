@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_posix.h
+//
+// Identification: src/include/storage/disk/disk_manager_posix.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <string>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * DiskManagerPosix stores the database file behind a plain file descriptor and does positional I/O (pread / pwrite).
+ * Unlike the fstream based DiskManager there is no seek cursor to protect, so page reads and writes from different
+ * threads run in parallel without a global latch. The log file is still handled by DiskManager.
+ *
+ * With direct_io the file is opened with O_DIRECT, so pages bypass the OS page cache instead of being cached twice.
+ * O_DIRECT needs buffers aligned to the page size; frames allocated by the buffer pool are, other buffers are copied
+ * through an aligned bounce buffer. If the file system does not support O_DIRECT, buffered I/O is used instead.
+ */
+class DiskManagerPosix : public DiskManager {
+ public:
+  /**
+   * Creates a new disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param direct_io whether to bypass the OS page cache
+   */
+  explicit DiskManagerPosix(const std::string &db_file, bool direct_io = false);
+
+  ~DiskManagerPosix() override;
+
+  void ShutDown() override;
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /** @return true if the database file was actually opened with O_DIRECT */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
+ protected:
+  /** Writes size bytes at offset, retrying on short writes. */
+  void WriteAt(size_t offset, const char *data, size_t size);
+
+  /** Reads up to size bytes at offset, retrying on short reads. @return the number of bytes read */
+  auto ReadAt(size_t offset, char *data, size_t size) -> size_t;
+
+  int db_fd_{-1};
+  bool direct_io_{false};
+};
+
+}  // namespace bustub
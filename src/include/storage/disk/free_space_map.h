@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/disk/free_space_map.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap tracks which pages of a database file are allocated, with one bit per page. Allocate() hands out the
+ * lowest free page, so that live pages gather at the front of the file and the free pages at its end can be cut off.
+ *
+ * The map lives in memory only, unless it is given a file: then every change of a bit is written through to that
+ * file, so that the free pages are known again when the database is reopened. The file also records the page size
+ * the database was created with, and refuses to be opened by a build with a different one.
+ */
+class FreeSpaceMap {
+ public:
+  /** Creates an empty map that is not persisted. */
+  FreeSpaceMap() = default;
+
+  /**
+   * Opens (or creates) a persistent map.
+   * @param file_name the name of the file that holds the bitmap
+   * @throws Exception if the file was created with a different page size
+   */
+  explicit FreeSpaceMap(const std::string &file_name);
+
+  ~FreeSpaceMap();
+
+  /** @return the id of a page that was free and is allocated now, the lowest one there is */
+  auto Allocate() -> page_id_t;
+
+  /**
+   * Frees an allocated page.
+   * @param page_id id of the page
+   * @return false if the page was not allocated
+   */
+  auto Deallocate(page_id_t page_id) -> bool;
+
+  /** @return true if the page is allocated */
+  auto IsAllocated(page_id_t page_id) -> bool;
+
+  /** @return one past the last allocated page, i.e. the number of pages the database file needs */
+  auto GetPageCount() -> page_id_t;
+
+  /** @return the number of free pages below GetPageCount() */
+  auto GetFreePageCount() -> size_t;
+
+  /**
+   * Calls shrink with GetPageCount() while holding off Allocate(), so that all pages from there on stay free until
+   * shrink returns.
+   * @param shrink the function that cuts off the end of the database file
+   */
+  void Shrink(const std::function<void(page_id_t)> &shrink);
+
+ private:
+  /** Sets the bit of a page and writes it through to the file. Must hold latch_. */
+  void SetAllocated(page_id_t page_id, bool allocated);
+
+  /** Protects all of the following. */
+  std::mutex latch_;
+  /** Bit i of word i / 64 is set if page i is allocated. */
+  std::vector<uint64_t> bitmap_;
+  /** The free pages below page_count_, lowest first. */
+  std::set<page_id_t> free_pages_;
+  /** One past the last allocated page. */
+  page_id_t page_count_{0};
+  /** The file the bitmap is persisted to, or -1. */
+  int fd_{-1};
+};
+
+}  // namespace bustub
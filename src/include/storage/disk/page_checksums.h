@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksums.h
+//
+// Identification: src/include/storage/disk/page_checksums.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PageChecksums keeps CRC32C checksums of the pages of a database file. Page layouts use the whole page, so the
+ * checksums live in a separate, memory-mapped file with one slot per page. A slot holds the checksums of the last two
+ * versions of its page that were written.
+ *
+ * A write goes through Prepare(), which records the checksum of the new page, and Sync(), which writes the recorded
+ * slots back to the device before the page is written. Sync() covers every Prepare() before it, so a batch of writes,
+ * or writers running at the same time, share one. Before Prepare() drops the checksum of a version, it writes the
+ * version after it back from the database file, so the version that is on the device always has its checksum in the
+ * slot. Whenever the machine crashes, the page is therefore one of the two versions of its slot or torn between them,
+ * and only a torn page matches neither checksum.
+ *
+ * Both files are written back, but not flushed out of the device's cache, which is as far as the disk managers go for
+ * the database file as well.
+ *
+ * A page whose slot is still zero has not been written since checksums were enabled and is not verified. Its first
+ * write takes the page to have been all zeros before, as it is past the end of the file or cut off by Clear().
+ */
+class PageChecksums {
+ public:
+  /**
+   * Opens (or creates) a checksum file.
+   * @param file_name the name of the checksum file
+   * @param db_file_name the name of the database file whose pages are checksummed
+   */
+  PageChecksums(const std::string &file_name, const std::string &db_file_name);
+
+  ~PageChecksums();
+
+  /**
+   * Record the checksums of consecutive pages that are about to be written. The pages must not be written before a
+   * Sync() that starts after this returns, they must be written from exactly these bytes, and an earlier write of them
+   * must have returned.
+   * @param start_page_id id of the first page
+   * @param page_count number of pages
+   * @param page_data raw data of the pages
+   */
+  void Prepare(page_id_t start_page_id, size_t page_count, const char *page_data);
+
+  /** Write the slots recorded by Prepare() so far back to the device. Calls that overlap share one write-back. */
+  void Sync();
+
+  /**
+   * Check a page that has just been read against its recorded checksums.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @throws Exception of type CORRUPTION if the page matches neither checksum
+   */
+  void Verify(page_id_t page_id, const char *page_data);
+
+  /**
+   * Check a page after a crash, and settle its slot on the checksum it matches. A page that has no checksum yet gets
+   * the one of its current data.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   * @return false if the page matches neither checksum, i.e. it was torn, in which case the slot is left as it is
+   */
+  auto Recover(page_id_t page_id, const char *page_data) -> bool;
+
+  /**
+   * Forget the checksums of a page that may be cut off the end of the file and then read as zeros.
+   * @param page_id id of the page
+   */
+  void Clear(page_id_t page_id);
+
+  /** @return the number of pages that have a slot, some of them may never have been written */
+  auto GetSlotCount() -> size_t;
+
+ private:
+  /** The checksums of a page, zero for none. */
+  struct Slot {
+    /** Of the version of the page written last. */
+    uint32_t current_;
+    /** Of the version before it. */
+    uint32_t previous_;
+  };
+
+  /** Grows the file and the mapping so that page_id has a slot. Must hold latch_ exclusively. */
+  void Grow(page_id_t page_id);
+
+  /** Computes the value stored in the slot of a page, which is never zero. */
+  static auto Checksum(const char *page_data) -> uint32_t;
+
+  /**
+   * Writes the given pages back from the database file, so that the versions in their slots' current checksums are on
+   * the device. Must not hold latch_.
+   * @param page_ids the ids of the pages, sorted
+   */
+  void SettlePages(const std::vector<page_id_t> &page_ids);
+
+  int fd_{-1};
+  /** The database file, only used to write its pages back. */
+  int db_fd_{-1};
+  /** The mapped checksum file. */
+  Slot *slots_{nullptr};
+  /**
+   * One flag per slot, set once the version of its current checksum is known to be on the device. The flags are not
+   * persisted: after opening, every version is written back again before its slot drops the one before.
+   */
+  std::vector<uint8_t> settled_;
+  /** Number of slots in the mapping. */
+  size_t slot_cnt_{0};
+  /** Shared to access slots, exclusive to grow the mapping. */
+  std::shared_mutex latch_;
+
+  /** Number of Prepare() calls that changed a slot. */
+  std::atomic<uint64_t> prepare_cnt_{0};
+  /** Protects synced_cnt_ and syncing_. */
+  std::mutex sync_latch_;
+  std::condition_variable sync_cv_;
+  /** The slots changed by the first synced_cnt_ Prepare() calls are on the device. */
+  uint64_t synced_cnt_{0};
+  /** True while a thread writes the slots back, the others wait for it. */
+  bool syncing_{false};
+};
+
+}  // namespace bustub
@@ -17,6 +17,7 @@
 #include <queue>
 #include <shared_mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/config.h"
@@ -33,6 +34,9 @@ namespace bustub {
 
 struct PrintableBPlusTree;
 
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeBuilder;
+
 /**
  * @brief Definition of the Context class.
  *
@@ -88,11 +92,24 @@ class BPlusTree {
   // Return the value associated with a given key
   auto GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn = nullptr) -> bool;
 
+  // Return the values of a batch of keys, result[i] being the value of keys[i] if there is one. Sorted keys are
+  // looked up fastest. Returns how many keys were found.
+  auto GetValues(const std::vector<KeyType> &keys, std::vector<std::optional<ValueType>> *result,
+                 Transaction *txn = nullptr) -> size_t;
+
+  // Insert a batch of key-value pairs, fastest if they are sorted by key. Returns how many were inserted.
+  auto InsertBatch(const std::vector<std::pair<KeyType, ValueType>> &pairs, Transaction *txn = nullptr) -> size_t;
+
   void FindLeafPage(const KeyType &key, ReadPageGuard &leaf_page_guard);
+  auto GetValueOptimistic(const KeyType &key, ValueType *value) -> std::optional<bool>;
   auto FindLeafPageWriteInsertOrDelete(const KeyType &key, Context *ctx, bool is_insert) -> LeafPage *;
+  // Read-crab down to the leaf of key and write latch only the leaf. Returns nothing if the tree is empty.
+  auto FindLeafPageWriteOptimistic(const KeyType &key) -> std::optional<WritePageGuard>;
   auto MergeOrRedistribute(WritePageGuard *page_guard, Context *ctx) -> bool;
   auto RootAdjust(WritePageGuard *root_page_guard, Context *ctx) -> bool;
   auto FindSibling(WritePageGuard *page_guard, WritePageGuard &sibling_page_guard, Context *ctx) -> bool;
+  // Delete a page that was merged away, waiting for other threads to unpin it.
+  void DeletePage(page_id_t page_id);
 
   // Return the page id of the root node
   auto GetRootPageId() const -> page_id_t;
@@ -104,6 +121,11 @@ class BPlusTree {
 
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
 
+  // Reverse index iterator, from the last key or from the last key not greater than key
+  auto RBegin() -> INDEXITERATOR_TYPE;
+
+  auto RBegin(const KeyType &key) -> INDEXITERATOR_TYPE;
+
   // Print the B+ tree
   void Print(BufferPoolManager *bpm);
 
@@ -130,6 +152,40 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *txn = nullptr);
 
  private:
+  friend class BPlusTreeBuilder<KeyType, ValueType, KeyComparator>;
+
+  /** How often GetValue() restarts an optimistic lookup before it takes read latches. */
+  static constexpr int OPTIMISTIC_READ_ATTEMPTS = 4;
+
+  /**
+   * The leaf that a batch operation is at and its parent, which stay latched from one key to the next, along with the
+   * range of keys [low, high) that each of them covers. An empty bound is unbounded.
+   */
+  template <typename Guard>
+  struct BatchCursor {
+    std::optional<Guard> parent_;
+    std::optional<KeyType> parent_low_;
+    std::optional<KeyType> parent_high_;
+    std::optional<Guard> leaf_;
+    std::optional<KeyType> leaf_low_;
+    std::optional<KeyType> leaf_high_;
+  };
+
+  /**
+   * Moves a batch cursor to the leaf of key. A key in the range of the cursor's leaf stays there, one in the range of
+   * its parent goes to a sibling through the parent, and any other key descends again from the root. Pages are latched
+   * top-down only, with write latches if Guard is a WritePageGuard.
+   * @return false if the tree is empty
+   */
+  template <typename Guard>
+  auto SeekLeaf(const KeyType &key, BatchCursor<Guard> *cursor) -> bool;
+
+  /** @return true if low <= key < high */
+  auto InRange(const KeyType &key, const std::optional<KeyType> &low, const std::optional<KeyType> &high) -> bool;
+
+  /** @return true if the size fields of a node read without a latch cannot make a search leave the page */
+  static auto IsReadable(const BPlusTreePage *node) -> bool;
+
   /* Debug Routines for FREE!! */
   void ToGraph(page_id_t page_id, const BPlusTreePage *page, std::ofstream &out);
 
@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_builder.h
+//
+// Identification: src/include/storage/index/b_plus_tree_builder.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+#define BPLUSTREE_BUILDER_TYPE BPlusTreeBuilder<KeyType, ValueType, KeyComparator>
+
+/**
+ * BPlusTreeBuilder builds a B+ tree bottom-up from entries added in any order, for example to create an index on a
+ * table that already has rows.
+ *
+ * Entries are sorted in memory in runs of up to run_size. When there is more than one run, each run is written to
+ * pages of the buffer pool, which may evict them to disk, and the runs are merged BULK_LOAD_MERGE_WAYS at a time.
+ * Finish() then fills leaves from left to right and puts the internal levels on top of them. Every page is written
+ * once, no page splits, and each page but the last one or two of a level holds fill_factor of what fits in it.
+ *
+ * Keys are unique as with BPlusTree::Insert(): of entries with the same key, the one added first is kept. Entries whose
+ * key has a NULL column are left out, the comparator orders them nowhere, and an insert would take them for duplicates.
+ * The tree must be empty, and nobody else may use it until Finish() returns.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeBuilder {
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
+ public:
+  /**
+   * @param tree the empty tree to build
+   * @param fill_factor the share of each page to fill, between 0.5 and 1
+   * @param run_size how many entries to sort in memory at once
+   */
+  explicit BPlusTreeBuilder(BPlusTree<KeyType, ValueType, KeyComparator> *tree,
+                            double fill_factor = BULK_LOAD_FILL_FACTOR, size_t run_size = BULK_LOAD_RUN_SIZE);
+
+  /** Frees the pages of runs that Finish() did not get to. */
+  ~BPlusTreeBuilder();
+
+  DISALLOW_COPY_AND_MOVE(BPlusTreeBuilder);
+
+  /** Adds an entry to the tree that Finish() builds, unless its key has a NULL column. */
+  void Add(const KeyType &key, const ValueType &value);
+
+  /**
+   * Builds the tree from the entries added so far.
+   * @return the number of entries in the tree, fewer than were added if some keys repeat or hold NULL
+   */
+  auto Finish() -> size_t;
+
+ private:
+  /** A sorted run written to pages, each page filled with RUN_PAGE_SLOTS entries but the last one. */
+  struct Run {
+    std::vector<page_id_t> pages_;
+    size_t size_{0};
+  };
+
+  /** Reads a run from its first entry, deleting each page once it is read. */
+  class RunReader {
+   public:
+    RunReader(BufferPoolManager *bpm, Run *run) : bpm_(bpm), run_(run) {}
+
+    auto Done() const -> bool { return pos_ == run_->size_; }
+    auto Peek() -> const MappingType &;
+    void Pop();
+
+   private:
+    BufferPoolManager *bpm_;
+    Run *run_;
+    size_t pos_{0};
+    BasicPageGuard guard_;
+    const MappingType *entries_{nullptr};
+  };
+
+  static constexpr size_t RUN_PAGE_SLOTS = BUSTUB_PAGE_SIZE / sizeof(MappingType);
+
+  /** Sorts the buffered entries and writes them to a new run. */
+  void SpillRun();
+
+  /** Merges runs [begin, end) in order, calling emit with each entry. Entries with equal keys keep their run order. */
+  template <typename Emit>
+  void MergeRuns(size_t begin, size_t end, Emit emit);
+
+  /** Writes an entry to the run at the back of runs_. */
+  void AppendToRun(const MappingType &entry);
+
+  /** Adds the next entry in key order to the leaf level, unless its key repeats the one before. */
+  void AppendToLeaves(const MappingType &entry);
+
+  /** Rebalances the last two leaves if the last one is short. */
+  void FinishLeaves();
+
+  /** Builds the internal level above children_ and replaces children_ with it. */
+  void BuildInternalLevel();
+
+  /** @return a new page, throws if the buffer pool has no frame for it */
+  auto NewPage() -> BasicPageGuard;
+
+  /**
+   * When the last page of a level ends up below the minimum size, it shares the total of its and its left neighbor's
+   * entries with the neighbor.
+   * @return the size of the last page, 0 if the entries fit in the neighbor alone
+   */
+  static auto LastPageSize(int total, int max_size) -> int { return total <= max_size ? 0 : total / 2; }
+
+  BufferPoolManager *bpm_;
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  KeyComparator comparator_;
+  size_t run_size_;
+  /** The number of entries to put in each leaf and internal page. */
+  int leaf_fill_;
+  int internal_fill_;
+
+  std::vector<MappingType> buffer_;
+  std::vector<Run> runs_;
+  BasicPageGuard run_guard_;
+
+  /** The first key and page id of every page of the level that is being built. */
+  std::vector<std::pair<KeyType, page_id_t>> children_;
+  /** The last leaf and the one before it, which FinishLeaves() may rebalance. */
+  BasicPageGuard leaf_;
+  BasicPageGuard prev_leaf_;
+  size_t size_{0};
+};
+
+}  // namespace bustub
@@ -14,10 +14,12 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
 #include "storage/index/index.h"
 
 namespace bustub {
@@ -35,12 +37,26 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  /** Sorts the entries by key and inserts them with BPlusTree::InsertBatch(). */
+  auto InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries, Transaction *transaction) -> size_t override;
+
+  /** Sorts the keys and looks them up with BPlusTree::GetValues(). */
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                Transaction *transaction) override;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  auto GetReverseBeginIterator() -> INDEXITERATOR_TYPE;
+
+  auto GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
+
+  /** @return a builder that fills the empty index with entries in any order, see BPlusTreeBuilder */
+  auto MakeBuilder(double fill_factor = BULK_LOAD_FILL_FACTOR) -> std::unique_ptr<BPLUSTREE_BUILDER_TYPE>;
+
  protected:
   // comparator for key
   KeyComparator comparator_;
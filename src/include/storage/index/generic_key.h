@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstring>
 
 #include "storage/table/tuple.h"
@@ -72,11 +73,22 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys made of a single integer column are compared as plain integers, without materializing Values. Like the Value
+ * comparison, a NULL key compares equal to any other key.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    if (integer_size_ > 0) {
+      int64_t lhs_integer = IntegerAt(lhs);
+      int64_t rhs_integer = IntegerAt(rhs);
+      if (lhs_integer == integer_null_ || rhs_integer == integer_null_) {
+        return 0;
+      }
+      return lhs_integer < rhs_integer ? -1 : (lhs_integer > rhs_integer ? 1 : 0);
+    }
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -94,13 +106,89 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, integer_size_{other.integer_size_}, integer_null_{other.integer_null_} {}
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  // constructor, compare_integers = false keeps integer keys on the Value comparison, e.g. to measure the difference
+  explicit GenericComparator(Schema *key_schema, bool compare_integers = true) : key_schema_(key_schema) {
+    if (!compare_integers || key_schema_->GetColumnCount() != 1 || key_schema_->GetColumn(0).GetOffset() != 0) {
+      return;
+    }
+    switch (key_schema_->GetColumn(0).GetType()) {
+      case TypeId::TINYINT:
+        integer_size_ = sizeof(int8_t);
+        integer_null_ = BUSTUB_INT8_NULL;
+        break;
+      case TypeId::SMALLINT:
+        integer_size_ = sizeof(int16_t);
+        integer_null_ = BUSTUB_INT16_NULL;
+        break;
+      case TypeId::INTEGER:
+        integer_size_ = sizeof(int32_t);
+        integer_null_ = BUSTUB_INT32_NULL;
+        break;
+      case TypeId::BIGINT:
+        integer_size_ = sizeof(int64_t);
+        integer_null_ = BUSTUB_INT64_NULL;
+        break;
+      default:
+        break;
+    }
+    if (integer_size_ > KeySize) {
+      integer_size_ = 0;
+    }
+  }
+
+  /**
+   * @return true if a column of the key is NULL. Such a key compares equal to every key, so it has no place in a sort.
+   */
+  inline auto HasNull(const GenericKey<KeySize> &key) const -> bool {
+    if (integer_size_ > 0) {
+      return IntegerAt(key) == integer_null_;
+    }
+    for (uint32_t i = 0; i < key_schema_->GetColumnCount(); i++) {
+      if (key.ToValue(key_schema_, i).IsNull()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** @return true if keys are a single integer column, which IntegerAt() reads */
+  inline auto IsIntegerKey() const -> bool { return integer_size_ > 0; }
+
+  /** @return the integer a key holds, see IsIntegerKey() */
+  inline auto IntegerAt(const GenericKey<KeySize> &key) const -> int64_t {
+    switch (integer_size_) {
+      case sizeof(int8_t):
+        return LoadInteger<int8_t>(key.data_);
+      case sizeof(int16_t):
+        return LoadInteger<int16_t>(key.data_);
+      case sizeof(int32_t):
+        return LoadInteger<int32_t>(key.data_);
+      default:
+        return LoadInteger<int64_t>(key.data_);
+    }
+  }
+
+  /** @return the width of the integer IntegerAt() reads in bytes, 0 if keys are not a single integer column */
+  inline auto IntegerSize() const -> size_t { return integer_size_; }
+
+  /** @return the integer that stands for NULL, see IsIntegerKey() */
+  inline auto IntegerNull() const -> int64_t { return integer_null_; }
 
  private:
+  template <typename IntegerType>
+  static inline auto LoadInteger(const char *data) -> int64_t {
+    IntegerType integer;
+    memcpy(&integer, data, sizeof(integer));
+    return integer;
+  }
+
   Schema *key_schema_;
+  /** The width of the key's integer column in bytes, 0 if the key is not a single integer column. */
+  size_t integer_size_{0};
+  int64_t integer_null_{0};
 };
 
 }  // namespace bustub
@@ -43,11 +43,18 @@ class IndexMetadata {
    * @param table_name The name of the table on which the index is created
    * @param tuple_schema The schema of the indexed key
    * @param key_attrs The mapping from indexed columns to base table columns
+   * @param include_attrs The base table columns stored in the index entries after the key, but not compared
    */
   IndexMetadata(std::string index_name, std::string table_name, const Schema *tuple_schema,
-                std::vector<uint32_t> key_attrs)
-      : name_(std::move(index_name)), table_name_(std::move(table_name)), key_attrs_(std::move(key_attrs)) {
+                std::vector<uint32_t> key_attrs, std::vector<uint32_t> include_attrs = {})
+      : name_(std::move(index_name)),
+        table_name_(std::move(table_name)),
+        key_attrs_(std::move(key_attrs)),
+        include_attrs_(std::move(include_attrs)) {
     key_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, key_attrs_));
+    entry_attrs_ = key_attrs_;
+    entry_attrs_.insert(entry_attrs_.end(), include_attrs_.begin(), include_attrs_.end());
+    entry_schema_ = std::make_shared<Schema>(Schema::CopySchema(tuple_schema, entry_attrs_));
   }
 
   ~IndexMetadata() = default;
@@ -72,6 +79,18 @@ class IndexMetadata {
   /** @return The mapping relation between indexed columns and base table columns */
   inline auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return key_attrs_; }
 
+  /** @return The base table columns stored in the index entries besides the key */
+  inline auto GetIncludeAttrs() const -> const std::vector<uint32_t> & { return include_attrs_; }
+
+  /**
+   * @return The schema of what an index entry stores: the key columns followed by the included ones. Since the key
+   * columns come first, a key laid out by GetKeySchema() compares the same as a whole entry.
+   */
+  inline auto GetEntrySchema() const -> Schema * { return entry_schema_.get(); }
+
+  /** @return The base table columns of GetEntrySchema() */
+  inline auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return entry_attrs_; }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -94,6 +113,12 @@ class IndexMetadata {
   const std::vector<uint32_t> key_attrs_;
   /** The schema of the indexed key */
   std::shared_ptr<Schema> key_schema_;
+  /** The mapping relation between included columns and tuple schema */
+  const std::vector<uint32_t> include_attrs_;
+  /** The key attributes followed by the included ones */
+  std::vector<uint32_t> entry_attrs_;
+  /** The schema of an index entry */
+  std::shared_ptr<Schema> entry_schema_;
 };
 
 /////////////////////////////////////////////////////////////////////
@@ -139,6 +164,12 @@ class Index {
   /** @return The index key attributes */
   auto GetKeyAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetKeyAttrs(); }
 
+  /** @return The schema of the index entries, the key followed by the included columns */
+  auto GetEntrySchema() const -> Schema * { return metadata_->GetEntrySchema(); }
+
+  /** @return The index entry attributes */
+  auto GetEntryAttrs() const -> const std::vector<uint32_t> & { return metadata_->GetEntryAttrs(); }
+
   /** @return A string representation for debugging */
   auto ToString() const -> std::string {
     std::stringstream os;
@@ -153,7 +184,7 @@ class Index {
 
   /**
    * Insert an entry into the index.
-   * @param key The index key
+   * @param key The index key, laid out by GetEntrySchema() if the index includes columns besides the key
    * @param rid The RID associated with the key
    * @param transaction The transaction context
    * @returns whether insertion is successful
@@ -176,6 +207,39 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  ///////////////////////////////////////////////////////////////////
+  // Batch Operations
+  ///////////////////////////////////////////////////////////////////
+
+  /**
+   * Insert a batch of entries. By default they are inserted one by one, an index that can do better overrides this.
+   * @param entries The index keys and the RIDs associated with them
+   * @param transaction The transaction context
+   * @returns the number of entries inserted
+   */
+  virtual auto InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries, Transaction *transaction) -> size_t {
+    size_t inserted = 0;
+    for (const auto &[key, rid] : entries) {
+      inserted += InsertEntry(key, rid, transaction) ? 1 : 0;
+    }
+    return inserted;
+  }
+
+  /**
+   * Search the index for a batch of keys. By default they are searched one by one, an index that can do better
+   * overrides this.
+   * @param keys The index keys
+   * @param result Populated with one collection of RIDs per key, in the order of keys
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                        Transaction *transaction) {
+    result->assign(keys.size(), {});
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*result)[i], transaction);
+    }
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,7 +13,11 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <optional>
+#include <vector>
+
 #include "common/config.h"
+#include "storage/page/b_plus_tree_internal_page.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 #include "storage/page/page_guard.h"
 
@@ -21,19 +25,37 @@ namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * IndexIterator holds no latch or pin between steps, so that a scan neither blocks writers nor points into a leaf
+ * that a merge has freed. It copies the pairs of one leaf at a time while the leaf is read latched, and moves on to
+ * the next leaf by searching the tree from the root for the keys after the last one it copied. The pairs of a leaf
+ * are a consistent snapshot, but keys inserted or removed after a leaf was copied may or may not be seen.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+  using InternalPage = BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator>;
 
  public:
-  // you may define your own constructor based on your member variables
+  // An iterator that is at its end from the start
   IndexIterator() = default;
-  explicit IndexIterator(page_id_t leaf_page_id, LeafPage *leafPage, int index, BufferPoolManager *bpm);
+  /**
+   * @param key the key to start from: the first pair not less than key, or for a reverse iterator the last pair not
+   * greater than key. nullptr starts from the first (last) pair of the tree.
+   * @param reverse whether to iterate from higher keys to lower ones
+   */
+  IndexIterator(BufferPoolManager *bpm, page_id_t header_page_id, const KeyComparator &comparator, const KeyType *key,
+                bool reverse);
   ~IndexIterator();  // NOLINT
 
-  auto IsEnd() -> bool;
+  IndexIterator(IndexIterator &&that) noexcept = default;
+  auto operator=(IndexIterator &&that) noexcept -> IndexIterator & = default;
+
+  auto IsEnd() const -> bool { return index_ >= entries_.size(); }
 
-  bool is_empty_;
+  auto IsReverse() const -> bool { return reverse_; }
+
+  bool is_empty_{false};
   auto IsEmpty() -> bool { return is_empty_; }
 
   auto operator*() -> const MappingType &;
@@ -41,17 +63,46 @@ class IndexIterator {
   auto operator++() -> IndexIterator &;
 
   auto operator==(const IndexIterator &itr) const -> bool {
+    if (IsEnd() || itr.IsEnd()) {
+      return IsEnd() == itr.IsEnd();
+    }
     return itr.leaf_page_id_ == this->leaf_page_id_ && itr.index_ == this->index_;
   }
 
   auto operator!=(const IndexIterator &itr) const -> bool { return !(itr == *this); }
 
  private:
+  /**
+   * Copies the pairs after key (before key, for a reverse iterator) from the leaf that holds them into entries_, or
+   * leaves entries_ empty if there are none. Pairs equal to key are included if inclusive is set.
+   */
+  void LoadLeaf(const KeyType *key, bool inclusive);
+
+  /**
+   * Appends the pairs of the leaf after (before) key to entries_, all of them if key is nullptr. Only pairs strictly
+   * past key, or equal to it if inclusive is set, are taken, so every step of the iterator moves on.
+   */
+  void CopyPairs(const LeafPage *leaf_page, const KeyType *key, bool inclusive);
+
+  /**
+   * Prefetches the leaves after (before) the child at index of a latched parent of leaves, one window of
+   * READ_AHEAD_PAGES at a time. Their ids are current while the parent is latched, unlike next page ids read from
+   * leaves that a merge may free before they are fetched.
+   */
+  void PrefetchSiblings(const InternalPage *parent_page, int index);
+
   // add your own private member variables here
-  page_id_t leaf_page_id_ = INVALID_PAGE_ID;
-  LeafPage *leaf_page_;
-  int index_;
-  BufferPoolManager *bpm_;
+  BufferPoolManager *bpm_{nullptr};
+  page_id_t header_page_id_{INVALID_PAGE_ID};
+  std::optional<KeyComparator> comparator_;
+  bool reverse_{false};
+  /** The leaf the pairs in entries_ were copied from. */
+  page_id_t leaf_page_id_{INVALID_PAGE_ID};
+  /** Pairs of the current leaf in the order of iteration, from the key the iterator started from or moved on from. */
+  std::vector<MappingType> entries_;
+  size_t index_{0};
+  /** Whether no leaf has been loaded yet, so that the first one starts a prefetch window wherever it is. */
+  bool first_leaf_{true};
 };
 
 }  // namespace bustub
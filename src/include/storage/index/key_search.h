@@ -0,0 +1,175 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_search.h
+//
+// Identification: src/include/storage/index/key_search.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+#include "storage/index/generic_key.h"
+
+namespace bustub {
+
+/**
+ * @return the first index in [begin, end) of a sorted (key, value) array whose key is not before the target, end if
+ * there is none. is_before(key) must be true for a prefix of the range and false for the rest.
+ */
+template <typename MappingType, typename IsBefore>
+auto PartitionPoint(const MappingType *array, int begin, int end, IsBefore is_before) -> int {
+  while (begin < end) {
+    int mid = begin + (end - begin) / 2;
+    if (is_before(array[mid].first)) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+/**
+ * KeySearch finds keys in the sorted (key, value) array of a B+ tree page with binary search.
+ *
+ * The general version calls the comparator once per probe. GenericComparator keys that are a single integer column
+ * get a specialization that compares the integers directly, without branches that depend on the keys. When BusTub is
+ * built for SSE4.2 or AVX2 (see BUSTUB_KEY_SEARCH), 8-byte integer keys in leaf pages are compared several at a time
+ * once the search is down to a few slots.
+ */
+template <typename KeyType, typename ValueType, typename KeyComparator>
+struct KeySearch {
+  using MappingType = std::pair<KeyType, ValueType>;
+
+  /** @return the first index in [begin, end) whose key is not less than key, end if there is none */
+  static auto LowerBound(const MappingType *array, int begin, int end, const KeyType &key,
+                         const KeyComparator &comparator) -> int {
+    return PartitionPoint(array, begin, end, [&](const KeyType &probe) { return comparator(probe, key) < 0; });
+  }
+
+  /** @return the first index in [begin, end) whose key is greater than key, end if there is none */
+  static auto UpperBound(const MappingType *array, int begin, int end, const KeyType &key,
+                         const KeyComparator &comparator) -> int {
+    return PartitionPoint(array, begin, end, [&](const KeyType &probe) { return comparator(probe, key) <= 0; });
+  }
+};
+
+template <size_t KeySize, typename ValueType>
+struct KeySearch<GenericKey<KeySize>, ValueType, GenericComparator<KeySize>> {
+  using KeyType = GenericKey<KeySize>;
+  using KeyComparator = GenericComparator<KeySize>;
+  using MappingType = std::pair<KeyType, ValueType>;
+
+  static auto LowerBound(const MappingType *array, int begin, int end, const KeyType &key,
+                         const KeyComparator &comparator) -> int {
+    // A NULL key compares equal to every key, which only the comparator knows.
+    if (!comparator.IsIntegerKey() || comparator.IntegerAt(key) == comparator.IntegerNull()) {
+      return PartitionPoint(array, begin, end, [&](const KeyType &probe) { return comparator(probe, key) < 0; });
+    }
+    return IntegerSearch<false>(array, begin, end, comparator, comparator.IntegerAt(key));
+  }
+
+  static auto UpperBound(const MappingType *array, int begin, int end, const KeyType &key,
+                         const KeyComparator &comparator) -> int {
+    if (!comparator.IsIntegerKey() || comparator.IntegerAt(key) == comparator.IntegerNull()) {
+      return PartitionPoint(array, begin, end, [&](const KeyType &probe) { return comparator(probe, key) <= 0; });
+    }
+    return IntegerSearch<true>(array, begin, end, comparator, comparator.IntegerAt(key));
+  }
+
+ private:
+  /** Slots counted with vector compares once the binary search has narrowed the range down to them. */
+  static constexpr int SIMD_WINDOW = 8;
+
+  /**
+   * @return the first index in [begin, end) whose key is greater than target if Inclusive, not less than it otherwise.
+   * The loop always runs log2(n) times, and the compiler turns the step into a conditional move, so there are no
+   * mispredicted branches.
+   */
+  template <bool Inclusive>
+  static auto IntegerSearch(const MappingType *array, int begin, int end, const KeyComparator &comparator,
+                            int64_t target) -> int {
+    auto is_before = [target](int64_t probe) { return Inclusive ? probe <= target : probe < target; };
+    int length = end - begin;
+    if (length <= 0) {
+      return begin;
+    }
+    const MappingType *first = array + begin;
+    if constexpr (SimdWindow() > 1) {
+      if (comparator.IntegerSize() == sizeof(int64_t)) {
+        while (length > SimdWindow()) {
+          int half = length / 2;
+          first = is_before(comparator.IntegerAt(first[half - 1].first)) ? first + half : first;
+          length -= half;
+        }
+        return static_cast<int>(first - array) + CountBefore<Inclusive>(first, length, target);
+      }
+    }
+    while (length > 1) {
+      int half = length / 2;
+      first = is_before(comparator.IntegerAt(first[half - 1].first)) ? first + half : first;
+      length -= half;
+    }
+    return static_cast<int>(first - array) + (is_before(comparator.IntegerAt(first->first)) ? 1 : 0);
+  }
+
+  /** @return the number of slots the vector compares take, 1 if they are not available for this page layout */
+  static constexpr auto SimdWindow() -> int {
+#if defined(__AVX2__) || defined(__SSE4_2__)
+    // The keys must sit 16 bytes apart, at the start of each slot, as in leaf pages with RID values.
+    if constexpr (KeySize == sizeof(int64_t) && sizeof(MappingType) == 2 * sizeof(int64_t)) {
+      return SIMD_WINDOW;
+    }
+#endif
+    return 1;
+  }
+
+  /** @return the number of 8-byte integer keys among the first length slots that are before target */
+  template <bool Inclusive>
+  static auto CountBefore(const MappingType *first, int length, int64_t target) -> int {
+    int count = 0;
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i targets = _mm256_set1_epi64x(target);
+    for (; i + 4 <= length; i += 4) {
+      // Each load holds two slots, their keys in the low halves of the 128-bit lanes.
+      __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i));
+      __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first + i + 2));
+      __m256i keys = _mm256_unpacklo_epi64(low, high);
+      __m256i mask = Inclusive ? _mm256_cmpgt_epi64(keys, targets) : _mm256_cmpgt_epi64(targets, keys);
+      int matches = __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+      count += Inclusive ? 4 - matches : matches;
+    }
+#elif defined(__SSE4_2__)
+    __m128i targets = _mm_set1_epi64x(target);
+    for (; i + 2 <= length; i += 2) {
+      __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i));
+      __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first + i + 1));
+      __m128i keys = _mm_unpacklo_epi64(low, high);
+      __m128i mask = Inclusive ? _mm_cmpgt_epi64(keys, targets) : _mm_cmpgt_epi64(targets, keys);
+      int matches = __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(mask)));
+      count += Inclusive ? 2 - matches : matches;
+    }
+#endif
+    for (; i < length; i++) {
+      int64_t probe;
+      memcpy(&probe, first[i].first.data_, sizeof(probe));
+      count += (Inclusive ? probe <= target : probe < target) ? 1 : 0;
+    }
+    return count;
+  }
+};
+
+}  // namespace bustub
@@ -0,0 +1,113 @@
+/**
+ * varlen_b_plus_tree.h
+ *
+ * A B+ tree over byte string keys of any length up to VARLEN_KEY_MAX_SIZE, kept in slotted pages with prefix
+ * compression (see BPlusTreeVarlenPage). Keys are compared byte by byte, so they must be encoded to sort as their
+ * values do, see VarlenBPlusTreeIndex.
+ * (1) We only support unique key
+ * (2) support insert & remove, a page left less than a quarter full is merged into a sibling if both fit into one
+ * (3) Separators taken up on a leaf split are cut down to the shortest key that separates both leaves
+ * (4) Forward range scans with VarlenIndexIterator
+ */
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+#include "common/rid.h"
+#include "concurrency/transaction.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+/**
+ * Iterates over the entries of a VarlenBPlusTree in key order, holding a read latch on the current leaf. Leaves are
+ * latched left to right, the order in which merges latch them as well.
+ */
+class VarlenIndexIterator {
+  using LeafPage = BPlusTreeVarlenPage<RID>;
+
+ public:
+  VarlenIndexIterator() = default;
+  VarlenIndexIterator(BufferPoolManager *bpm, ReadPageGuard leaf_guard, int index);
+
+  auto IsEnd() const -> bool { return leaf_ == nullptr; }
+
+  auto Key() const -> std::string { return leaf_->KeyAt(index_); }
+
+  auto Value() const -> RID { return leaf_->ValueAt(index_); }
+
+  auto operator++() -> VarlenIndexIterator &;
+
+ private:
+  /** Moves past the end of the leaf to the first entry of the next leaf that has any. */
+  void SkipEmptyLeaves();
+
+  BufferPoolManager *bpm_{nullptr};
+  ReadPageGuard leaf_guard_;
+  const LeafPage *leaf_{nullptr};
+  int index_{0};
+};
+
+class VarlenBPlusTree {
+  using InternalPage = BPlusTreeVarlenPage<page_id_t>;
+  using LeafPage = BPlusTreeVarlenPage<RID>;
+
+ public:
+  explicit VarlenBPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager);
+
+  // Returns true if this B+ tree has no keys and values.
+  auto IsEmpty() const -> bool;
+
+  // Insert a key-value pair into this B+ tree. Throws if the key is longer than VARLEN_KEY_MAX_SIZE.
+  auto Insert(std::string_view key, const RID &value, Transaction *txn = nullptr) -> bool;
+
+  // Remove a key and its value from this B+ tree.
+  void Remove(std::string_view key, Transaction *txn = nullptr);
+
+  // Return the value associated with a given key
+  auto GetValue(std::string_view key, std::vector<RID> *result, Transaction *txn = nullptr) -> bool;
+
+  // Return the page id of the root node
+  auto GetRootPageId() const -> page_id_t;
+
+  // Index iterator, from the first key or from the first key not smaller than key
+  auto Begin() -> VarlenIndexIterator;
+
+  auto Begin(std::string_view key) -> VarlenIndexIterator;
+
+ private:
+  /** Read-latches the path to the leaf of key, and returns the latched leaf, or nothing if the tree is empty. */
+  auto FindLeafRead(std::string_view key, bool leftmost) -> std::optional<ReadPageGuard>;
+
+  /** Inserts the separator of a split of page left_id into the parents in ctx, splitting them in turn if needed. */
+  void InsertIntoParent(page_id_t left_id, std::string separator, page_id_t right_id, Context *ctx);
+
+  /**
+   * Merges the last page of ctx->write_set_, which lost an entry below key, into its sibling if it is underfull and
+   * both fit into one page, then does the same for the parent, which lost a separator. Shrinks the root instead when
+   * it gets there.
+   */
+  void MergeUnderfull(std::string_view key, Context *ctx);
+
+  /** Empties the tree if the root is an empty leaf, or makes the only child of an internal root the new root. */
+  void AdjustRoot(WritePageGuard *root_guard, Context *ctx);
+
+  auto NewPage(page_id_t *page_id) -> BasicPageGuard;
+
+  // Delete a page that was merged away, waiting for other threads to unpin it.
+  void DeletePage(page_id_t page_id);
+
+  // member variable
+  std::string index_name_;
+  BufferPoolManager *bpm_;
+  page_id_t header_page_id_;
+};
+
+}  // namespace bustub
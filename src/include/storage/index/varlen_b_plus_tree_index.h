@@ -0,0 +1,54 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree_index.h
+//
+// Identification: src/include/storage/index/varlen_b_plus_tree_index.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "storage/index/index.h"
+#include "storage/index/varlen_b_plus_tree.h"
+
+namespace bustub {
+
+/**
+ * An index over a VarlenBPlusTree. Keys take as many bytes as their values need rather than a fixed GenericKey<N>
+ * slot, so long VARCHAR keys and keys of many columns do not waste page space.
+ */
+class VarlenBPlusTreeIndex : public Index {
+ public:
+  VarlenBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+
+  auto InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool override;
+
+  void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
+
+  void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
+
+  auto GetBeginIterator() -> VarlenIndexIterator;
+
+  auto GetBeginIterator(const Tuple &key) -> VarlenIndexIterator;
+
+  /**
+   * Encodes a key tuple so that comparing the bytes of two keys orders them as comparing their values column by
+   * column does. NULL sorts first, integers are stored big-endian with the sign bit flipped, and VARCHARs end with
+   * 0x00 0x00 after escaping each 0x00 in them as 0x00 0xFF.
+   */
+  static auto EncodeKey(const Tuple &key, const Schema &key_schema) -> std::string;
+
+ protected:
+  // container
+  std::shared_ptr<VarlenBPlusTree> container_;
+};
+
+}  // namespace bustub
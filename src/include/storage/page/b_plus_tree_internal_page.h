@@ -85,6 +85,14 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   auto MoveFrontTo(B_PLUS_TREE_INTERNAL_PAGE_TYPE *page, const KeyType &parent_key) -> KeyType;
   auto MoveEndTo(B_PLUS_TREE_INTERNAL_PAGE_TYPE *page, const KeyType &parent_key) -> KeyType;
   void Remove(int index);
+
+  /**
+   * Add a child after the last one, the first child's key is not used for searches
+   * @param key the smallest key in the child, which must be greater than all other keys
+   * @param child_id the page id of the child
+   */
+  void Append(const KeyType &key, page_id_t child_id);
+
   /**
    *
    * @param index the index
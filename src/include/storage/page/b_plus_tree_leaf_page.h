@@ -60,16 +60,21 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   auto GetNextPageId() const -> page_id_t;
   void SetNextPageId(page_id_t next_page_id);
   auto KeyAt(int index) const -> KeyType;
-  auto ValueAtKey(const KeyType &key, ValueType &v, KeyComparator comparator_) -> bool;
+  auto ValueAtKey(const KeyType &key, ValueType &v, KeyComparator comparator_) const -> bool;
   auto Insert(const KeyType &key, const ValueType &value, KeyComparator comparator_) -> bool;
   auto Split(B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf_page) -> KeyType;
   auto KetIndex(const KeyType &key, KeyComparator comparator_) -> int;
-  auto ArrayIt(int index) -> const MappingType &;
+  // Index of the first pair whose key is not less than (greater than) key, GetSize() if there is none
+  auto LowerKeyIndex(const KeyType &key, KeyComparator comparator_) const -> int;
+  auto UpperKeyIndex(const KeyType &key, KeyComparator comparator_) const -> int;
+  auto ArrayIt(int index) const -> const MappingType &;
   auto RemoveRecord(const KeyType &key, KeyComparator comparator_) -> bool;
   void MoveAll(B_PLUS_TREE_LEAF_PAGE_TYPE *recipient);
   auto MoveFrontTo(B_PLUS_TREE_LEAF_PAGE_TYPE *page) -> KeyType;
   auto MoveEndTo(B_PLUS_TREE_LEAF_PAGE_TYPE *page) -> KeyType;
   void SetKeyValueAt(int index, const KeyType &key, const ValueType &value);
+  // Add a pair after the last one, its key must be greater than all others
+  void Append(const KeyType &key, const ValueType &value);
   /**
    * @brief for test only return a string representing all keys in
    * this leaf page formatted as "(key1,key2,key3,...)"
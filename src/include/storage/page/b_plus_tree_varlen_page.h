@@ -0,0 +1,157 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.h
+//
+// Identification: src/include/storage/page/b_plus_tree_varlen_page.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/page/b_plus_tree_page.h"
+
+namespace bustub {
+
+#define B_PLUS_TREE_VARLEN_PAGE_TYPE BPlusTreeVarlenPage<ValueType>
+#define VARLEN_PAGE_HEADER_SIZE 28
+
+/**
+ * A B+ tree page for byte string keys of any length up to VARLEN_KEY_MAX_SIZE, used as a leaf page with RID values
+ * and as an internal page with page id values. Keys are compared byte by byte.
+ *
+ * The bytes all keys of the page start with are stored once as the prefix, and each slot only points at the rest of
+ * its key. The slots grow from the header towards the end of the page, the key bytes from the end of the page towards
+ * the slots. Removing a key leaves its bytes behind, they are given back when the page is rebuilt.
+ *
+ * Varlen page format (keys are stored in order):
+ *  -------------------------------------------------------------------------------------
+ * | HEADER | SLOT(1) | SLOT(2) | ... | SLOT(n) | FREE | ... KEY(2) | KEY(1) | PREFIX |
+ *  -------------------------------------------------------------------------------------
+ *
+ *  Slot format: | KeyOffset (4) | KeySize (2) | Value |
+ *
+ *  Offsets are 32 bits wide, as a 64 KiB page (see BUSTUB_PAGE_SIZE) ends at an offset that 16 bits cannot hold.
+ *
+ *  Header format (size in byte, 28 bytes in total):
+ *  ---------------------------------------------------------------------
+ * | PageType (4) | CurrentSize (4) | MaxSize (4) | NextPageId (4) |
+ *  ---------------------------------------------------------------------
+ *  ---------------------------------------------------------------------
+ * | PrefixOffset (4) | KeysBegin (4) | PrefixSize (2) | FreedBytes (2) |
+ *  ---------------------------------------------------------------------
+ *
+ * As in BPlusTreeInternalPage, the key of the first slot of an internal page is not used, and the child at index i
+ * holds the keys in [KeyAt(i), KeyAt(i + 1)). The next page id is only used by leaf pages.
+ */
+template <typename ValueType>
+class BPlusTreeVarlenPage : public BPlusTreePage {
+ public:
+  using Entry = std::pair<std::string, ValueType>;
+
+  // Delete all constructor / destructor to ensure memory safety
+  BPlusTreeVarlenPage() = delete;
+  BPlusTreeVarlenPage(const BPlusTreeVarlenPage &other) = delete;
+
+  /**
+   * After creating a new page from buffer pool, must call initialize method to set default values
+   * @param page_type leaf or internal page
+   */
+  void Init(IndexPageType page_type);
+
+  // helper methods
+  auto GetNextPageId() const -> page_id_t;
+  void SetNextPageId(page_id_t next_page_id);
+  auto GetPrefix() const -> std::string_view;
+  auto KeyAt(int index) const -> std::string;
+  auto ValueAt(int index) const -> ValueType;
+  void SetValueAt(int index, const ValueType &value);
+
+  /** @return negative, zero or positive as the key at index is smaller than, equal to or greater than key */
+  auto CompareAt(int index, std::string_view key) const -> int;
+
+  /** @return the first index with a key not smaller than key, skipping the unused key of an internal page */
+  auto LowerBound(std::string_view key) const -> int;
+
+  /** @return the first index with a key greater than key, skipping the unused key of an internal page */
+  auto UpperBound(std::string_view key) const -> int;
+
+  /**
+   * Inserts the entry at index, giving up the prefix if the key does not start with it.
+   * @return false if the page has no room for it, the page is left as it was
+   */
+  auto Insert(int index, std::string_view key, const ValueType &value) -> bool;
+
+  void Remove(int index);
+
+  /**
+   * @return whether inserting key into a leaf page, or the separator of a split below key into an internal page, is
+   * sure to fit without a split
+   */
+  auto IsSafeForInsert(std::string_view key) const -> bool;
+
+  /**
+   * @return whether removing key from a leaf page, or the separator of a merge below key from an internal page, is sure
+   * to leave the page at least a quarter full
+   */
+  auto IsSafeForRemove(std::string_view key) const -> bool;
+
+  /** @return whether the page is less than a quarter full, so that the tree tries to merge it with a sibling */
+  auto IsUnderfull() const -> bool;
+
+  /** @return whether entries fit into one page */
+  auto Fits(const std::vector<Entry> &entries) const -> bool;
+
+  /** @return a copy of all entries with their whole keys */
+  auto Entries() const -> std::vector<Entry>;
+
+  /** Replaces the entries of the page with entries [begin, end), which must fit, and picks a new prefix for them. */
+  void Rebuild(const std::vector<Entry> &entries, size_t begin, size_t end);
+
+  /**
+   * Picks where to split entries that do not fit into this page: entries [0, split) stay here, the others go to a new
+   * page. The split evens out the bytes both pages take, each with its own prefix.
+   */
+  auto SplitPoint(const std::vector<Entry> &entries) const -> size_t;
+
+  /**
+   * Suffix truncation: the shortest key that is greater than left and not greater than right, to separate two leaves
+   * in their parent.
+   */
+  static auto Separator(std::string_view left, std::string_view right) -> std::string;
+
+ private:
+  struct Slot {
+    uint32_t key_offset_;
+    uint16_t key_size_;
+    ValueType value_;
+  };
+
+  static constexpr size_t CAPACITY = BUSTUB_PAGE_SIZE - VARLEN_PAGE_HEADER_SIZE;
+  /** Pages that take fewer bytes are underfull. */
+  static constexpr size_t MIN_USED_BYTES = CAPACITY / 4;
+
+  auto FirstKeyIndex() const -> int { return IsLeafPage() ? 0 : 1; }
+  auto SuffixAt(int index) const -> std::string_view;
+  auto FreeBytes() const -> size_t;
+  /** @return the bytes entries [begin, end) take in a page, with their common prefix stored once */
+  auto PackedSize(const std::vector<Entry> &entries, size_t begin, size_t end) const -> size_t;
+
+  page_id_t next_page_id_;
+  uint32_t prefix_offset_;
+  uint32_t keys_begin_;
+  uint16_t prefix_size_;
+  uint16_t freed_bytes_;
+  // Flexible array member for page data.
+  Slot array_[0];
+};
+
+}  // namespace bustub
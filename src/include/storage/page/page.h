@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <new>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -30,14 +32,27 @@ class Page {
   friend class BufferPoolManager;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() {
-    data_ = new char[BUSTUB_PAGE_SIZE];
+  /**
+   * Constructor. Zeros out the page data. The data is aligned to the page size, so that it can be handed to a disk
+   * manager that bypasses the page cache (O_DIRECT).
+   */
+  Page() : owns_data_(true) {
+    data_ = new (std::align_val_t{BUSTUB_PAGE_SIZE}) char[BUSTUB_PAGE_SIZE];
     ResetMemory();
   }
 
+  /**
+   * Constructor for a frame of the buffer pool, whose data lives in the pool's FrameArena.
+   * @param data the zeroed, page-aligned frame data, which the page does not own
+   */
+  explicit Page(char *data) : data_(data) {}
+
   /** Default destructor. */
-  ~Page() { delete[] data_; }
+  ~Page() {
+    if (owns_data_) {
+      ::operator delete[](data_, std::align_val_t{BUSTUB_PAGE_SIZE});
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline auto GetData() -> char * { return data_; }
@@ -46,16 +61,23 @@ class Page {
   inline auto GetPageId() -> page_id_t { return page_id_; }
 
   /** @return the pin count of this page */
-  inline auto GetPinCount() -> int { return pin_count_; }
+  inline auto GetPinCount() -> int { return pin_count_.load(); }
 
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -63,6 +85,15 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /** @return the contention counters of the latch of this frame, summed over all pages it held so far. */
+  inline auto GetLatchStats() const -> LatchStats { return rwlatch_.GetStats(); }
+
+  /**
+   * @return the version of the page data, which changes whenever the data may have changed: it is odd while a writer
+   * holds the write latch, and moves on when the frame is reused for another page. See OptimisticPageGuard.
+   */
+  inline auto GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -79,20 +110,42 @@ class Page {
 
  private:
   /** Zeroes out the data that is held within the page. */
-  inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
+  inline void ResetMemory() {
+    BumpVersion();
+    memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE);
+  }
+
+  /** Tells optimistic readers that the data is about to change without the write latch, e.g. for another page. */
+  inline void BumpVersion() {
+    version_.fetch_add(2, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** The actual data that is stored within a page. */
   // Usually this should be stored as `char data_[BUSTUB_PAGE_SIZE]{};`. But to enable ASAN to detect page overflow,
   // we store it as a ptr.
   char *data_;
-  /** The ID of this page. */
-  page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** True if data_ was allocated by the page itself. */
+  bool owns_data_ = false;
+  /** The ID of this page. Atomic, as lock-free lookups check it to tell whether the frame still holds their page. */
+  std::atomic<page_id_t> page_id_{INVALID_PAGE_ID};
+  /**
+   * The pin count of this page, or -1 while the shard claims the frame to give it another page or free it (see
+   * BufferPoolManager::ClaimFrame()). Hits pin the frame without the shard latch, but never a claimed one.
+   */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
-  bool is_dirty_ = false;
+  std::atomic<bool> is_dirty_{false};
+  /** True while the buffer pool is filling the frame, i.e. writing back its old page or reading this page in. */
+  std::atomic<bool> io_in_progress_{false};
+  /** True while the buffer pool writes this page out without holding the shard latch, see FlushPage(). */
+  bool write_in_progress_ = false;
+  /** True while the frame is in its shard's unpin log, see BufferPoolManager::UnpinPage(Page *, bool). */
+  std::atomic<bool> unpin_logged_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** The version of the page data, see GetVersion(). */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
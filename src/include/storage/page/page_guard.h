@@ -214,4 +214,46 @@ class WritePageGuard {
   BasicPageGuard guard_;
 };
 
+/**
+ * OptimisticPageGuard lets a reader look at a page without latching or pinning it, so that readers do not write to
+ * shared memory. Nothing stops a writer from changing the page, or the buffer pool from reusing its frame, meanwhile:
+ * whatever is read through the guard may be inconsistent, must be bounds-checked before it is used to index into the
+ * page, and may only be acted upon once Validate() has returned true.
+ */
+class OptimisticPageGuard {
+ public:
+  OptimisticPageGuard() = default;
+  OptimisticPageGuard(Page *page, page_id_t page_id, uint64_t version)
+      : page_(page), page_id_(page_id), version_(version) {}
+
+  /** Stop looking at the page. The guard holds no latch or pin, so there is nothing to release. */
+  void Drop() { page_ = nullptr; }
+
+  /**
+   * @return true if the page has not changed since the guard was created, i.e. everything read through the guard so
+   * far is a consistent image of page PageId(). False for an empty guard.
+   */
+  auto Validate() const -> bool {
+    if (page_ == nullptr || (version_ & 1) != 0) {
+      return false;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return page_->GetVersion() == version_;
+  }
+
+  auto PageId() const -> page_id_t { return page_id_; }
+
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+ private:
+  Page *page_{nullptr};
+  page_id_t page_id_{INVALID_PAGE_ID};
+  uint64_t version_{0};
+};
+
 }  // namespace bustub
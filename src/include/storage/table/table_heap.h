@@ -63,9 +63,10 @@ class TableHeap {
   /**
    * Read a tuple from the table.
    * @param rid rid of the tuple to read
+   * @param access_type how the page is accessed, AccessType::Scan when reading through a table iterator
    * @return the meta and tuple
    */
-  auto GetTuple(RID rid) -> std::pair<TupleMeta, Tuple>;
+  auto GetTuple(RID rid, AccessType access_type = AccessType::Unknown) -> std::pair<TupleMeta, Tuple>;
 
   /**
    * Read a tuple meta from the table. Note: if you want to get tuple and meta together, use `GetTuple` insead
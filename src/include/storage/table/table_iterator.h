@@ -16,6 +16,7 @@
 #include <memory>
 #include <utility>
 
+#include "buffer/read_ahead_window.h"
 #include "common/macros.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
@@ -57,6 +58,9 @@ class TableIterator {
   // Otherwise we will have dead loops when updating while scanning. (In project 4, update should be implemented as
   // deletion + insertion.)
   RID stop_at_rid_;
+
+  /** Prefetches the table pages ahead of rid_. */
+  ReadAheadWindow read_ahead_;
 };
 
 }  // namespace bustub
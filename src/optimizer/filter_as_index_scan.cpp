@@ -0,0 +1,137 @@
+#include <memory>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Collects the terms of a chain of ANDs. */
+void SplitConjunction(const AbstractExpressionRef &expr, std::vector<AbstractExpressionRef> *terms) {
+  if (const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr.get());
+      logic_expr != nullptr && logic_expr->logic_type_ == LogicType::And) {
+    SplitConjunction(logic_expr->children_[0], terms);
+    SplitConjunction(logic_expr->children_[1], terms);
+    return;
+  }
+  terms->push_back(expr);
+}
+
+/**
+ * Narrows the range [lower, upper] with a comparison of column col_idx with a constant of its own type. Returns false
+ * if the term is of another form or the end it bounds is already taken, and must then be kept as a filter.
+ */
+auto NarrowRange(const AbstractExpressionRef &term, uint32_t col_idx, IndexScanBound *lower, IndexScanBound *upper)
+    -> bool {
+  const auto *comp_expr = dynamic_cast<const ComparisonExpression *>(term.get());
+  if (comp_expr == nullptr) {
+    return false;
+  }
+  auto comp_type = comp_expr->comp_type_;
+  const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(comp_expr->children_[0].get());
+  auto constant = comp_expr->children_[1];
+  if (column_expr == nullptr) {
+    // constant <op> column, turn it around.
+    column_expr = dynamic_cast<const ColumnValueExpression *>(comp_expr->children_[1].get());
+    constant = comp_expr->children_[0];
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  if (column_expr == nullptr || column_expr->GetTupleIdx() != 0 || column_expr->GetColIdx() != col_idx ||
+      dynamic_cast<const ConstantValueExpression *>(constant.get()) == nullptr ||
+      constant->GetReturnType() != column_expr->GetReturnType()) {
+    return false;
+  }
+
+  bool bounds_lower = comp_type == ComparisonType::Equal || comp_type == ComparisonType::GreaterThan ||
+                      comp_type == ComparisonType::GreaterThanOrEqual;
+  bool bounds_upper = comp_type == ComparisonType::Equal || comp_type == ComparisonType::LessThan ||
+                      comp_type == ComparisonType::LessThanOrEqual;
+  if ((!bounds_lower && !bounds_upper) || (bounds_lower && lower->key_ != nullptr) ||
+      (bounds_upper && upper->key_ != nullptr)) {
+    return false;
+  }
+  if (bounds_lower) {
+    *lower = {constant, comp_type != ComparisonType::GreaterThan};
+  }
+  if (bounds_upper) {
+    *upper = {constant, comp_type != ComparisonType::LessThan};
+  }
+  return true;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeFilterAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::Filter || optimized_plan->GetChildAt(0)->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*optimized_plan->GetChildAt(0));
+  if (seq_scan.filter_predicate_ != nullptr) {
+    return optimized_plan;
+  }
+
+  std::vector<AbstractExpressionRef> terms;
+  SplitConjunction(filter_plan.GetPredicate(), &terms);
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+  // Use the first index whose leading key column the predicate bounds, the terms left over stay in a filter.
+  for (const auto *index : catalog_.GetTableIndexes(table_info->name_)) {
+    uint32_t col_idx = index->index_->GetKeyAttrs()[0];
+    IndexScanBound lower;
+    IndexScanBound upper;
+    std::vector<AbstractExpressionRef> rest;
+    for (const auto &term : terms) {
+      if (!NarrowRange(term, col_idx, &lower, &upper)) {
+        rest.push_back(term);
+      }
+    }
+    if (lower.key_ == nullptr && upper.key_ == nullptr) {
+      continue;
+    }
+
+    AbstractPlanNodeRef index_scan =
+        std::make_shared<IndexScanPlanNode>(seq_scan.output_schema_, index->index_oid_, lower, upper);
+    if (rest.empty()) {
+      return index_scan;
+    }
+    AbstractExpressionRef predicate = rest[0];
+    for (size_t i = 1; i < rest.size(); i++) {
+      predicate = std::make_shared<LogicExpression>(predicate, rest[i], LogicType::And);
+    }
+    return std::make_shared<FilterPlanNode>(filter_plan.output_schema_, predicate, index_scan);
+  }
+  return optimized_plan;
+}
+
+}  // namespace bustub
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <memory>
+#include <set>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/plans/abstract_plan.h"
+#include "execution/plans/aggregation_plan.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/projection_plan.h"
+#include "execution/plans/sort_plan.h"
+#include "execution/plans/topn_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Adds the columns of its input that expr reads to columns. */
+void CollectColumns(const AbstractExpressionRef &expr, std::set<uint32_t> *columns) {
+  if (const auto *column_value_expr = dynamic_cast<const ColumnValueExpression *>(expr.get());
+      column_value_expr != nullptr) {
+    columns->insert(column_value_expr->GetColIdx());
+  }
+  for (const auto &child : expr->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+/**
+ * Adds the columns a plan node reads from its child to columns, if the node outputs rows of its child unchanged.
+ * @return false for any other node
+ */
+auto CollectPassThroughColumns(const AbstractPlanNode &plan, std::set<uint32_t> *columns) -> bool {
+  switch (plan.GetType()) {
+    case PlanType::Filter:
+      CollectColumns(dynamic_cast<const FilterPlanNode &>(plan).GetPredicate(), columns);
+      return true;
+    case PlanType::Sort:
+      for (const auto &[order_type, expr] : dynamic_cast<const SortPlanNode &>(plan).GetOrderBy()) {
+        CollectColumns(expr, columns);
+      }
+      return true;
+    case PlanType::TopN:
+      for (const auto &[order_type, expr] : dynamic_cast<const TopNPlanNode &>(plan).GetOrderBy()) {
+        CollectColumns(expr, columns);
+      }
+      return true;
+    case PlanType::Limit:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/** Copies the chain of pass-through nodes down to an index scan, with the scan made index-only. */
+auto WithIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  if (plan->GetType() == PlanType::IndexScan) {
+    const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*plan);
+    return std::make_shared<IndexScanPlanNode>(index_scan.output_schema_, index_scan.GetIndexOid(), index_scan.lower_,
+                                               index_scan.upper_, index_scan.reverse_, true);
+  }
+  return plan->CloneWithChildren({WithIndexOnlyScan(plan->GetChildAt(0))});
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeIndexOnlyScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeIndexOnlyScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  // Projections and aggregations make rows of their own, so the columns they read are all that is read of the rows
+  // of an index scan below them, through filters, sorts and limits.
+  std::set<uint32_t> columns;
+  if (optimized_plan->GetType() == PlanType::Projection) {
+    for (const auto &expr : dynamic_cast<const ProjectionPlanNode &>(*optimized_plan).GetExpressions()) {
+      CollectColumns(expr, &columns);
+    }
+  } else if (optimized_plan->GetType() == PlanType::Aggregation) {
+    const auto &aggregation_plan = dynamic_cast<const AggregationPlanNode &>(*optimized_plan);
+    for (const auto &expr : aggregation_plan.GetGroupBys()) {
+      CollectColumns(expr, &columns);
+    }
+    for (const auto &expr : aggregation_plan.GetAggregates()) {
+      CollectColumns(expr, &columns);
+    }
+  } else {
+    return optimized_plan;
+  }
+
+  const AbstractPlanNode *node = optimized_plan->GetChildAt(0).get();
+  while (node->GetType() != PlanType::IndexScan) {
+    if (!CollectPassThroughColumns(*node, &columns)) {
+      return optimized_plan;
+    }
+    node = node->GetChildAt(0).get();
+  }
+  const auto *index = catalog_.GetIndex(dynamic_cast<const IndexScanPlanNode &>(*node).GetIndexOid());
+  const auto &entry_attrs = index->index_->GetEntryAttrs();
+  for (auto column : columns) {
+    if (std::find(entry_attrs.begin(), entry_attrs.end(), column) == entry_attrs.end()) {
+      return optimized_plan;
+    }
+  }
+  return optimized_plan->CloneWithChildren({WithIndexOnlyScan(optimized_plan->GetChildAt(0))});
+}
+
+}  // namespace bustub
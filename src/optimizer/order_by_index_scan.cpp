@@ -33,9 +33,10 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &order_bys = sort_plan.GetOrderBy();
 
     std::vector<uint32_t> order_by_column_ids;
+    // All columns ascending scans the index forwards, all descending scans it backwards.
+    bool reverse = !order_bys.empty() && order_bys[0].first == OrderByType::DESC;
     for (const auto &[order_type, expr] : order_bys) {
-      // Order type is asc or default
-      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+      if ((order_type == OrderByType::DESC) != reverse) {
         return optimized_plan;
       }
 
@@ -52,6 +53,17 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     BUSTUB_ENSURE(optimized_plan->children_.size() == 1, "Sort with multiple children?? Impossible!");
     const auto &child_plan = optimized_plan->children_[0];
 
+    // A range scan of an index on the order by columns, only its direction needs to be set.
+    if (child_plan->GetType() == PlanType::IndexScan) {
+      const auto &index_scan = dynamic_cast<const IndexScanPlanNode &>(*child_plan);
+      const auto *index = catalog_.GetIndex(index_scan.GetIndexOid());
+      std::vector<uint32_t> key_column_ids(index->index_->GetKeyAttrs());
+      if (key_column_ids == order_by_column_ids) {
+        return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index_scan.GetIndexOid(),
+                                                   index_scan.lower_, index_scan.upper_, reverse);
+      }
+    }
+
     if (child_plan->GetType() == PlanType::SeqScan) {
       const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
       const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
@@ -69,7 +81,8 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
             }
           }
           if (valid) {
-            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
+            return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_,
+                                                       IndexScanBound{}, IndexScanBound{}, reverse);
           }
         }
       }
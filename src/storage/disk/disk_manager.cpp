@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <exception>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
@@ -36,18 +39,7 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     LOG_DEBUG("wrong file format");
     return;
   }
-  log_name_ = file_name_.substr(0, n) + ".log";
-
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
-  }
+  OpenLogFile(db_file);
 
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
@@ -63,6 +55,100 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
   buffer_used = nullptr;
 }
 
+/**
+ * Open the checksum file that belongs to the database file
+ */
+void DiskManager::EnableChecksums() {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n == std::string::npos) {
+    throw Exception("checksums need a database file");
+  }
+  checksums_ = std::make_unique<PageChecksums>(file_name_.substr(0, n) + ".crc", file_name_);
+}
+
+/**
+ * Read every page that is in the database file or has a checksum without verifying it, and settle its checksum
+ */
+auto DiskManager::RecoverChecksums() -> std::vector<page_id_t> {
+  std::vector<page_id_t> torn_page_ids;
+  if (checksums_ == nullptr) {
+    return torn_page_ids;
+  }
+  auto checksums = std::move(checksums_);
+  auto file_size = GetFileSize(file_name_);
+  auto page_cnt = static_cast<page_id_t>((std::max<off_t>(file_size, 0) + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE);
+  auto slot_cnt = static_cast<page_id_t>(checksums->GetSlotCount());
+  std::vector<char> page_data(BUSTUB_PAGE_SIZE);
+  try {
+    for (page_id_t page_id = 0; page_id < std::max(page_cnt, slot_cnt); page_id++) {
+      // Pages past the end of the file read as zeros, which is what a write that never reached the disk left behind.
+      std::fill(page_data.begin(), page_data.end(), 0);
+      if (page_id < page_cnt) {
+        ReadPage(page_id, page_data.data());
+      }
+      if (!checksums->Recover(page_id, page_data.data())) {
+        torn_page_ids.push_back(page_id);
+      }
+    }
+    checksums->Sync();
+  } catch (...) {
+    checksums_ = std::move(checksums);
+    throw;
+  }
+  checksums_ = std::move(checksums);
+  return torn_page_ids;
+}
+
+/**
+ * Open the free-space map file that belongs to the database file
+ */
+void DiskManager::EnableFreeSpaceMap() {
+  std::string::size_type n = file_name_.rfind('.');
+  if (n == std::string::npos) {
+    throw Exception("a persistent free space map needs a database file");
+  }
+  free_space_ = std::make_unique<FreeSpaceMap>(file_name_.substr(0, n) + ".fsm");
+}
+
+auto DiskManager::AllocatePage() -> page_id_t { return free_space_->Allocate(); }
+
+/**
+ * Return a page to the free-space map. Its checksum is forgotten, since the page may be cut off the file and then read
+ * back as zeros once it is reused.
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  if (!free_space_->Deallocate(page_id)) {
+    LOG_DEBUG("deallocating a page that is not allocated");
+    return;
+  }
+  if (checksums_ != nullptr) {
+    checksums_->Clear(page_id);
+  }
+}
+
+/**
+ * Truncate the database file to the pages that are allocated
+ */
+auto DiskManager::ShrinkToFit() -> size_t {
+  if (file_name_.empty()) {
+    return 0;
+  }
+  size_t shrunk_page_cnt = 0;
+  free_space_->Shrink([&](page_id_t page_count) {
+    std::scoped_lock scoped_db_io_latch(db_io_latch_);
+    off_t file_size = GetFileSize(file_name_);
+    auto size = static_cast<off_t>(page_count) * BUSTUB_PAGE_SIZE;
+    if (file_size <= size) {
+      return;
+    }
+    if (truncate(file_name_.c_str(), size) != 0) {
+      throw Exception("can't truncate db file");
+    }
+    shrunk_page_cnt = (file_size - size + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE;
+  });
+  return shrunk_page_cnt;
+}
+
 /**
  * Close all file streams
  */
@@ -78,6 +164,10 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  if (checksums_ != nullptr) {
+    checksums_->Prepare(page_id, 1, page_data);
+    checksums_->Sync();
+  }
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
   size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
   // set write cursor to offset
@@ -93,16 +183,42 @@ void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
   db_io_.flush();
 }
 
+/**
+ * Write the contents of consecutive pages into disk file
+ */
+void DiskManager::WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) {
+  if (checksums_ != nullptr) {
+    checksums_->Prepare(start_page_id, page_count, page_data);
+    checksums_->Sync();
+  }
+  std::scoped_lock scoped_db_io_latch(db_io_latch_);
+  size_t offset = static_cast<size_t>(start_page_id) * BUSTUB_PAGE_SIZE;
+  num_writes_ += static_cast<int>(page_count);
+  db_io_.seekp(offset);
+  db_io_.write(page_data, page_count * BUSTUB_PAGE_SIZE);
+  if (db_io_.bad()) {
+    LOG_DEBUG("I/O error while writing");
+    return;
+  }
+  db_io_.flush();
+}
+
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
   std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
+  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  off_t file_size = GetFileSize(file_name_);
+  if (file_size < 0 || offset > static_cast<size_t>(file_size)) {
     LOG_DEBUG("I/O error reading past end of file");
     // std::cerr << "I/O error while reading" << std::endl;
+    if (checksums_ != nullptr) {
+      // A page that has been written before must not have gone missing.
+      memset(page_data, 0, BUSTUB_PAGE_SIZE);
+      checksums_->Verify(page_id, page_data);
+    }
   } else {
     // set read cursor to offset
     db_io_.seekp(offset);
@@ -119,9 +235,71 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
       // std::cerr << "Read less than a page" << std::endl;
       memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
     }
+    if (checksums_ != nullptr) {
+      checksums_->Verify(page_id, page_data);
+    }
+  }
+}
+
+/**
+ * Run a batch of page I/Os one after the other
+ */
+void DiskManager::Submit(std::vector<DiskRequest> requests) {
+  PrepareChecksums(requests);
+  for (auto &request : requests) {
+    try {
+      if (request.is_write_) {
+        WritePages(request.page_id_, request.page_count_, request.data_);
+      } else {
+        for (size_t i = 0; i < request.page_count_; i++) {
+          ReadPage(request.page_id_ + i, request.data_ + i * BUSTUB_PAGE_SIZE);
+        }
+      }
+      request.callback_.set_value();
+    } catch (...) {
+      request.callback_.set_exception(std::current_exception());
+    }
+  }
+}
+
+void DiskManager::PrepareChecksums(const std::vector<DiskRequest> &requests) {
+  if (checksums_ == nullptr) {
+    return;
+  }
+  try {
+    for (const auto &request : requests) {
+      if (request.is_write_) {
+        checksums_->Prepare(request.page_id_, request.page_count_, request.data_);
+      }
+    }
+    checksums_->Sync();
+  } catch (...) {
+    // The writes prepare and sync again and fail on their own.
   }
 }
 
+/**
+ * Submit a single page read
+ */
+auto DiskManager::ReadPageAsync(page_id_t page_id, char *page_data) -> std::future<void> {
+  std::vector<DiskRequest> requests;
+  requests.push_back(DiskRequest{false, page_id, page_data, 1, {}});
+  auto future = requests.back().callback_.get_future();
+  Submit(std::move(requests));
+  return future;
+}
+
+/**
+ * Submit a single page write
+ */
+auto DiskManager::WritePageAsync(page_id_t page_id, const char *page_data) -> std::future<void> {
+  std::vector<DiskRequest> requests;
+  requests.push_back(DiskRequest{true, page_id, const_cast<char *>(page_data), 1, {}});  // NOLINT
+  auto future = requests.back().callback_.get_future();
+  Submit(std::move(requests));
+  return future;
+}
+
 /**
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
@@ -202,10 +380,29 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> off_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? stat_buf.st_size : -1;
+}
+
+/**
+ * Private helper function to open the log file that belongs to db_file
+ */
+void DiskManager::OpenLogFile(const std::string &db_file) {
+  std::string::size_type n = db_file.rfind('.');
+  log_name_ = db_file.substr(0, n) + ".log";
+
+  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
+  // directory or file does not exist
+  if (!log_io_.is_open()) {
+    log_io_.clear();
+    // create a new file
+    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
+    if (!log_io_.is_open()) {
+      throw Exception("can't open dblog file");
+    }
+  }
 }
 
 }  // namespace bustub
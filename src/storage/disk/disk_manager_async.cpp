@@ -0,0 +1,456 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_async.cpp
+//
+// Identification: src/storage/disk/disk_manager_async.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_async.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <chrono>  // NOLINT
+#include <exception>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define BUSTUB_HAS_IO_URING
+#endif
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+DiskManagerAsync::DiskManagerAsync(const std::string &db_file, bool direct_io, size_t queue_depth, bool use_io_uring)
+    : DiskManagerPosix(db_file, direct_io), queue_depth_(queue_depth) {
+  BUSTUB_ENSURE(queue_depth > 0, "queue depth must be positive");
+  if (use_io_uring && SetUpIoUring()) {
+    threads_.emplace_back(&DiskManagerAsync::CompletionLoop, this);
+    return;
+  }
+  for (size_t i = 0; i < queue_depth_; i++) {
+    threads_.emplace_back(&DiskManagerAsync::WorkerLoop, this);
+  }
+}
+
+DiskManagerAsync::~DiskManagerAsync() {
+  StopIo();
+#ifdef BUSTUB_HAS_IO_URING
+  if (ring_fd_ >= 0) {
+    munmap(sqes_, sqes_size_);
+    if (cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd_);
+  }
+#endif
+}
+
+/**
+ * Finish the in-flight I/Os, then close the database file and the log file
+ */
+void DiskManagerAsync::ShutDown() {
+  StopIo();
+  DiskManagerPosix::ShutDown();
+}
+
+/**
+ * Hand a batch of page I/Os to io_uring or to the worker threads
+ */
+void DiskManagerAsync::Submit(std::vector<DiskRequest> requests) {
+  if (ring_fd_ >= 0) {
+    SubmitToRing(&requests);
+    return;
+  }
+  PrepareChecksums(requests);
+  {
+    std::lock_guard<std::mutex> lock(latch_);
+    for (auto &request : requests) {
+      queue_.push_back(std::move(request));
+    }
+  }
+  cv_.notify_all();
+}
+
+auto DiskManagerAsync::SetUpIoUring() -> bool {
+#ifdef BUSTUB_HAS_IO_URING
+  io_uring_params params{};
+  int ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, static_cast<unsigned>(queue_depth_), &params));
+  if (ring_fd < 0) {
+    LOG_INFO("io_uring is not available (errno %d), using a thread pool", errno);
+    return false;
+  }
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  // Since Linux 5.4 both rings live in one mapping.
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ =
+      mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    close(ring_fd);
+    return false;
+  }
+  cq_ring_ = single_mmap ? sq_ring_
+                         : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                                IORING_OFF_CQ_RING);
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (cq_ring_ == MAP_FAILED || sqes == MAP_FAILED) {
+    if (sqes != MAP_FAILED) {
+      munmap(sqes, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_fd);
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  ring_fd_ = ring_fd;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void DiskManagerAsync::SubmitToRing(std::vector<DiskRequest> *requests) {
+#ifdef BUSTUB_HAS_IO_URING
+  // The checksums of a write must be synced before it is queued. The whole batch shares one sync, done here to keep
+  // latch_ free meanwhile. A write that ends up in Execute() prepares the same bytes again, which is a no-op.
+  std::vector<bool> prepared(requests->size(), true);
+  if (checksums_ != nullptr) {
+    bool has_writes = false;
+    for (size_t i = 0; i < requests->size(); i++) {
+      auto &request = (*requests)[i];
+      if (!request.is_write_) {
+        continue;
+      }
+      try {
+        checksums_->Prepare(request.page_id_, request.page_count_, request.data_);
+        has_writes = true;
+      } catch (...) {
+        request.callback_.set_exception(std::current_exception());
+        prepared[i] = false;
+      }
+    }
+    if (has_writes) {
+      try {
+        checksums_->Sync();
+      } catch (...) {
+        for (size_t i = 0; i < requests->size(); i++) {
+          if ((*requests)[i].is_write_ && prepared[i]) {
+            (*requests)[i].callback_.set_exception(std::current_exception());
+            prepared[i] = false;
+          }
+        }
+      }
+    }
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  unsigned pending = 0;
+  for (size_t i = 0; i < requests->size(); i++) {
+    auto &request = (*requests)[i];
+    if (!prepared[i]) {
+      continue;
+    }
+    if (direct_io_ && reinterpret_cast<uintptr_t>(request.data_) % BUSTUB_PAGE_SIZE != 0) {
+      // O_DIRECT needs an aligned buffer, let DiskManagerPosix copy it through one.
+      Execute(&request);
+      continue;
+    }
+    if (in_flight_ == queue_depth_) {
+      // Everything in the submission ring has to reach the kernel before we wait for completions.
+      try {
+        EnterRing(pending);
+      } catch (const Exception &e) {
+        LOG_ERROR("%s", e.what());
+        AbandonRing();
+      }
+      pending = 0;
+      cv_.wait(lock, [this] { return in_flight_ < queue_depth_ || ring_failed_; });
+    }
+    if (ring_failed_) {
+      // Nothing reaps completions any more, so the request is run right here.
+      Execute(&request);
+      continue;
+    }
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = request.is_write_ ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = db_fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(request.data_);
+    sqe->len = request.page_count_ * BUSTUB_PAGE_SIZE;
+    sqe->off = static_cast<uint64_t>(request.page_id_) * BUSTUB_PAGE_SIZE;
+    auto *ring_request = new DiskRequest(std::move(request));
+    in_flight_requests_.insert(ring_request);
+    sqe->user_data = reinterpret_cast<uint64_t>(ring_request);
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    if (sqe->opcode == IORING_OP_WRITE) {
+      num_writes_ += static_cast<int>(sqe->len / BUSTUB_PAGE_SIZE);
+    }
+    in_flight_++;
+    pending++;
+  }
+  try {
+    EnterRing(pending);
+  } catch (const Exception &e) {
+    LOG_ERROR("%s", e.what());
+    AbandonRing();
+  }
+#endif
+}
+
+void DiskManagerAsync::EnterRing(unsigned count) {
+#ifdef BUSTUB_HAS_IO_URING
+  while (count > 0) {
+    auto submitted = syscall(__NR_io_uring_enter, ring_fd_, count, 0, 0, nullptr, 0);
+    if (submitted < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+        continue;
+      }
+      throw Exception(fmt::format("io_uring_enter failed, errno {}", errno));
+    }
+    count -= submitted;
+  }
+#endif
+}
+
+void DiskManagerAsync::CompletionLoop() {
+#ifdef BUSTUB_HAS_IO_URING
+  std::vector<DiskRequest *> completed;
+  bool failed = false;
+  while (true) {
+    if (!failed) {
+      auto ret = syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      // EAGAIN and EBUSY mean the kernel is short of resources or the completion ring is full, reaping helps with both.
+      int error = errno;
+      if (ret < 0 && error != EINTR && error != EAGAIN && error != EBUSY) {
+        LOG_ERROR("io_uring_enter failed, errno %d", error);
+        failed = true;
+        std::lock_guard<std::mutex> lock(latch_);
+        CancelInFlight();
+      }
+    } else {
+      // The kernel still posts the completions of the requests in flight, which still point into their buffers. Wait
+      // for every one of them by polling the completion ring, as io_uring_enter can't be relied on any more.
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    bool stop = false;
+    completed.clear();
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = &cqes_[head & *cq_mask_];
+      if (cqe->user_data == CANCEL_USER_DATA) {
+        continue;
+      }
+      auto *request = reinterpret_cast<DiskRequest *>(cqe->user_data);
+      if (request == nullptr) {
+        // The no-op StopIo() submits once all requests have finished.
+        stop = true;
+        continue;
+      }
+      if (cqe->res < 0) {
+        auto message = fmt::format("I/O error on page {}, errno {}", request->page_id_, -cqe->res);
+        request->callback_.set_exception(std::make_exception_ptr(Exception(message)));
+      } else if (static_cast<size_t>(cqe->res) < request->page_count_ * BUSTUB_PAGE_SIZE) {
+        // A read past the end of the file. Redo it synchronously, which fills the rest of the pages with zeros.
+        Execute(request);
+      } else {
+        Complete(request);
+      }
+      completed.push_back(request);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    bool drained;
+    {
+      std::lock_guard<std::mutex> lock(latch_);
+      for (auto *request : completed) {
+        in_flight_requests_.erase(request);
+        delete request;
+      }
+      in_flight_ -= completed.size();
+      drained = in_flight_requests_.empty();
+      // Submit() may have given up on the ring, then only the requests it had submitted are left to reap.
+      failed = failed || ring_failed_;
+    }
+    if (!completed.empty()) {
+      cv_.notify_all();
+    }
+    if (stop || (failed && drained)) {
+      return;
+    }
+  }
+#endif
+}
+
+void DiskManagerAsync::CancelInFlight() {
+#ifdef BUSTUB_HAS_IO_URING
+  // From now on, Submit() runs requests synchronously, and waiters for a free slot in the ring stop waiting.
+  ring_failed_ = true;
+  cv_.notify_all();
+  unsigned free_entries = *sq_mask_ + 1 - (*sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE));
+  unsigned count = 0;
+  for (auto *request : in_flight_requests_) {
+    if (count == free_entries) {
+      break;
+    }
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe *sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = reinterpret_cast<uint64_t>(request);
+    sqe->user_data = CANCEL_USER_DATA;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    count++;
+  }
+  // Cancelling only makes the requests finish sooner, the ones it misses complete on their own.
+  try {
+    EnterRing(count);
+  } catch (const Exception &e) {
+    LOG_ERROR("can't cancel in-flight I/Os: %s", e.what());
+  }
+#endif
+}
+
+void DiskManagerAsync::AbandonRing() {
+#ifdef BUSTUB_HAS_IO_URING
+  // Without SQPOLL, the kernel only consumes entries inside io_uring_enter, which is only called with latch_ held, so
+  // the entries past the head are still ours.
+  std::vector<DiskRequest *> retracted;
+  unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  for (unsigned tail = head; tail != *sq_tail_; tail++) {
+    auto user_data = sqes_[sq_array_[tail & *sq_mask_]].user_data;
+    if (user_data == 0 || user_data == CANCEL_USER_DATA) {
+      continue;
+    }
+    auto *request = reinterpret_cast<DiskRequest *>(user_data);
+    in_flight_requests_.erase(request);
+    in_flight_--;
+    retracted.push_back(request);
+  }
+  __atomic_store_n(sq_tail_, head, __ATOMIC_RELEASE);
+  CancelInFlight();
+  for (auto *request : retracted) {
+    if (request->is_write_) {
+      num_writes_ -= static_cast<int>(request->page_count_);
+    }
+    Execute(request);
+    delete request;
+  }
+#endif
+}
+
+void DiskManagerAsync::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    DiskRequest request = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    Execute(&request);
+    lock.lock();
+  }
+}
+
+void DiskManagerAsync::Complete(DiskRequest *request) {
+  try {
+    if (checksums_ != nullptr) {
+      for (size_t i = 0; i < request->page_count_ && !request->is_write_; i++) {
+        checksums_->Verify(request->page_id_ + i, request->data_ + i * BUSTUB_PAGE_SIZE);
+      }
+    }
+    request->callback_.set_value();
+  } catch (...) {
+    request->callback_.set_exception(std::current_exception());
+  }
+}
+
+void DiskManagerAsync::Execute(DiskRequest *request) {
+  try {
+    if (request->is_write_) {
+      DiskManagerPosix::WritePages(request->page_id_, request->page_count_, request->data_);
+    } else {
+      for (size_t i = 0; i < request->page_count_; i++) {
+        DiskManagerPosix::ReadPage(request->page_id_ + i, request->data_ + i * BUSTUB_PAGE_SIZE);
+      }
+    }
+    request->callback_.set_value();
+  } catch (...) {
+    request->callback_.set_exception(std::current_exception());
+  }
+}
+
+void DiskManagerAsync::StopIo() {
+  {
+    std::unique_lock<std::mutex> lock(latch_);
+    if (stop_) {
+      return;
+    }
+    stop_ = true;
+#ifdef BUSTUB_HAS_IO_URING
+    if (ring_fd_ >= 0) {
+      cv_.wait(lock, [this] { return in_flight_ == 0; });
+    }
+    // Wake up the completion thread with a no-op now that everything in flight has completed. If the ring has failed,
+    // the completion thread may have returned already, or it may still wait if Submit() was the one to fail. Entries
+    // that a failed ring never consumed may fill the submission ring, then there is nothing to do.
+    if (ring_fd_ >= 0 && *sq_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) <= *sq_mask_) {
+      unsigned tail = *sq_tail_;
+      unsigned index = tail & *sq_mask_;
+      memset(&sqes_[index], 0, sizeof(io_uring_sqe));
+      sqes_[index].opcode = IORING_OP_NOP;
+      sq_array_[index] = index;
+      __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      try {
+        EnterRing(1);
+      } catch (const Exception &e) {
+        LOG_ERROR("can't wake up the completion thread: %s", e.what());
+      }
+    }
+#endif
+  }
+  cv_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_manager_posix.cpp
+//
+// Identification: src/storage/disk/disk_manager_posix.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_manager_posix.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+namespace {
+
+struct AlignedDelete {
+  void operator()(char *data) const { ::operator delete[](data, std::align_val_t{BUSTUB_PAGE_SIZE}); }
+};
+
+/** A page-aligned buffer, used for O_DIRECT I/O on buffers that are not aligned themselves. */
+auto MakeAlignedBuffer(size_t size) -> std::unique_ptr<char[], AlignedDelete> {
+  return std::unique_ptr<char[], AlignedDelete>(new (std::align_val_t{BUSTUB_PAGE_SIZE}) char[size]);
+}
+
+auto IsAligned(const char *data) -> bool { return reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_SIZE == 0; }
+
+}  // namespace
+
+DiskManagerPosix::DiskManagerPosix(const std::string &db_file, bool direct_io) {
+  file_name_ = db_file;
+  if (file_name_.rfind('.') == std::string::npos) {
+    LOG_DEBUG("wrong file format");
+    return;
+  }
+  OpenLogFile(db_file);
+
+  int flags = O_RDWR | O_CREAT;
+#ifdef O_DIRECT
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), flags | O_DIRECT, 0644);  // NOLINT
+    // Some file systems (e.g. tmpfs) reject O_DIRECT, fall back to buffered I/O there.
+    if (db_fd_ < 0 && errno == EINVAL) {
+      LOG_WARN("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
+    }
+    direct_io_ = db_fd_ >= 0;
+  }
+#endif
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), flags, 0644);  // NOLINT
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+}
+
+DiskManagerPosix::~DiskManagerPosix() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+}
+
+/**
+ * Close the database file and the log file
+ */
+void DiskManagerPosix::ShutDown() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  DiskManager::ShutDown();
+}
+
+/**
+ * Write the contents of the specified page into disk file
+ */
+void DiskManagerPosix::WritePage(page_id_t page_id, const char *page_data) { WritePages(page_id, 1, page_data); }
+
+/**
+ * Write the contents of consecutive pages into disk file
+ */
+void DiskManagerPosix::WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) {
+  size_t offset = static_cast<size_t>(start_page_id) * BUSTUB_PAGE_SIZE;
+  size_t size = page_count * BUSTUB_PAGE_SIZE;
+  num_writes_ += static_cast<int>(page_count);
+  if (checksums_ != nullptr) {
+    checksums_->Prepare(start_page_id, page_count, page_data);
+    checksums_->Sync();
+  }
+  if (direct_io_ && !IsAligned(page_data)) {
+    auto buffer = MakeAlignedBuffer(size);
+    memcpy(buffer.get(), page_data, size);
+    WriteAt(offset, buffer.get(), size);
+  } else {
+    WriteAt(offset, page_data, size);
+  }
+}
+
+/**
+ * Read the contents of the specified page into the given memory area. The part of the page past the end of the file
+ * reads as zeros, which fails the checksum check of a page that has been written before.
+ */
+void DiskManagerPosix::ReadPage(page_id_t page_id, char *page_data) {
+  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t read_count;
+  if (direct_io_ && !IsAligned(page_data)) {
+    auto buffer = MakeAlignedBuffer(BUSTUB_PAGE_SIZE);
+    read_count = ReadAt(offset, buffer.get(), BUSTUB_PAGE_SIZE);
+    memcpy(page_data, buffer.get(), read_count);
+  } else {
+    read_count = ReadAt(offset, page_data, BUSTUB_PAGE_SIZE);
+  }
+  if (read_count < static_cast<size_t>(BUSTUB_PAGE_SIZE)) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  if (checksums_ != nullptr) {
+    checksums_->Verify(page_id, page_data);
+  }
+}
+
+void DiskManagerPosix::WriteAt(size_t offset, const char *data, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    auto n = pwrite(db_fd_, data + written, size - written, static_cast<off_t>(offset + written));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw Exception(fmt::format("I/O error while writing, errno {}", errno));
+    }
+    written += n;
+  }
+}
+
+auto DiskManagerPosix::ReadAt(size_t offset, char *data, size_t size) -> size_t {
+  size_t read_count = 0;
+  while (read_count < size) {
+    auto n = pread(db_fd_, data + read_count, size - read_count, static_cast<off_t>(offset + read_count));
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw Exception(fmt::format("I/O error while reading, errno {}", errno));
+    }
+    if (n == 0) {
+      break;  // end of file
+    }
+    read_count += n;
+  }
+  return read_count;
+}
+
+}  // namespace bustub
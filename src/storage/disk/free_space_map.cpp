@@ -0,0 +1,148 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/disk/free_space_map.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_space_map.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iterator>
+
+#include "common/exception.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+static constexpr size_t BITS_PER_WORD = 64;
+/** The file starts with a header that holds the page size. */
+static constexpr size_t HEADER_SIZE = sizeof(uint64_t);
+
+FreeSpaceMap::FreeSpaceMap(const std::string &file_name) {
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);  // NOLINT
+  if (fd_ < 0) {
+    throw Exception("can't open free space map file");
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    close(fd_);
+    throw Exception("can't open free space map file");
+  }
+  // The file starts with the page size, which is fixed when the database is created.
+  uint64_t page_size = BUSTUB_PAGE_SIZE;
+  if (stat_buf.st_size < static_cast<off_t>(HEADER_SIZE)) {
+    if (pwrite(fd_, &page_size, HEADER_SIZE, 0) != static_cast<ssize_t>(HEADER_SIZE)) {
+      close(fd_);
+      throw Exception("can't write free space map file");
+    }
+  } else if (pread(fd_, &page_size, HEADER_SIZE, 0) != static_cast<ssize_t>(HEADER_SIZE) ||
+             page_size != BUSTUB_PAGE_SIZE) {
+    close(fd_);
+    throw Exception(fmt::format("the database was created with a page size of {} bytes, this build uses {} bytes",
+                                page_size, BUSTUB_PAGE_SIZE));
+  }
+  bitmap_.resize((std::max<off_t>(stat_buf.st_size, HEADER_SIZE) - HEADER_SIZE) / sizeof(uint64_t));
+  auto size = static_cast<ssize_t>(bitmap_.size() * sizeof(uint64_t));
+  if (pread(fd_, bitmap_.data(), size, HEADER_SIZE) != size) {
+    close(fd_);
+    throw Exception("can't read free space map file");
+  }
+  // Rebuild the free list: every clear bit below the last set one is a hole.
+  for (size_t i = 0; i < bitmap_.size() * BITS_PER_WORD; i++) {
+    if ((bitmap_[i / BITS_PER_WORD] >> (i % BITS_PER_WORD) & 1) != 0) {
+      for (auto page_id = page_count_; page_id < static_cast<page_id_t>(i); page_id++) {
+        free_pages_.insert(page_id);
+      }
+      page_count_ = static_cast<page_id_t>(i) + 1;
+    }
+  }
+}
+
+FreeSpaceMap::~FreeSpaceMap() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+/**
+ * Take the lowest free page, or grow the file by one page if there is none
+ */
+auto FreeSpaceMap::Allocate() -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  page_id_t page_id;
+  if (free_pages_.empty()) {
+    page_id = page_count_++;
+  } else {
+    page_id = *free_pages_.begin();
+    free_pages_.erase(free_pages_.begin());
+  }
+  SetAllocated(page_id, true);
+  return page_id;
+}
+
+/**
+ * Free a page. Free pages at the end of the file are not kept on the free list, the file just ends before them.
+ */
+auto FreeSpaceMap::Deallocate(page_id_t page_id) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (page_id < 0 || page_id >= page_count_ || free_pages_.count(page_id) != 0) {
+    return false;
+  }
+  SetAllocated(page_id, false);
+  if (page_id + 1 < page_count_) {
+    free_pages_.insert(page_id);
+    return true;
+  }
+  page_count_ = page_id;
+  while (!free_pages_.empty() && *free_pages_.rbegin() == page_count_ - 1) {
+    free_pages_.erase(std::prev(free_pages_.end()));
+    page_count_--;
+  }
+  return true;
+}
+
+auto FreeSpaceMap::IsAllocated(page_id_t page_id) -> bool {
+  std::lock_guard<std::mutex> lock(latch_);
+  return page_id >= 0 && page_id < page_count_ && free_pages_.count(page_id) == 0;
+}
+
+auto FreeSpaceMap::GetPageCount() -> page_id_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return page_count_;
+}
+
+auto FreeSpaceMap::GetFreePageCount() -> size_t {
+  std::lock_guard<std::mutex> lock(latch_);
+  return free_pages_.size();
+}
+
+void FreeSpaceMap::Shrink(const std::function<void(page_id_t)> &shrink) {
+  std::lock_guard<std::mutex> lock(latch_);
+  shrink(page_count_);
+}
+
+void FreeSpaceMap::SetAllocated(page_id_t page_id, bool allocated) {
+  size_t index = page_id / BITS_PER_WORD;
+  if (index >= bitmap_.size()) {
+    bitmap_.resize(index + 1);
+  }
+  uint64_t bit = uint64_t{1} << (page_id % BITS_PER_WORD);
+  bitmap_[index] = allocated ? bitmap_[index] | bit : bitmap_[index] & ~bit;
+  if (fd_ >= 0) {
+    auto offset = static_cast<off_t>(HEADER_SIZE + index * sizeof(uint64_t));
+    if (pwrite(fd_, &bitmap_[index], sizeof(uint64_t), offset) != static_cast<ssize_t>(sizeof(uint64_t))) {
+      throw Exception("I/O error while writing free space map");
+    }
+  }
+}
+
+}  // namespace bustub
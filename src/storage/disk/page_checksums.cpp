@@ -0,0 +1,271 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_checksums.cpp
+//
+// Identification: src/storage/disk/page_checksums.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/page_checksums.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/exception.h"
+#include "common/util/checksum_util.h"
+#include "fmt/format.h"
+
+namespace bustub {
+
+/** The checksum file grows by at least one page worth of slots at a time. */
+static constexpr size_t MIN_SLOT_CNT = BUSTUB_PAGE_SIZE / (2 * sizeof(uint32_t));
+
+/**
+ * Write a range of a file back to the device and wait for it. Unlike fdatasync, this doesn't flush the device's cache.
+ */
+static auto WriteBack(int fd, off_t offset, off_t length, bool wait) -> bool {
+#ifdef __linux__
+  unsigned flags = wait ? SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER
+                        : SYNC_FILE_RANGE_WRITE;
+  return sync_file_range(fd, offset, length, flags) == 0;
+#else
+  return !wait || fdatasync(fd) == 0;
+#endif
+}
+
+PageChecksums::PageChecksums(const std::string &file_name, const std::string &db_file_name) {
+  static_assert(sizeof(Slot) == 2 * sizeof(uint32_t));
+  fd_ = open(file_name.c_str(), O_RDWR | O_CREAT, 0644);  // NOLINT
+  if (fd_ < 0) {
+    throw Exception("can't open checksum file");
+  }
+  db_fd_ = open(db_file_name.c_str(), O_RDONLY);  // NOLINT
+  if (db_fd_ < 0) {
+    close(fd_);
+    throw Exception("can't open db file for checksums");
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) == 0 && stat_buf.st_size >= static_cast<off_t>(sizeof(Slot))) {
+    std::unique_lock lock(latch_);
+    Grow(static_cast<page_id_t>(stat_buf.st_size / sizeof(Slot)) - 1);
+  }
+}
+
+PageChecksums::~PageChecksums() {
+  if (slots_ != nullptr) {
+    munmap(slots_, slot_cnt_ * sizeof(Slot));
+  }
+  close(db_fd_);
+  close(fd_);
+}
+
+/**
+ * Shift the checksums of pages about to be written in their slots, after writing back the versions the slots keep
+ */
+void PageChecksums::Prepare(page_id_t start_page_id, size_t page_count, const char *page_data) {
+  static const uint32_t zero_checksum = Checksum(std::vector<char>(BUSTUB_PAGE_SIZE, 0).data());
+  std::vector<uint32_t> checksums(page_count);
+  for (size_t i = 0; i < page_count; i++) {
+    checksums[i] = Checksum(page_data + i * BUSTUB_PAGE_SIZE);
+  }
+  auto end = static_cast<size_t>(start_page_id) + page_count;
+  std::vector<page_id_t> unsettled_page_ids;
+  {
+    std::shared_lock lock(latch_);
+    if (end > slot_cnt_) {
+      lock.unlock();
+      {
+        std::unique_lock grow_lock(latch_);
+        if (end > slot_cnt_) {
+          Grow(static_cast<page_id_t>(end - 1));
+        }
+      }
+      lock.lock();
+    }
+    for (size_t i = 0; i < page_count; i++) {
+      auto page_id = static_cast<page_id_t>(start_page_id + i);
+      uint32_t current = __atomic_load_n(&slots_[page_id].current_, __ATOMIC_RELAXED);
+      if (current != 0 && current != checksums[i] && __atomic_load_n(&settled_[page_id], __ATOMIC_RELAXED) == 0) {
+        unsettled_page_ids.push_back(page_id);
+      }
+    }
+  }
+  // The current versions are about to become the previous ones, and the ones before them are forgotten. Usually the OS
+  // has written them back long ago, then this costs no I/O.
+  if (!unsettled_page_ids.empty()) {
+    SettlePages(unsettled_page_ids);
+  }
+
+  bool changed = false;
+  std::shared_lock lock(latch_);
+  for (size_t i = 0; i < page_count; i++) {
+    auto page_id = static_cast<page_id_t>(start_page_id + i);
+    Slot &slot = slots_[page_id];
+    uint32_t current = __atomic_load_n(&slot.current_, __ATOMIC_RELAXED);
+    if (current == checksums[i]) {
+      // A retried write, the version before is still the one that may be on disk.
+      continue;
+    }
+    __atomic_store_n(&slot.previous_, current == 0 ? zero_checksum : current, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.current_, checksums[i], __ATOMIC_RELAXED);
+    __atomic_store_n(&settled_[page_id], 0, __ATOMIC_RELAXED);
+    changed = true;
+  }
+  if (changed) {
+    prepare_cnt_.fetch_add(1, std::memory_order_release);
+  }
+}
+
+/**
+ * Write the checksum file back, unless a write-back that started after the last Prepare() call has done so
+ */
+void PageChecksums::Sync() {
+  uint64_t target = prepare_cnt_.load(std::memory_order_acquire);
+  std::unique_lock lock(sync_latch_);
+  while (synced_cnt_ < target) {
+    if (syncing_) {
+      sync_cv_.wait(lock);
+      continue;
+    }
+    // Lead a write-back for everyone who waits, including the Prepare() calls that came in after ours.
+    syncing_ = true;
+    uint64_t prepared = prepare_cnt_.load(std::memory_order_acquire);
+    lock.unlock();
+    bool written = WriteBack(fd_, 0, 0, true);
+    lock.lock();
+    syncing_ = false;
+    sync_cv_.notify_all();
+    if (!written) {
+      throw Exception("can't sync checksum file");
+    }
+    synced_cnt_ = std::max(synced_cnt_, prepared);
+  }
+}
+
+void PageChecksums::SettlePages(const std::vector<page_id_t> &page_ids) {
+  // Start the write-back of every run of adjacent pages before waiting for any of them.
+  std::vector<std::pair<off_t, off_t>> runs;
+  for (size_t begin = 0, end; begin < page_ids.size(); begin = end) {
+    end = begin + 1;
+    while (end < page_ids.size() && page_ids[end] == page_ids[end - 1] + 1) {
+      end++;
+    }
+    runs.emplace_back(static_cast<off_t>(page_ids[begin]) * BUSTUB_PAGE_SIZE,
+                      static_cast<off_t>(end - begin) * BUSTUB_PAGE_SIZE);
+  }
+  for (auto [offset, length] : runs) {
+    WriteBack(db_fd_, offset, length, false);
+  }
+  for (auto [offset, length] : runs) {
+    if (!WriteBack(db_fd_, offset, length, true)) {
+      throw Exception("can't write back db file");
+    }
+  }
+  std::shared_lock lock(latch_);
+  for (auto page_id : page_ids) {
+    __atomic_store_n(&settled_[page_id], 1, __ATOMIC_RELAXED);
+  }
+}
+
+/**
+ * Compare the checksum of a page with the ones in its slot, if there are any
+ */
+void PageChecksums::Verify(page_id_t page_id, const char *page_data) {
+  uint32_t current;
+  uint32_t previous;
+  {
+    std::shared_lock lock(latch_);
+    if (static_cast<size_t>(page_id) >= slot_cnt_) {
+      return;
+    }
+    current = __atomic_load_n(&slots_[page_id].current_, __ATOMIC_RELAXED);
+    previous = __atomic_load_n(&slots_[page_id].previous_, __ATOMIC_RELAXED);
+  }
+  if (current == 0) {
+    return;
+  }
+  uint32_t checksum = Checksum(page_data);
+  if (checksum != current && checksum != previous) {
+    throw Exception(ExceptionType::CORRUPTION,
+                    fmt::format("checksum mismatch on page {}: expected {:#010x}, got {:#010x}", page_id, current,
+                                checksum));
+  }
+}
+
+/**
+ * Keep only the checksum a page matches, or stamp one if it has none
+ */
+auto PageChecksums::Recover(page_id_t page_id, const char *page_data) -> bool {
+  uint32_t checksum = Checksum(page_data);
+  std::shared_lock lock(latch_);
+  if (static_cast<size_t>(page_id) >= slot_cnt_) {
+    lock.unlock();
+    {
+      std::unique_lock grow_lock(latch_);
+      if (static_cast<size_t>(page_id) >= slot_cnt_) {
+        Grow(page_id);
+      }
+    }
+    lock.lock();
+  }
+  Slot &slot = slots_[page_id];
+  uint32_t current = __atomic_load_n(&slot.current_, __ATOMIC_RELAXED);
+  uint32_t previous = __atomic_load_n(&slot.previous_, __ATOMIC_RELAXED);
+  if (current != 0 && checksum != current && checksum != previous) {
+    return false;
+  }
+  __atomic_store_n(&slot.current_, checksum, __ATOMIC_RELAXED);
+  __atomic_store_n(&slot.previous_, 0, __ATOMIC_RELAXED);
+  __atomic_store_n(&settled_[page_id], 0, __ATOMIC_RELAXED);
+  prepare_cnt_.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+void PageChecksums::Clear(page_id_t page_id) {
+  std::shared_lock lock(latch_);
+  if (static_cast<size_t>(page_id) < slot_cnt_) {
+    __atomic_store_n(&slots_[page_id].current_, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&slots_[page_id].previous_, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&settled_[page_id], 0, __ATOMIC_RELAXED);
+  }
+}
+
+auto PageChecksums::GetSlotCount() -> size_t {
+  std::shared_lock lock(latch_);
+  return slot_cnt_;
+}
+
+void PageChecksums::Grow(page_id_t page_id) {
+  size_t slot_cnt = std::max({static_cast<size_t>(page_id) + 1, 2 * slot_cnt_, MIN_SLOT_CNT});
+  slot_cnt = (slot_cnt + MIN_SLOT_CNT - 1) / MIN_SLOT_CNT * MIN_SLOT_CNT;
+  if (ftruncate(fd_, static_cast<off_t>(slot_cnt * sizeof(Slot))) != 0) {
+    throw Exception("can't grow checksum file");
+  }
+  void *slots = mmap(nullptr, slot_cnt * sizeof(Slot), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (slots == MAP_FAILED) {
+    throw Exception("can't map checksum file");
+  }
+  if (slots_ != nullptr) {
+    munmap(slots_, slot_cnt_ * sizeof(Slot));
+  }
+  slots_ = static_cast<Slot *>(slots);
+  slot_cnt_ = slot_cnt;
+  settled_.resize(slot_cnt, 0);
+}
+
+auto PageChecksums::Checksum(const char *page_data) -> uint32_t {
+  uint32_t checksum = ChecksumUtil::Crc32c(page_data, BUSTUB_PAGE_SIZE);
+  return checksum == 0 ? 1 : checksum;
+}
+
+}  // namespace bustub
@@ -5,6 +5,9 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
 
 #include "common/config.h"
 #include "common/exception.h"
@@ -48,6 +51,19 @@ auto BPLUSTREE_TYPE::IsEmpty() const -> bool { return GetRootPageId() == INVALID
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *txn) -> bool {
+  // Try without latches first, and fall back to latch crabbing if writers keep getting in the way. Keys are compared
+  // before the node is validated, which only integer keys survive: a torn VARCHAR length would send a Value-based
+  // comparison out of the page.
+  for (int attempt = 0; comparator_.IsIntegerKey() && attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+    ValueType v;
+    auto found = GetValueOptimistic(key, &v);
+    if (found.has_value()) {
+      if (*found) {
+        result->push_back(v);
+      }
+      return *found;
+    }
+  }
   // Declaration of context instance.
   {
     // 判断是否为空树
@@ -72,6 +88,62 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   return true;
 }
 
+/*
+ * Optimistic lock coupling: read each node through an OptimisticPageGuard, and validate it after every read that the
+ * traversal acts upon. A child is only fetched once the parent has been validated after reading the child's page id,
+ * and the parent is validated again once the child's version has been taken, so that a split or merge of the child in
+ * between is noticed as well.
+ * @return whether the key exists, or nullopt if a writer got in the way and the lookup has to be restarted
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValueOptimistic(const KeyType &key, ValueType *value) -> std::optional<bool> {
+  OptimisticPageGuard parent_guard = bpm_->FetchPageOptimistic(header_page_id_);
+  if (!parent_guard.Validate()) {
+    return std::nullopt;
+  }
+  page_id_t page_id = parent_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (!parent_guard.Validate()) {
+    return std::nullopt;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  while (true) {
+    OptimisticPageGuard guard = bpm_->FetchPageOptimistic(page_id);
+    if (!guard.Validate() || !parent_guard.Validate()) {
+      return std::nullopt;
+    }
+    auto node = guard.As<BPlusTreePage>();
+    // A node that is halfway through a change may claim any size, which must not send the search out of the page.
+    if (!IsReadable(node)) {
+      return std::nullopt;
+    }
+    if (node->IsLeafPage()) {
+      bool found = reinterpret_cast<const LeafPage *>(node)->ValueAtKey(key, *value, comparator_);
+      if (!guard.Validate()) {
+        return std::nullopt;
+      }
+      return found;
+    }
+    auto internal_node = reinterpret_cast<const InternalPage *>(node);
+    page_id = internal_node->ValueAt(internal_node->GetKeyIndex(key, comparator_));
+    if (!guard.Validate()) {
+      return std::nullopt;
+    }
+    parent_guard = guard;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::IsReadable(const BPlusTreePage *node) -> bool {
+  constexpr int leaf_capacity = (BUSTUB_PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<KeyType, ValueType>);
+  constexpr int internal_capacity =
+      (BUSTUB_PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<KeyType, page_id_t>);
+  int size = node->GetSize();
+  return size >= 0 && size <= (node->IsLeafPage() ? leaf_capacity : internal_capacity) &&
+         node->GetMaxSize() <= (node->IsLeafPage() ? leaf_capacity : internal_capacity);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, ReadPageGuard &leaf_page_guard) {
   ReadPageGuard head_guard = bpm_->FetchPageRead(header_page_id_);
@@ -89,6 +161,87 @@ void BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, ReadPageGuard &leaf_page_g
   }
   leaf_page_guard = std::move(node_guard);
 }
+
+/*
+ * Look up the keys one after another with a batch cursor, so that a key in the same leaf as the one before it is found
+ * without descending the tree, and one in a neighboring leaf only takes a step down from the latched parent.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetValues(const std::vector<KeyType> &keys, std::vector<std::optional<ValueType>> *result,
+                               Transaction *txn) -> size_t {
+  result->assign(keys.size(), std::nullopt);
+  BatchCursor<ReadPageGuard> cursor;
+  size_t found = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (!SeekLeaf(keys[i], &cursor)) {
+      return 0;
+    }
+    ValueType v;
+    if (cursor.leaf_->template As<LeafPage>()->ValueAtKey(keys[i], v, comparator_)) {
+      (*result)[i] = v;
+      found++;
+    }
+  }
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Guard>
+auto BPLUSTREE_TYPE::SeekLeaf(const KeyType &key, BatchCursor<Guard> *cursor) -> bool {
+  auto fetch = [this](page_id_t page_id) -> Guard {
+    if constexpr (std::is_same_v<Guard, WritePageGuard>) {
+      return bpm_->FetchPageWrite(page_id);
+    } else {
+      return bpm_->FetchPageRead(page_id);
+    }
+  };
+  if (cursor->leaf_.has_value() && InRange(key, cursor->leaf_low_, cursor->leaf_high_)) {
+    return true;
+  }
+  cursor->leaf_ = std::nullopt;
+
+  std::optional<Guard> node;
+  std::optional<KeyType> low;
+  std::optional<KeyType> high;
+  if (cursor->parent_.has_value() && InRange(key, cursor->parent_low_, cursor->parent_high_)) {
+    node = std::move(cursor->parent_);
+    low = cursor->parent_low_;
+    high = cursor->parent_high_;
+  } else {
+    cursor->parent_ = std::nullopt;
+    ReadPageGuard header_guard = bpm_->FetchPageRead(header_page_id_);
+    page_id_t root_page_id = header_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return false;
+    }
+    node = fetch(root_page_id);
+  }
+  cursor->parent_ = std::nullopt;
+  while (!node->template As<BPlusTreePage>()->IsLeafPage()) {
+    auto internal_node = node->template As<InternalPage>();
+    int index = internal_node->GetKeyIndex(key, comparator_);
+    std::optional<KeyType> child_low = index > 0 ? std::optional<KeyType>(internal_node->KeyAt(index)) : low;
+    std::optional<KeyType> child_high =
+        index + 1 < internal_node->GetSize() ? std::optional<KeyType>(internal_node->KeyAt(index + 1)) : high;
+    Guard child_guard = fetch(internal_node->ValueAt(index));
+    cursor->parent_ = std::move(node);
+    cursor->parent_low_ = low;
+    cursor->parent_high_ = high;
+    node = std::move(child_guard);
+    low = child_low;
+    high = child_high;
+  }
+  cursor->leaf_ = std::move(node);
+  cursor->leaf_low_ = low;
+  cursor->leaf_high_ = high;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InRange(const KeyType &key, const std::optional<KeyType> &low, const std::optional<KeyType> &high)
+    -> bool {
+  return (!low.has_value() || comparator_(key, *low) >= 0) && (!high.has_value() || comparator_(key, *high) < 0);
+}
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -101,6 +254,13 @@ void BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, ReadPageGuard &leaf_page_g
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *txn) -> bool {
+  // Most inserts leave the leaf with room to spare, and need neither the header nor any parent write latched.
+  if (auto leaf_guard = FindLeafPageWriteOptimistic(key); leaf_guard.has_value()) {
+    auto leaf_page = leaf_guard->template AsMut<LeafPage>();
+    if (leaf_page->GetSize() < leaf_page->GetMaxSize() - 1) {
+      return leaf_page->Insert(key, value, comparator_);
+    }
+  }
   // Declaration of context instance.
   Context ctx;
   WritePageGuard header_page_guard = bpm_->FetchPageWrite(header_page_id_);
@@ -247,6 +407,29 @@ auto BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) ->
   return true;
 }
 
+/*
+ * Insert the pairs one after another with a batch cursor, which keeps the leaf and its parent write latched while the
+ * keys stay in their range. A pair that would make the leaf split goes through Insert() instead, after the cursor has
+ * let go of its latches.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::InsertBatch(const std::vector<std::pair<KeyType, ValueType>> &pairs, Transaction *txn) -> size_t {
+  BatchCursor<WritePageGuard> cursor;
+  size_t inserted = 0;
+  for (const auto &[key, value] : pairs) {
+    if (SeekLeaf(key, &cursor)) {
+      auto leaf_page = cursor.leaf_->template AsMut<LeafPage>();
+      if (leaf_page->GetSize() < leaf_page->GetMaxSize() - 1) {
+        inserted += leaf_page->Insert(key, value, comparator_) ? 1 : 0;
+        continue;
+      }
+    }
+    cursor = BatchCursor<WritePageGuard>();
+    inserted += Insert(key, value, txn) ? 1 : 0;
+  }
+  return inserted;
+}
+
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
@@ -259,6 +442,18 @@ auto BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) ->
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *txn) {
+  {
+    // A leaf that stays at or above its minimum size after the removal is the only page that changes.
+    auto leaf_guard = FindLeafPageWriteOptimistic(key);
+    if (!leaf_guard.has_value()) {
+      return;
+    }
+    auto leaf_page = leaf_guard->template AsMut<LeafPage>();
+    if (leaf_page->GetSize() > leaf_page->GetMinSize()) {
+      leaf_page->RemoveRecord(key, comparator_);
+      return;
+    }
+  }
   // Declaration of context instance.
   Context ctx;
   {
@@ -318,17 +513,13 @@ auto BPLUSTREE_TYPE::MergeOrRedistribute(WritePageGuard *page_guard, Context *ct
         sibling_page->MoveAll(page);
         page_id_t page_id = sibling_page_id;
         sibling_page_guard.Drop();
-        if (!bpm_->DeletePage(page_id)) {
-          throw Exception("删除页错误1");
-        }
+        DeletePage(page_id);
         page_guard->Drop();
       } else {
         remove_index = parent_page->ValueIndex(page_id);
         page->MoveAll(sibling_page);
         page_guard->Drop();
-        if (!bpm_->DeletePage(page_id)) {
-          throw Exception("删除页错误1");
-        }
+        DeletePage(page_id);
         sibling_page_guard.Drop();
       }
       parent_page->Remove(remove_index);
@@ -357,17 +548,13 @@ auto BPLUSTREE_TYPE::MergeOrRedistribute(WritePageGuard *page_guard, Context *ct
         sibling_page->MoveAll(page, remove_index, parent_page);
         page_id_t page_id = sibling_page_id;
         sibling_page_guard.Drop();
-        if (!bpm_->DeletePage(page_id)) {
-          throw Exception("删除页错误2");
-        }
+        DeletePage(page_id);
         page_guard->Drop();
       } else {
         remove_index = parent_page->ValueIndex(page_id);
         page->MoveAll(sibling_page, remove_index, parent_page);
         page_guard->Drop();
-        if (!bpm_->DeletePage(page_id)) {
-          throw Exception("删除页错误2");
-        }
+        DeletePage(page_id);
         sibling_page_guard.Drop();
       }
       parent_page->Remove(remove_index);
@@ -409,6 +596,14 @@ auto BPLUSTREE_TYPE::FindSibling(WritePageGuard *page_guard, WritePageGuard &sib
   return index == 0;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePage(page_id_t page_id) {
+  // Nobody can reach the page anymore, but a thread that let go of its latch may not have unpinned it yet.
+  while (!bpm_->DeletePage(page_id)) {
+    std::this_thread::yield();
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::RootAdjust(WritePageGuard *root_page_guard, Context *ctx) -> bool {
   auto root_page = root_page_guard->AsMut<BPlusTreePage>();
@@ -419,9 +614,7 @@ auto BPLUSTREE_TYPE::RootAdjust(WritePageGuard *root_page_guard, Context *ctx) -
       auto header_page = ctx->header_page_->AsMut<BPlusTreeHeaderPage>();
       header_page->root_page_id_ = INVALID_PAGE_ID;
       root_page_guard->Drop();
-      if (!bpm_->DeletePage(root_page_id)) {
-        throw Exception("删除页错误3");
-      }
+      DeletePage(root_page_id);
       ctx->header_page_->Drop();
       ctx->header_page_ = std::nullopt;
       return true;
@@ -434,9 +627,7 @@ auto BPLUSTREE_TYPE::RootAdjust(WritePageGuard *root_page_guard, Context *ctx) -
       auto header_page = ctx->header_page_->AsMut<BPlusTreeHeaderPage>();
       header_page->root_page_id_ = new_root_id;
       root_page_guard->Drop();
-      if (!bpm_->DeletePage(root_page_id)) {
-        throw Exception("删除页错误4");
-      }
+      DeletePage(root_page_id);
       ctx->header_page_->Drop();
       ctx->header_page_ = std::nullopt;
     }
@@ -482,73 +673,51 @@ auto BPLUSTREE_TYPE::FindLeafPageWriteInsertOrDelete(const KeyType &key, Context
   return leaf_page;
 }
 
+/*
+ * Read latches are enough above the leaf: a leaf only splits, merges or takes entries from a sibling while a writer has
+ * its parent, or the header for the root, write latched. So once the parent is read latched, the leaf can be let go
+ * and write latched again, and it is still the leaf of key.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPageWriteOptimistic(const KeyType &key) -> std::optional<WritePageGuard> {
+  ReadPageGuard parent_guard = bpm_->FetchPageRead(header_page_id_);
+  page_id_t page_id = parent_guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return std::nullopt;
+  }
+  while (true) {
+    ReadPageGuard guard = bpm_->FetchPageRead(page_id);
+    auto node = guard.As<BPlusTreePage>();
+    if (node->IsLeafPage()) {
+      guard.Drop();
+      return bpm_->FetchPageWrite(page_id);
+    }
+    auto internal_node = reinterpret_cast<const InternalPage *>(node);
+    page_id = internal_node->ValueAt(internal_node->GetKeyIndex(key, comparator_));
+    parent_guard = std::move(guard);
+  }
+}
+
 /*****************************************************************************
  * INDEX ITERATOR
  *****************************************************************************/
 /*
- * Input parameter is void, find the leftmost leaf page first, then construct
- * index iterator
+ * Input parameter is void, construct an index iterator from the first pair
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
-  if (IsEmpty()) {
-    INDEXITERATOR_TYPE tmp = INDEXITERATOR_TYPE();
-    tmp.is_empty_ = true;
-    return tmp;
-  }
-  BasicPageGuard tmp;
-  BasicPageGuard head_page_guard = bpm_->FetchPageBasic(header_page_id_);
-  auto head_page = head_page_guard.As<BPlusTreeHeaderPage>();
-  BasicPageGuard root_guard = bpm_->FetchPageBasic(head_page->root_page_id_);
-  auto page = root_guard.As<BPlusTreePage>();
-  tmp = std::move(root_guard);
-  while (!page->IsLeafPage()) {
-    auto internal_page = reinterpret_cast<InternalPage *>(page);
-    auto first_page_id = internal_page->ValueAt(0);
-    BasicPageGuard page_guard = bpm_->FetchPageBasic(first_page_id);
-    tmp.Drop();
-    tmp = std::move(page_guard);
-    page = tmp.As<BPlusTreePage>();
-  }
-  auto leaf_page = tmp.As<LeafPage>();
-  page_id_t leaf_page_id = tmp.PageId();
-  tmp.Drop();
-  return INDEXITERATOR_TYPE(leaf_page_id, leaf_page, 0, bpm_);
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, comparator_, nullptr, false);
 }
 
 /*
- * Input parameter is low key, find the leaf page that contains the input key
- * first, then construct index iterator
+ * Input parameter is low key, construct an index iterator from the first
+ * pair not less than it
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
-  if (IsEmpty()) {
-    INDEXITERATOR_TYPE tmp = INDEXITERATOR_TYPE();
-    tmp.is_empty_ = true;
-    return tmp;
-  }
-  BasicPageGuard tmp;
-  BasicPageGuard head_page_guard = bpm_->FetchPageBasic(header_page_id_);
-  auto head_page = head_page_guard.As<BPlusTreeHeaderPage>();
-  BasicPageGuard root_guard = bpm_->FetchPageBasic(head_page->root_page_id_);
-  auto page = root_guard.As<BPlusTreePage>();
-  tmp = std::move(root_guard);
-  while (!page->IsLeafPage()) {
-    auto internal_page = reinterpret_cast<InternalPage *>(page);
-    int index = internal_page->GetKeyIndex(key, comparator_);
-    auto page_id = internal_page->ValueAt(index);
-    BasicPageGuard page_guard = bpm_->FetchPageBasic(page_id);
-    tmp.Drop();
-    tmp = std::move(page_guard);
-    page = tmp.As<BPlusTreePage>();
-  }
-  auto leaf_page = tmp.As<LeafPage>();
-  auto key_index = leaf_page->KetIndex(key, comparator_);
-  page_id_t leaf_page_id = tmp.PageId();
-  tmp.Drop();
-  return INDEXITERATOR_TYPE(leaf_page_id, leaf_page, key_index, bpm_);
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, comparator_, &key, false);
 }
 
 /*
@@ -557,30 +726,26 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
-  if (IsEmpty()) {
-    INDEXITERATOR_TYPE tmp = INDEXITERATOR_TYPE();
-    tmp.is_empty_ = true;
-    return tmp;
-  }
-  BasicPageGuard tmp;
-  BasicPageGuard head_page_guard = bpm_->FetchPageBasic(header_page_id_);
-  auto head_page = head_page_guard.As<BPlusTreeHeaderPage>();
-  BasicPageGuard root_guard = bpm_->FetchPageBasic(head_page->root_page_id_);
-  auto page = root_guard.As<BPlusTreePage>();
-  tmp = std::move(root_guard);
-  while (!page->IsLeafPage()) {
-    auto internal_page = reinterpret_cast<InternalPage *>(page);
-    auto first_page_id = internal_page->ValueAt(internal_page->GetSize() - 1);
-    BasicPageGuard page_guard = bpm_->FetchPageBasic(first_page_id);
-    tmp.Drop();
-    tmp = std::move(page_guard);
-    page = tmp.As<BPlusTreePage>();
-  }
-  auto leaf_page = tmp.As<LeafPage>();
-  page_id_t leaf_page_id = tmp.PageId();
-  tmp.Drop();
-  return INDEXITERATOR_TYPE(leaf_page_id, leaf_page, leaf_page->GetSize(), bpm_);
+auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { return INDEXITERATOR_TYPE(); }
+
+/*
+ * Input parameter is void, construct a reverse index iterator from the last
+ * pair
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin() -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, comparator_, nullptr, true);
+}
+
+/*
+ * Input parameter is high key, construct a reverse index iterator from the
+ * last pair not greater than it
+ * @return : reverse index iterator
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::RBegin(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return INDEXITERATOR_TYPE(bpm_, header_page_id_, comparator_, &key, true);
 }
 
 /**
@@ -0,0 +1,279 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_builder.cpp
+//
+// Identification: src/storage/index/b_plus_tree_builder.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cmath>
+
+#include "common/exception.h"
+#include "common/rid.h"
+#include "storage/index/b_plus_tree_builder.h"
+#include "storage/page/b_plus_tree_header_page.h"
+
+namespace bustub {
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_BUILDER_TYPE::BPlusTreeBuilder(BPlusTree<KeyType, ValueType, KeyComparator> *tree, double fill_factor,
+                                         size_t run_size)
+    : bpm_(tree->bpm_), tree_(tree), comparator_(tree->comparator_), run_size_(std::max<size_t>(run_size, 1)) {
+  // A leaf splits once it holds max size entries, an internal page once it has more than max size children. Filling
+  // pages below their minimum size would only make them merge later.
+  int leaf_capacity = tree_->leaf_max_size_ - 1;
+  int leaf_min = tree_->leaf_max_size_ / 2;
+  leaf_fill_ = std::clamp(static_cast<int>(std::lround(fill_factor * leaf_capacity)), std::max(leaf_min, 1),
+                          std::max(leaf_capacity, 1));
+  int internal_min = (tree_->internal_max_size_ + 1) / 2;
+  internal_fill_ = std::clamp(static_cast<int>(std::lround(fill_factor * tree_->internal_max_size_)),
+                              std::max(internal_min, 2), std::max(tree_->internal_max_size_, 2));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+BPLUSTREE_BUILDER_TYPE::~BPlusTreeBuilder() {
+  run_guard_.Drop();
+  for (auto &run : runs_) {
+    for (auto page_id : run.pages_) {
+      bpm_->DeletePage(page_id);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::Add(const KeyType &key, const ValueType &value) {
+  // NULL compares equal to every key, a sort given such keys has no strict weak ordering to follow.
+  if (comparator_.HasNull(key)) {
+    return;
+  }
+  buffer_.emplace_back(key, value);
+  if (buffer_.size() == run_size_) {
+    SpillRun();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::Finish() -> size_t {
+  {
+    ReadPageGuard header_guard = bpm_->FetchPageRead(tree_->header_page_id_);
+    if (header_guard.As<BPlusTreeHeaderPage>()->root_page_id_ != INVALID_PAGE_ID) {
+      throw Exception("a B+ tree can only be bulk loaded when it is empty");
+    }
+  }
+
+  auto append = [this](const MappingType &entry) { AppendToLeaves(entry); };
+  if (runs_.empty()) {
+    std::stable_sort(buffer_.begin(), buffer_.end(),
+                     [this](const auto &lhs, const auto &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+    std::for_each(buffer_.begin(), buffer_.end(), append);
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+  } else {
+    if (!buffer_.empty()) {
+      SpillRun();
+    }
+    // Each pass merges groups of neighboring runs, so that runs stay in the order their entries were added.
+    while (runs_.size() > static_cast<size_t>(BULK_LOAD_MERGE_WAYS)) {
+      size_t input_runs = runs_.size();
+      for (size_t begin = 0; begin < input_runs; begin += BULK_LOAD_MERGE_WAYS) {
+        runs_.emplace_back();
+        MergeRuns(begin, std::min(begin + BULK_LOAD_MERGE_WAYS, input_runs),
+                  [this](const MappingType &entry) { AppendToRun(entry); });
+        run_guard_.Drop();
+      }
+      runs_.erase(runs_.begin(), runs_.begin() + input_runs);
+    }
+    MergeRuns(0, runs_.size(), append);
+    runs_.clear();
+  }
+  if (children_.empty()) {
+    return 0;
+  }
+
+  FinishLeaves();
+  while (children_.size() > 1) {
+    BuildInternalLevel();
+  }
+  WritePageGuard header_guard = bpm_->FetchPageWrite(tree_->header_page_id_);
+  header_guard.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = children_[0].second;
+  children_.clear();
+  return size_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::SpillRun() {
+  std::stable_sort(buffer_.begin(), buffer_.end(),
+                   [this](const auto &lhs, const auto &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+  runs_.emplace_back();
+  for (const auto &entry : buffer_) {
+    AppendToRun(entry);
+  }
+  run_guard_.Drop();
+  buffer_.clear();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+template <typename Emit>
+void BPLUSTREE_BUILDER_TYPE::MergeRuns(size_t begin, size_t end, Emit emit) {
+  std::vector<RunReader> readers;
+  readers.reserve(end - begin);
+  for (size_t i = begin; i < end; i++) {
+    readers.emplace_back(bpm_, &runs_[i]);
+  }
+  // There are few runs, so finding the smallest head by looking at each beats keeping a heap.
+  while (true) {
+    RunReader *smallest = nullptr;
+    for (auto &reader : readers) {
+      if (!reader.Done() && (smallest == nullptr || comparator_(reader.Peek().first, smallest->Peek().first) < 0)) {
+        smallest = &reader;
+      }
+    }
+    if (smallest == nullptr) {
+      break;
+    }
+    emit(smallest->Peek());
+    smallest->Pop();
+  }
+  for (size_t i = begin; i < end; i++) {
+    runs_[i].pages_.clear();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::AppendToRun(const MappingType &entry) {
+  auto &run = runs_.back();
+  size_t slot = run.size_ % RUN_PAGE_SLOTS;
+  if (slot == 0) {
+    run_guard_ = NewPage();
+    run.pages_.push_back(run_guard_.PageId());
+  }
+  reinterpret_cast<MappingType *>(run_guard_.GetDataMut())[slot] = entry;
+  run.size_++;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::RunReader::Peek() -> const MappingType & {
+  if (entries_ == nullptr) {
+    guard_ = bpm_->FetchPageBasic(run_->pages_[pos_ / RUN_PAGE_SLOTS], AccessType::Scan);
+    entries_ = reinterpret_cast<const MappingType *>(guard_.GetData());
+  }
+  return entries_[pos_ % RUN_PAGE_SLOTS];
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::RunReader::Pop() {
+  pos_++;
+  if (pos_ % RUN_PAGE_SLOTS == 0 || Done()) {
+    page_id_t page_id = run_->pages_[(pos_ - 1) / RUN_PAGE_SLOTS];
+    guard_.Drop();
+    entries_ = nullptr;
+    bpm_->DeletePage(page_id);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::AppendToLeaves(const MappingType &entry) {
+  if (!children_.empty()) {
+    auto *leaf = leaf_.AsMut<LeafPage>();
+    if (comparator_(leaf->KeyAt(leaf->GetSize() - 1), entry.first) == 0) {
+      return;
+    }
+    if (leaf->GetSize() == leaf_fill_) {
+      BasicPageGuard next_leaf = NewPage();
+      next_leaf.AsMut<LeafPage>()->Init(tree_->leaf_max_size_);
+      leaf->SetNextPageId(next_leaf.PageId());
+      prev_leaf_ = std::move(leaf_);
+      leaf_ = std::move(next_leaf);
+      children_.emplace_back(entry.first, leaf_.PageId());
+    }
+  } else {
+    leaf_ = NewPage();
+    leaf_.AsMut<LeafPage>()->Init(tree_->leaf_max_size_);
+    children_.emplace_back(entry.first, leaf_.PageId());
+  }
+  leaf_.AsMut<LeafPage>()->Append(entry.first, entry.second);
+  size_++;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::FinishLeaves() {
+  auto *leaf = leaf_.AsMut<LeafPage>();
+  if (children_.size() > 1 && leaf->GetSize() < leaf->GetMinSize()) {
+    auto *prev_leaf = prev_leaf_.AsMut<LeafPage>();
+    int last_size = LastPageSize(prev_leaf->GetSize() + leaf->GetSize(), tree_->leaf_max_size_ - 1);
+    if (last_size == 0) {
+      leaf->MoveAll(prev_leaf);
+      page_id_t page_id = leaf_.PageId();
+      leaf_.Drop();
+      bpm_->DeletePage(page_id);
+      children_.pop_back();
+    } else {
+      while (leaf->GetSize() < last_size) {
+        prev_leaf->MoveEndTo(leaf);
+      }
+      children_.back().first = leaf->KeyAt(0);
+    }
+  }
+  leaf_.Drop();
+  prev_leaf_.Drop();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_BUILDER_TYPE::BuildInternalLevel() {
+  // Plan the page sizes first, so that a short last page can be evened out before anything is written.
+  std::vector<int> sizes;
+  for (size_t left = children_.size(); left > 0; left -= sizes.back()) {
+    sizes.push_back(static_cast<int>(std::min<size_t>(left, internal_fill_)));
+  }
+  if (sizes.size() > 1 && sizes.back() < (tree_->internal_max_size_ + 1) / 2) {
+    int total = sizes[sizes.size() - 2] + sizes.back();
+    int last_size = LastPageSize(total, tree_->internal_max_size_);
+    if (last_size == 0) {
+      sizes.pop_back();
+      sizes.back() = total;
+    } else {
+      sizes[sizes.size() - 2] = total - last_size;
+      sizes.back() = last_size;
+    }
+  }
+
+  std::vector<std::pair<KeyType, page_id_t>> parents;
+  auto child = children_.begin();
+  for (int size : sizes) {
+    BasicPageGuard guard = NewPage();
+    auto *page = guard.AsMut<InternalPage>();
+    page->Init(tree_->internal_max_size_);
+    parents.emplace_back(child->first, guard.PageId());
+    for (int i = 0; i < size; i++, child++) {
+      page->Append(child->first, child->second);
+    }
+  }
+  children_ = std::move(parents);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_BUILDER_TYPE::NewPage() -> BasicPageGuard {
+  page_id_t page_id = INVALID_PAGE_ID;
+  auto guard = bpm_->NewPageGuarded(&page_id);
+  if (page_id == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new page");
+  }
+  return guard;
+}
+
+template class BPlusTreeBuilder<GenericKey<4>, RID, GenericComparator<4>>;
+
+template class BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>>;
+
+template class BPlusTreeBuilder<GenericKey<16>, RID, GenericComparator<16>>;
+
+template class BPlusTreeBuilder<GenericKey<32>, RID, GenericComparator<32>>;
+
+template class BPlusTreeBuilder<GenericKey<64>, RID, GenericComparator<64>>;
+
+}  // namespace bustub
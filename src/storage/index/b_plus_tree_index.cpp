@@ -9,6 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <numeric>
+
 #include "storage/index/b_plus_tree_index.h"
 
 namespace bustub {
@@ -51,6 +54,46 @@ void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, T
   container_->GetValue(index_key, result, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::InsertEntries(const std::vector<std::pair<Tuple, RID>> &entries, Transaction *transaction)
+    -> size_t {
+  std::vector<std::pair<KeyType, ValueType>> pairs(entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    pairs[i].first.SetFromKey(entries[i].first);
+    pairs[i].second = entries[i].second;
+  }
+  // Equal keys keep their order, so that the first one is inserted as it would be one by one.
+  std::stable_sort(pairs.begin(), pairs.end(),
+                   [this](const auto &lhs, const auto &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+  return container_->InsertBatch(pairs, transaction);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *result,
+                                    Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i]);
+  }
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](size_t lhs, size_t rhs) { return comparator_(index_keys[lhs], index_keys[rhs]) < 0; });
+  std::vector<KeyType> sorted_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    sorted_keys[i] = index_keys[order[i]];
+  }
+
+  std::vector<std::optional<ValueType>> values;
+  container_->GetValues(sorted_keys, &values, transaction);
+  result->assign(keys.size(), {});
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (values[i].has_value()) {
+      (*result)[order[i]].push_back(*values[i]);
+    }
+  }
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetBeginIterator() -> INDEXITERATOR_TYPE { return container_->Begin(); }
 
@@ -60,6 +103,19 @@ auto BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) -> INDEXITERATOR
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_INDEX_TYPE::GetEndIterator() -> INDEXITERATOR_TYPE { return container_->End(); }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator() -> INDEXITERATOR_TYPE { return container_->RBegin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::GetReverseBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE {
+  return container_->RBegin(key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::MakeBuilder(double fill_factor) -> std::unique_ptr<BPLUSTREE_BUILDER_TYPE> {
+  return std::make_unique<BPLUSTREE_BUILDER_TYPE>(container_.get(), fill_factor);
+}
+
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeIndex<GenericKey<16>, RID, GenericComparator<16>>;
@@ -1,10 +1,13 @@
 /**
  * index_iterator.cpp
  */
+#include <algorithm>
 #include <cassert>
+#include <utility>
 
 #include "common/config.h"
 #include "storage/index/index_iterator.h"
+#include "storage/page/b_plus_tree_header_page.h"
 #include "storage/page/page_guard.h"
 
 namespace bustub {
@@ -14,19 +17,20 @@ namespace bustub {
  * set your own input parameters
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(page_id_t leaf_page_id, LeafPage *leafPage, int index, BufferPoolManager *bpm)
-    : leaf_page_id_(leaf_page_id), leaf_page_(leafPage), index_(index), bpm_(bpm) {}
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t header_page_id, const KeyComparator &comparator,
+                                  const KeyType *key, bool reverse)
+    : bpm_(bpm),
+      header_page_id_(header_page_id),
+      comparator_(comparator),
+      reverse_(reverse) {
+  LoadLeaf(key, true);
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() = default;  // NOLINT
 
 INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::IsEnd() -> bool {
-  return leaf_page_->GetNextPageId() == INVALID_PAGE_ID && index_ == leaf_page_->GetSize();
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { return leaf_page_->ArrayIt(index_); }
+auto INDEXITERATOR_TYPE::operator*() -> const MappingType & { return entries_[index_]; }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
@@ -34,17 +38,138 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     return *this;
   }
   index_++;
-  if (index_ == leaf_page_->GetSize() && leaf_page_->GetNextPageId() != INVALID_PAGE_ID) {
-    page_id_t next_page_id = leaf_page_->GetNextPageId();
-    auto next_page_guard = bpm_->FetchPageBasic(next_page_id);
-    auto next_page = next_page_guard.As<LeafPage>();
-    leaf_page_id_ = next_page_id;
-    leaf_page_ = next_page;
-    index_ = 0;
+  if (IsEnd()) {
+    KeyType last_key = entries_.back().first;
+    LoadLeaf(&last_key, false);
   }
   return *this;
 }
 
+/*
+ * The search only ever latches a page while holding the latch of its parent, or of a page further up, like writers
+ * do. Going from a leaf straight to its neighbor instead could deadlock with a merge, which latches the right page of
+ * the two before the left one.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::LoadLeaf(const KeyType *key, bool inclusive) {
+  entries_.clear();
+  index_ = 0;
+  leaf_page_id_ = INVALID_PAGE_ID;
+
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    is_empty_ = true;
+    return;
+  }
+  // The lowest page on the way down with a child after (before, for reverse iterators) the one taken. Its subtree
+  // holds the next keys if the leaf the search ends in has none left, and it stays latched until then.
+  ReadPageGuard pivot_guard;
+  page_id_t pivot_child_id = INVALID_PAGE_ID;
+  // The page the child was taken from, still latched either by guard or by pivot_guard.
+  const InternalPage *parent_page = nullptr;
+  int index = 0;
+  while (true) {
+    ReadPageGuard child_guard = bpm_->FetchPageRead(page_id, AccessType::Scan);
+    if (child_guard.As<BPlusTreePage>()->IsLeafPage() && parent_page != nullptr) {
+      PrefetchSiblings(parent_page, index);
+    }
+    guard = std::move(child_guard);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      break;
+    }
+    auto internal_page = guard.As<InternalPage>();
+    parent_page = internal_page;
+    int size = internal_page->GetSize();
+    index = key == nullptr ? (reverse_ ? size - 1 : 0) : internal_page->GetKeyIndex(*key, *comparator_);
+    int pivot_index = reverse_ ? index - 1 : index + 1;
+    page_id = internal_page->ValueAt(index);
+    if (pivot_index >= 0 && pivot_index < size) {
+      pivot_child_id = internal_page->ValueAt(pivot_index);
+      pivot_guard = std::move(guard);
+    }
+  }
+  CopyPairs(guard.As<LeafPage>(), key, inclusive);
+
+  if (entries_.empty() && pivot_child_id != INVALID_PAGE_ID) {
+    // All keys under the pivot's next child come after the ones searched, the first leaf there has the next pairs.
+    guard.Drop();
+    guard = bpm_->FetchPageRead(pivot_child_id, AccessType::Scan);
+    pivot_guard.Drop();
+    while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+      auto internal_page = guard.As<InternalPage>();
+      index = reverse_ ? internal_page->GetSize() - 1 : 0;
+      ReadPageGuard child_guard = bpm_->FetchPageRead(internal_page->ValueAt(index), AccessType::Scan);
+      if (child_guard.As<BPlusTreePage>()->IsLeafPage()) {
+        PrefetchSiblings(internal_page, index);
+      }
+      guard = std::move(child_guard);
+    }
+    CopyPairs(guard.As<LeafPage>(), key, inclusive);
+  }
+  if (entries_.empty()) {
+    return;
+  }
+  leaf_page_id_ = guard.PageId();
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::CopyPairs(const LeafPage *leaf_page, const KeyType *key, bool inclusive) {
+  // The search narrows down the pairs, and each one is checked against key on top of that. A leaf that is out of order
+  // could otherwise give back pairs the iterator has already passed, and operator++() would never get past them.
+  auto is_past_key = [&](const MappingType &pair) {
+    if (key == nullptr) {
+      return true;
+    }
+    int cmp = (*comparator_)(pair.first, *key);
+    cmp = reverse_ ? -cmp : cmp;
+    return inclusive ? cmp >= 0 : cmp > 0;
+  };
+  int size = leaf_page->GetSize();
+  if (reverse_) {
+    int end = size;
+    if (key != nullptr) {
+      end = inclusive ? leaf_page->UpperKeyIndex(*key, *comparator_) : leaf_page->LowerKeyIndex(*key, *comparator_);
+    }
+    for (int i = end - 1; i >= 0; i--) {
+      if (is_past_key(leaf_page->ArrayIt(i))) {
+        entries_.push_back(leaf_page->ArrayIt(i));
+      }
+    }
+    return;
+  }
+  int begin = 0;
+  if (key != nullptr) {
+    begin = inclusive ? leaf_page->LowerKeyIndex(*key, *comparator_) : leaf_page->UpperKeyIndex(*key, *comparator_);
+  }
+  for (int i = begin; i < size; i++) {
+    if (is_past_key(leaf_page->ArrayIt(i))) {
+      entries_.push_back(leaf_page->ArrayIt(i));
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::PrefetchSiblings(const InternalPage *parent_page, int index) {
+  // A scan moves through the children of a parent in order, so a window is requested every READ_AHEAD_PAGES of them.
+  int offset = reverse_ ? parent_page->GetSize() - 1 - index : index;
+  if (!first_leaf_ && offset % READ_AHEAD_PAGES != 0) {
+    return;
+  }
+  first_leaf_ = false;
+  std::vector<page_id_t> page_ids;
+  for (int i = 1; i <= READ_AHEAD_PAGES; i++) {
+    int sibling_index = reverse_ ? index - i : index + i;
+    if (sibling_index < 0 || sibling_index >= parent_page->GetSize()) {
+      break;
+    }
+    page_ids.push_back(parent_page->ValueAt(sibling_index));
+  }
+  if (!page_ids.empty()) {
+    bpm_->Prefetch(page_ids);
+  }
+}
+
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
 template class IndexIterator<GenericKey<8>, RID, GenericComparator<8>>;
@@ -0,0 +1,363 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree.cpp
+//
+// Identification: src/storage/index/varlen_b_plus_tree.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "common/exception.h"
+#include "storage/index/varlen_b_plus_tree.h"
+#include "storage/page/b_plus_tree_header_page.h"
+
+namespace bustub {
+
+VarlenIndexIterator::VarlenIndexIterator(BufferPoolManager *bpm, ReadPageGuard leaf_guard, int index)
+    : bpm_(bpm), leaf_guard_(std::move(leaf_guard)), index_(index) {
+  leaf_ = leaf_guard_.As<LeafPage>();
+  SkipEmptyLeaves();
+}
+
+auto VarlenIndexIterator::operator++() -> VarlenIndexIterator & {
+  index_++;
+  SkipEmptyLeaves();
+  return *this;
+}
+
+void VarlenIndexIterator::SkipEmptyLeaves() {
+  while (index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      leaf_guard_.Drop();
+      leaf_ = nullptr;
+      return;
+    }
+    // The next leaf is latched before this one is let go, so no split can move entries past the iterator.
+    ReadPageGuard next_guard = bpm_->FetchPageRead(next_page_id, AccessType::Scan);
+    leaf_guard_ = std::move(next_guard);
+    leaf_ = leaf_guard_.As<LeafPage>();
+    index_ = 0;
+  }
+}
+
+VarlenBPlusTree::VarlenBPlusTree(std::string name, page_id_t header_page_id, BufferPoolManager *buffer_pool_manager)
+    : index_name_(std::move(name)), bpm_(buffer_pool_manager), header_page_id_(header_page_id) {
+  WritePageGuard guard = bpm_->FetchPageWrite(header_page_id_);
+  guard.AsMut<BPlusTreeHeaderPage>()->root_page_id_ = INVALID_PAGE_ID;
+}
+
+auto VarlenBPlusTree::IsEmpty() const -> bool { return GetRootPageId() == INVALID_PAGE_ID; }
+
+auto VarlenBPlusTree::GetRootPageId() const -> page_id_t {
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  return guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+}
+
+/*****************************************************************************
+ * SEARCH
+ *****************************************************************************/
+auto VarlenBPlusTree::GetValue(std::string_view key, std::vector<RID> *result, Transaction *txn) -> bool {
+  auto leaf_guard = FindLeafRead(key, false);
+  if (!leaf_guard.has_value()) {
+    return false;
+  }
+  auto leaf = leaf_guard->As<LeafPage>();
+  int index = leaf->LowerBound(key);
+  if (index == leaf->GetSize() || leaf->CompareAt(index, key) != 0) {
+    return false;
+  }
+  result->push_back(leaf->ValueAt(index));
+  return true;
+}
+
+auto VarlenBPlusTree::FindLeafRead(std::string_view key, bool leftmost) -> std::optional<ReadPageGuard> {
+  ReadPageGuard guard = bpm_->FetchPageRead(header_page_id_);
+  page_id_t page_id = guard.As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (page_id == INVALID_PAGE_ID) {
+    return std::nullopt;
+  }
+  while (true) {
+    ReadPageGuard child_guard = bpm_->FetchPageRead(page_id);
+    guard = std::move(child_guard);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      return guard;
+    }
+    auto internal = guard.As<InternalPage>();
+    page_id = internal->ValueAt(leftmost ? 0 : internal->UpperBound(key) - 1);
+  }
+}
+
+/*****************************************************************************
+ * INSERTION
+ *****************************************************************************/
+auto VarlenBPlusTree::Insert(std::string_view key, const RID &value, Transaction *txn) -> bool {
+  if (key.size() > static_cast<size_t>(VARLEN_KEY_MAX_SIZE)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "index key is longer than VARLEN_KEY_MAX_SIZE");
+  }
+  Context ctx;
+  ctx.header_page_ = bpm_->FetchPageWrite(header_page_id_);
+  auto header = ctx.header_page_->AsMut<BPlusTreeHeaderPage>();
+  if (header->root_page_id_ == INVALID_PAGE_ID) {
+    page_id_t root_id;
+    auto root_guard = NewPage(&root_id);
+    auto root = root_guard.AsMut<LeafPage>();
+    root->Init(IndexPageType::LEAF_PAGE);
+    root->Insert(0, key, value);
+    header->root_page_id_ = root_id;
+    return true;
+  }
+
+  // Write-crab down to the leaf, letting go of everything above a page that cannot split.
+  ctx.root_page_id_ = header->root_page_id_;
+  page_id_t page_id = ctx.root_page_id_;
+  while (true) {
+    WritePageGuard guard = bpm_->FetchPageWrite(page_id);
+    auto page = guard.As<BPlusTreePage>();
+    bool safe = page->IsLeafPage() ? guard.As<LeafPage>()->IsSafeForInsert(key)
+                                   : guard.As<InternalPage>()->IsSafeForInsert(key);
+    if (safe) {
+      ctx.header_page_ = std::nullopt;
+      ctx.write_set_.clear();
+    }
+    ctx.write_set_.push_back(std::move(guard));
+    if (page->IsLeafPage()) {
+      break;
+    }
+    auto internal = ctx.write_set_.back().As<InternalPage>();
+    page_id = internal->ValueAt(internal->UpperBound(key) - 1);
+  }
+
+  auto &leaf_guard = ctx.write_set_.back();
+  auto leaf = leaf_guard.AsMut<LeafPage>();
+  int index = leaf->LowerBound(key);
+  if (index < leaf->GetSize() && leaf->CompareAt(index, key) == 0) {
+    return false;
+  }
+  if (leaf->Insert(index, key, value)) {
+    return true;
+  }
+
+  auto entries = leaf->Entries();
+  entries.emplace(entries.begin() + index, key, value);
+  size_t split = leaf->SplitPoint(entries);
+  page_id_t new_leaf_id;
+  auto new_leaf_guard = NewPage(&new_leaf_id);
+  auto new_leaf = new_leaf_guard.AsMut<LeafPage>();
+  new_leaf->Init(IndexPageType::LEAF_PAGE);
+  leaf->Rebuild(entries, 0, split);
+  new_leaf->Rebuild(entries, split, entries.size());
+  new_leaf->SetNextPageId(leaf->GetNextPageId());
+  leaf->SetNextPageId(new_leaf_id);
+  std::string separator = LeafPage::Separator(entries[split - 1].first, entries[split].first);
+  page_id_t leaf_id = leaf_guard.PageId();
+  ctx.write_set_.pop_back();
+  InsertIntoParent(leaf_id, std::move(separator), new_leaf_id, &ctx);
+  return true;
+}
+
+void VarlenBPlusTree::InsertIntoParent(page_id_t left_id, std::string separator, page_id_t right_id, Context *ctx) {
+  while (!ctx->write_set_.empty()) {
+    auto &parent_guard = ctx->write_set_.back();
+    auto parent = parent_guard.AsMut<InternalPage>();
+    int index = parent->UpperBound(separator);
+    if (parent->Insert(index, separator, right_id)) {
+      return;
+    }
+
+    // The key at the split point goes up, and stays as the unused first key of the new page.
+    auto entries = parent->Entries();
+    entries.emplace(entries.begin() + index, std::move(separator), right_id);
+    size_t split = parent->SplitPoint(entries);
+    page_id_t new_page_id;
+    auto new_guard = NewPage(&new_page_id);
+    auto new_page = new_guard.AsMut<InternalPage>();
+    new_page->Init(IndexPageType::INTERNAL_PAGE);
+    parent->Rebuild(entries, 0, split);
+    new_page->Rebuild(entries, split, entries.size());
+    separator = std::move(entries[split].first);
+    left_id = parent_guard.PageId();
+    right_id = new_page_id;
+    ctx->write_set_.pop_back();
+  }
+
+  // The root was split, the header is still latched.
+  BUSTUB_ASSERT(ctx->header_page_.has_value(), "splitting the root without the header latched");
+  page_id_t root_id;
+  auto root_guard = NewPage(&root_id);
+  auto root = root_guard.AsMut<InternalPage>();
+  root->Init(IndexPageType::INTERNAL_PAGE);
+  root->Rebuild({{"", left_id}, {std::move(separator), right_id}}, 0, 2);
+  ctx->header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = root_id;
+}
+
+auto VarlenBPlusTree::NewPage(page_id_t *page_id) -> BasicPageGuard {
+  *page_id = INVALID_PAGE_ID;
+  auto guard = bpm_->NewPageGuarded(page_id);
+  if (*page_id == INVALID_PAGE_ID) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate new page");
+  }
+  return guard;
+}
+
+void VarlenBPlusTree::DeletePage(page_id_t page_id) {
+  // Nobody can reach the page anymore, but a thread that let go of its latch may not have unpinned it yet.
+  while (!bpm_->DeletePage(page_id)) {
+    std::this_thread::yield();
+  }
+}
+
+/*****************************************************************************
+ * REMOVE
+ *****************************************************************************/
+void VarlenBPlusTree::Remove(std::string_view key, Transaction *txn) {
+  Context ctx;
+  ctx.header_page_ = bpm_->FetchPageWrite(header_page_id_);
+  ctx.root_page_id_ = ctx.header_page_->As<BPlusTreeHeaderPage>()->root_page_id_;
+  if (ctx.root_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+
+  // Write-crab down to the leaf, letting go of everything above a page that cannot become underfull. The root has no
+  // sibling to merge with, it only changes once it is a leaf without keys or an internal page with one child.
+  page_id_t page_id = ctx.root_page_id_;
+  while (true) {
+    WritePageGuard guard = bpm_->FetchPageWrite(page_id);
+    auto page = guard.As<BPlusTreePage>();
+    bool safe;
+    if (ctx.IsRootPage(page_id)) {
+      safe = page->GetSize() > (page->IsLeafPage() ? 1 : 2);
+    } else {
+      safe = page->IsLeafPage() ? guard.As<LeafPage>()->IsSafeForRemove(key)
+                                : guard.As<InternalPage>()->IsSafeForRemove(key);
+    }
+    if (safe) {
+      ctx.header_page_ = std::nullopt;
+      ctx.write_set_.clear();
+    }
+    ctx.write_set_.push_back(std::move(guard));
+    if (page->IsLeafPage()) {
+      break;
+    }
+    auto internal = ctx.write_set_.back().As<InternalPage>();
+    page_id = internal->ValueAt(internal->UpperBound(key) - 1);
+  }
+
+  auto leaf = ctx.write_set_.back().AsMut<LeafPage>();
+  int index = leaf->LowerBound(key);
+  if (index == leaf->GetSize() || leaf->CompareAt(index, key) != 0) {
+    return;
+  }
+  leaf->Remove(index);
+  MergeUnderfull(key, &ctx);
+}
+
+void VarlenBPlusTree::MergeUnderfull(std::string_view key, Context *ctx) {
+  while (!ctx->write_set_.empty()) {
+    WritePageGuard guard = std::move(ctx->write_set_.back());
+    ctx->write_set_.pop_back();
+    if (ctx->IsRootPage(guard.PageId())) {
+      AdjustRoot(&guard, ctx);
+      return;
+    }
+    bool leaf = guard.As<BPlusTreePage>()->IsLeafPage();
+    bool underfull = leaf ? guard.As<LeafPage>()->IsUnderfull() : guard.As<InternalPage>()->IsUnderfull();
+    // A page whose parent was let go during the descent was safe, it cannot be underfull.
+    if (!underfull || ctx->write_set_.empty()) {
+      return;
+    }
+    auto parent = ctx->write_set_.back().AsMut<InternalPage>();
+    if (parent->GetSize() < 2) {
+      return;
+    }
+
+    // Merge the right page of a pair into the left one. The left page is latched first, like iterators do, so a page
+    // with a left sibling is let go and latched again. Nobody can split it meanwhile, its parent is latched.
+    int index = parent->UpperBound(key) - 1;
+    int right_index = index > 0 ? index : 1;
+    WritePageGuard left_guard;
+    WritePageGuard right_guard;
+    if (index > 0) {
+      guard.Drop();
+      left_guard = bpm_->FetchPageWrite(parent->ValueAt(index - 1));
+      right_guard = bpm_->FetchPageWrite(parent->ValueAt(index));
+    } else {
+      left_guard = std::move(guard);
+      right_guard = bpm_->FetchPageWrite(parent->ValueAt(1));
+    }
+    page_id_t right_id = right_guard.PageId();
+    if (leaf) {
+      auto left = left_guard.AsMut<LeafPage>();
+      auto right = right_guard.As<LeafPage>();
+      auto entries = left->Entries();
+      auto right_entries = right->Entries();
+      entries.insert(entries.end(), right_entries.begin(), right_entries.end());
+      if (!left->Fits(entries)) {
+        return;
+      }
+      left->Rebuild(entries, 0, entries.size());
+      left->SetNextPageId(right->GetNextPageId());
+    } else {
+      // The separator comes down from the parent to take the place of the right page's unused first key.
+      auto left = left_guard.AsMut<InternalPage>();
+      auto right_entries = right_guard.As<InternalPage>()->Entries();
+      right_entries[0].first = parent->KeyAt(right_index);
+      auto entries = left->Entries();
+      entries.insert(entries.end(), right_entries.begin(), right_entries.end());
+      if (!left->Fits(entries)) {
+        return;
+      }
+      left->Rebuild(entries, 0, entries.size());
+    }
+    right_guard.Drop();
+    left_guard.Drop();
+    DeletePage(right_id);
+    parent->Remove(right_index);
+  }
+}
+
+void VarlenBPlusTree::AdjustRoot(WritePageGuard *root_guard, Context *ctx) {
+  auto root = root_guard->As<BPlusTreePage>();
+  page_id_t new_root_id;
+  if (root->IsLeafPage() && root->GetSize() == 0) {
+    new_root_id = INVALID_PAGE_ID;
+  } else if (!root->IsLeafPage() && root->GetSize() == 1) {
+    new_root_id = root_guard->As<InternalPage>()->ValueAt(0);
+  } else {
+    return;
+  }
+  // The root only gets here while the header is still latched, see Remove().
+  BUSTUB_ASSERT(ctx->header_page_.has_value(), "shrinking the root without the header latched");
+  ctx->header_page_->AsMut<BPlusTreeHeaderPage>()->root_page_id_ = new_root_id;
+  page_id_t root_id = root_guard->PageId();
+  root_guard->Drop();
+  DeletePage(root_id);
+}
+
+/*****************************************************************************
+ * INDEX ITERATOR
+ *****************************************************************************/
+auto VarlenBPlusTree::Begin() -> VarlenIndexIterator {
+  auto leaf_guard = FindLeafRead({}, true);
+  if (!leaf_guard.has_value()) {
+    return {};
+  }
+  return {bpm_, std::move(*leaf_guard), 0};
+}
+
+auto VarlenBPlusTree::Begin(std::string_view key) -> VarlenIndexIterator {
+  auto leaf_guard = FindLeafRead(key, false);
+  if (!leaf_guard.has_value()) {
+    return {};
+  }
+  int index = leaf_guard->As<LeafPage>()->LowerBound(key);
+  return {bpm_, std::move(*leaf_guard), index};
+}
+
+}  // namespace bustub
@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// varlen_b_plus_tree_index.cpp
+//
+// Identification: src/storage/index/varlen_b_plus_tree_index.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+
+#include "common/exception.h"
+#include "storage/index/varlen_b_plus_tree_index.h"
+
+namespace bustub {
+
+namespace {
+
+/** Appends the bytes of an unsigned integer, most significant first. */
+template <typename T>
+void AppendBigEndian(std::string *out, T value) {
+  for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8) {
+    out->push_back(static_cast<char>((value >> shift) & 0xFF));
+  }
+}
+
+/** Appends a signed integer, with the sign bit flipped so that negative numbers come first. */
+template <typename Signed, typename Unsigned>
+void AppendSigned(std::string *out, Signed value) {
+  AppendBigEndian<Unsigned>(out, static_cast<Unsigned>(value) ^ (Unsigned{1} << (sizeof(Unsigned) * 8 - 1)));
+}
+
+}  // namespace
+
+VarlenBPlusTreeIndex::VarlenBPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata,
+                                           BufferPoolManager *buffer_pool_manager)
+    : Index(std::move(metadata)) {
+  page_id_t header_page_id;
+  buffer_pool_manager->NewPage(&header_page_id);
+  container_ = std::make_shared<VarlenBPlusTree>(GetMetadata()->GetName(), header_page_id, buffer_pool_manager);
+}
+
+auto VarlenBPlusTreeIndex::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) -> bool {
+  return container_->Insert(EncodeKey(key, *GetKeySchema()), rid, transaction);
+}
+
+void VarlenBPlusTreeIndex::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
+  container_->Remove(EncodeKey(key, *GetKeySchema()), transaction);
+}
+
+void VarlenBPlusTreeIndex::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
+  container_->GetValue(EncodeKey(key, *GetKeySchema()), result, transaction);
+}
+
+auto VarlenBPlusTreeIndex::GetBeginIterator() -> VarlenIndexIterator { return container_->Begin(); }
+
+auto VarlenBPlusTreeIndex::GetBeginIterator(const Tuple &key) -> VarlenIndexIterator {
+  return container_->Begin(EncodeKey(key, *GetKeySchema()));
+}
+
+auto VarlenBPlusTreeIndex::EncodeKey(const Tuple &key, const Schema &key_schema) -> std::string {
+  std::string out;
+  for (uint32_t i = 0; i < key_schema.GetColumnCount(); i++) {
+    Value value = key.GetValue(&key_schema, i);
+    if (value.IsNull()) {
+      out.push_back(0);
+      continue;
+    }
+    out.push_back(1);
+    switch (value.GetTypeId()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        AppendSigned<int8_t, uint8_t>(&out, value.GetAs<int8_t>());
+        break;
+      case TypeId::SMALLINT:
+        AppendSigned<int16_t, uint16_t>(&out, value.GetAs<int16_t>());
+        break;
+      case TypeId::INTEGER:
+        AppendSigned<int32_t, uint32_t>(&out, value.GetAs<int32_t>());
+        break;
+      case TypeId::BIGINT:
+        AppendSigned<int64_t, uint64_t>(&out, value.GetAs<int64_t>());
+        break;
+      case TypeId::TIMESTAMP:
+        AppendBigEndian<uint64_t>(&out, value.GetAs<uint64_t>());
+        break;
+      case TypeId::DECIMAL: {
+        // Positive numbers only need the sign bit set, negative ones all their bits flipped to reverse their order.
+        auto number = value.GetAs<double>();
+        uint64_t bits;
+        std::memcpy(&bits, &number, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits | (uint64_t{1} << 63);
+        AppendBigEndian<uint64_t>(&out, bits);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        // The terminator sorts below any byte that can follow, so a string comes before the longer ones it starts.
+        const char *data = value.GetData();
+        for (uint32_t pos = 0; pos + 1 < value.GetLength(); pos++) {
+          out.push_back(data[pos]);
+          if (data[pos] == 0) {
+            out.push_back(static_cast<char>(0xFF));
+          }
+        }
+        out.push_back(0);
+        out.push_back(0);
+        break;
+      }
+      default:
+        throw Exception(ExceptionType::NOT_IMPLEMENTED, "cannot index a column of this type");
+    }
+  }
+  return out;
+}
+
+}  // namespace bustub
@@ -16,6 +16,7 @@
 
 #include "common/config.h"
 #include "common/exception.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
@@ -50,17 +51,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) { a
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetKeyIndex(const KeyType &key, KeyComparator comparator_) const -> int {
   // 中间节点大于key的前一个index，即upper_bound - 1
-  int l = 1;
-  int r = GetSize();
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  return l - 1;
+  return KeySearch<KeyType, ValueType, KeyComparator>::UpperBound(array_, 1, GetSize(), key, comparator_) - 1;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -93,17 +84,7 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CreatNewRoot(const KeyType &key, page_id_t
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &key, page_id_t right_id, KeyComparator comparator_) {
   // 中间节点找到大于key的index
-  int l = 1;
-  int r = GetSize();
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  int index = l;
+  int index = KeySearch<KeyType, ValueType, KeyComparator>::UpperBound(array_, 1, GetSize(), key, comparator_);
   for (int i = GetSize() - 1; i >= index; i--) {
     array_[i + 1] = array_[i];
   }
@@ -169,6 +150,12 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveEndTo(B_PLUS_TREE_INTERNAL_PAGE_TYPE *p
   return page->array_[0].first;
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Append(const KeyType &key, page_id_t child_id) {
+  array_[GetSize()] = std::make_pair(key, child_id);
+  IncreaseSize(1);
+}
+
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
 template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
@@ -16,6 +16,7 @@
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/rid.h"
+#include "storage/index/key_search.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -55,21 +56,11 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const -> KeyType {
   return array_[index].first;
 }
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAtKey(const KeyType &key, ValueType &v, KeyComparator comparator_) -> bool {
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAtKey(const KeyType &key, ValueType &v, KeyComparator comparator_) const -> bool {
   // 叶子节点找到对应key的value
-  int l = 0;
-  int r = GetSize() - 1;
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0 || comparator_(array_[mid].first, key) == 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  int index = l;
+  int index = KeySearch<KeyType, ValueType, KeyComparator>::LowerBound(array_, 0, GetSize(), key, comparator_);
   // 如果没找到则return false;
-  if (index == GetMaxSize() || comparator_(array_[index].first, key) != 0) {
+  if (index == GetSize() || comparator_(array_[index].first, key) != 0) {
     return false;
   }
   v = array_[index].second;
@@ -79,19 +70,9 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::ValueAtKey(const KeyType &key, ValueType &v, Ke
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, KeyComparator comparator_) -> bool {
   //  叶子节点找到恰好大于这个key的index，即upper_bound
-  int l = 0;
-  int r = GetSize();
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  int index = l;
+  int index = KeySearch<KeyType, ValueType, KeyComparator>::UpperBound(array_, 0, GetSize(), key, comparator_);
   // 如果插入相同的值则return false;
-  if (GetSize() > 0 && comparator_(array_[index - 1].first, key) == 0) {
+  if (index > 0 && comparator_(array_[index - 1].first, key) == 0) {
     return false;
   }
   auto new_pair = std::make_pair(key, value);
@@ -118,36 +99,28 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Split(B_PLUS_TREE_LEAF_PAGE_TYPE *new_leaf_page
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::KetIndex(const KeyType &key, KeyComparator comparator_) -> int {
-  int l = 0;
-  int r = GetSize() - 1;
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0 || comparator_(array_[mid].first, key) == 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  return l;
+  // The search range ends before the last key, so a key past all others lands on the last one.
+  return KeySearch<KeyType, ValueType, KeyComparator>::LowerBound(array_, 0, std::max(GetSize() - 1, 0), key,
+                                                                  comparator_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::ArrayIt(int index) -> const MappingType & { return this->array_[index]; }
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::LowerKeyIndex(const KeyType &key, KeyComparator comparator_) const -> int {
+  return KeySearch<KeyType, ValueType, KeyComparator>::LowerBound(array_, 0, GetSize(), key, comparator_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::UpperKeyIndex(const KeyType &key, KeyComparator comparator_) const -> int {
+  return KeySearch<KeyType, ValueType, KeyComparator>::UpperBound(array_, 0, GetSize(), key, comparator_);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::ArrayIt(int index) const -> const MappingType & { return this->array_[index]; }
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveRecord(const KeyType &key, KeyComparator comparator_) -> bool {
-  int l = 0;
-  int r = GetSize() - 1;
-  while (l < r) {
-    int mid = (l + r) >> 1;
-    if (comparator_(array_[mid].first, key) > 0 || comparator_(array_[mid].first, key) == 0) {
-      r = mid;
-    } else {
-      l = mid + 1;
-    }
-  }
-  int index = l;
-  if (comparator_(array_[index].first, key) != 0) {
+  int index = KeySearch<KeyType, ValueType, KeyComparator>::LowerBound(array_, 0, GetSize(), key, comparator_);
+  if (index == GetSize() || comparator_(array_[index].first, key) != 0) {
     return false;
   }
   for (int i = index; i < GetSize() - 1; i++) {
@@ -200,6 +173,12 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::SetKeyValueAt(int index, const KeyType &key, co
   SetSize(1);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Append(const KeyType &key, const ValueType &value) {
+  array_[GetSize()] = std::make_pair(key, value);
+  IncreaseSize(1);
+}
+
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
@@ -0,0 +1,310 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_page.cpp
+//
+// Identification: src/storage/page/b_plus_tree_varlen_page.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/macros.h"
+#include "common/rid.h"
+#include "storage/page/b_plus_tree_varlen_page.h"
+
+namespace bustub {
+
+namespace {
+
+auto CommonPrefixSize(std::string_view lhs, std::string_view rhs) -> size_t {
+  size_t size = std::min(lhs.size(), rhs.size());
+  return std::mismatch(lhs.begin(), lhs.begin() + size, rhs.begin()).first - lhs.begin();
+}
+
+}  // namespace
+
+/*****************************************************************************
+ * HELPER METHODS AND UTILITIES
+ *****************************************************************************/
+
+/**
+ * Init method after creating a new page
+ * Including set page type, set current size to zero, set next page id and set the key space empty
+ */
+template <typename ValueType>
+void B_PLUS_TREE_VARLEN_PAGE_TYPE::Init(IndexPageType page_type) {
+  SetPageType(page_type);
+  SetSize(0);
+  // Pages are bounded by bytes, not by entries.
+  SetMaxSize(0);
+  next_page_id_ = INVALID_PAGE_ID;
+  prefix_offset_ = BUSTUB_PAGE_SIZE;
+  prefix_size_ = 0;
+  keys_begin_ = BUSTUB_PAGE_SIZE;
+  freed_bytes_ = 0;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::GetNextPageId() const -> page_id_t {
+  return next_page_id_;
+}
+
+template <typename ValueType>
+void B_PLUS_TREE_VARLEN_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {
+  next_page_id_ = next_page_id;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::GetPrefix() const -> std::string_view {
+  return {reinterpret_cast<const char *>(this) + prefix_offset_, prefix_size_};
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::SuffixAt(int index) const -> std::string_view {
+  return {reinterpret_cast<const char *>(this) + array_[index].key_offset_, array_[index].key_size_};
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::KeyAt(int index) const -> std::string {
+  if (index < FirstKeyIndex()) {
+    return {};
+  }
+  std::string key(GetPrefix());
+  key.append(SuffixAt(index));
+  return key;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::ValueAt(int index) const -> ValueType {
+  return array_[index].value_;
+}
+
+template <typename ValueType>
+void B_PLUS_TREE_VARLEN_PAGE_TYPE::SetValueAt(int index, const ValueType &value) {
+  array_[index].value_ = value;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::CompareAt(int index, std::string_view key) const -> int {
+  auto prefix = GetPrefix();
+  int cmp = prefix.compare(key.substr(0, prefix.size()));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return SuffixAt(index).compare(key.substr(prefix.size()));
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::LowerBound(std::string_view key) const -> int {
+  // The prefix is compared once, then only the suffixes are searched.
+  auto prefix = GetPrefix();
+  int cmp = prefix.compare(key.substr(0, prefix.size()));
+  if (cmp != 0) {
+    return cmp > 0 ? FirstKeyIndex() : GetSize();
+  }
+  auto rest = key.substr(prefix.size());
+  int low = FirstKeyIndex();
+  int high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (SuffixAt(mid).compare(rest) < 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::UpperBound(std::string_view key) const -> int {
+  auto prefix = GetPrefix();
+  int cmp = prefix.compare(key.substr(0, prefix.size()));
+  if (cmp != 0) {
+    return cmp > 0 ? FirstKeyIndex() : GetSize();
+  }
+  auto rest = key.substr(prefix.size());
+  int low = FirstKeyIndex();
+  int high = GetSize();
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (SuffixAt(mid).compare(rest) <= 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::FreeBytes() const -> size_t {
+  return keys_begin_ - VARLEN_PAGE_HEADER_SIZE - GetSize() * sizeof(Slot) + freed_bytes_;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::Insert(int index, std::string_view key, const ValueType &value) -> bool {
+  auto prefix = GetPrefix();
+  if (key.substr(0, prefix.size()) != prefix) {
+    auto entries = Entries();
+    entries.emplace(entries.begin() + index, key, value);
+    if (PackedSize(entries, 0, entries.size()) > CAPACITY) {
+      return false;
+    }
+    Rebuild(entries, 0, entries.size());
+    return true;
+  }
+
+  auto suffix = key.substr(prefix.size());
+  if (sizeof(Slot) + suffix.size() > FreeBytes()) {
+    return false;
+  }
+  if (VARLEN_PAGE_HEADER_SIZE + (GetSize() + 1) * sizeof(Slot) + suffix.size() > keys_begin_) {
+    // There is room, but only in the bytes removed keys left behind. Rebuilding may also find a longer prefix.
+    Rebuild(Entries(), 0, GetSize());
+    return Insert(index, key, value);
+  }
+  std::memmove(&array_[index + 1], &array_[index], (GetSize() - index) * sizeof(Slot));
+  keys_begin_ -= suffix.size();
+  std::memcpy(reinterpret_cast<char *>(this) + keys_begin_, suffix.data(), suffix.size());
+  array_[index] = {keys_begin_, static_cast<uint16_t>(suffix.size()), value};
+  IncreaseSize(1);
+  return true;
+}
+
+template <typename ValueType>
+void B_PLUS_TREE_VARLEN_PAGE_TYPE::Remove(int index) {
+  freed_bytes_ += array_[index].key_size_;
+  std::memmove(&array_[index], &array_[index + 1], (GetSize() - index - 1) * sizeof(Slot));
+  IncreaseSize(-1);
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::IsSafeForInsert(std::string_view key) const -> bool {
+  // A separator is no longer than the key of the leaf it is taken from.
+  size_t key_size = IsLeafPage() ? key.size() : VARLEN_KEY_MAX_SIZE;
+  // A new key between two keys of the page starts with their prefix. Only a key past either end may not, and then
+  // every key takes the prefix back.
+  int upper = UpperBound(key);
+  bool between = upper > FirstKeyIndex() && upper < GetSize();
+  size_t growth = between ? 0 : GetSize() * prefix_size_;
+  return FreeBytes() >= sizeof(Slot) + key_size + growth;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::IsSafeForRemove(std::string_view key) const -> bool {
+  // Removing a key never changes the prefix, so at most the slot and the whole key are given back.
+  size_t key_size = IsLeafPage() ? key.size() : VARLEN_KEY_MAX_SIZE;
+  return CAPACITY - FreeBytes() >= MIN_USED_BYTES + sizeof(Slot) + key_size;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::IsUnderfull() const -> bool {
+  return CAPACITY - FreeBytes() < MIN_USED_BYTES;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::Fits(const std::vector<Entry> &entries) const -> bool {
+  return PackedSize(entries, 0, entries.size()) <= CAPACITY;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::Entries() const -> std::vector<Entry> {
+  std::vector<Entry> entries;
+  entries.reserve(GetSize());
+  for (int i = 0; i < GetSize(); i++) {
+    entries.emplace_back(KeyAt(i), ValueAt(i));
+  }
+  return entries;
+}
+
+template <typename ValueType>
+void B_PLUS_TREE_VARLEN_PAGE_TYPE::Rebuild(const std::vector<Entry> &entries, size_t begin, size_t end) {
+  BUSTUB_ASSERT(PackedSize(entries, begin, end) <= CAPACITY, "entries do not fit into a page");
+  auto *data = reinterpret_cast<char *>(this);
+  size_t first = begin + FirstKeyIndex();
+  size_t prefix_size = first < end ? CommonPrefixSize(entries[first].first, entries[end - 1].first) : 0;
+  keys_begin_ = BUSTUB_PAGE_SIZE - prefix_size;
+  if (prefix_size > 0) {
+    std::memcpy(data + keys_begin_, entries[first].first.data(), prefix_size);
+  }
+  prefix_offset_ = keys_begin_;
+  prefix_size_ = prefix_size;
+  freed_bytes_ = 0;
+  for (size_t i = begin; i < end; i++) {
+    std::string_view suffix;
+    if (i >= first) {
+      suffix = std::string_view(entries[i].first).substr(prefix_size);
+    }
+    keys_begin_ -= suffix.size();
+    std::memcpy(data + keys_begin_, suffix.data(), suffix.size());
+    array_[i - begin] = {keys_begin_, static_cast<uint16_t>(suffix.size()), entries[i].second};
+  }
+  SetSize(static_cast<int>(end - begin));
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::PackedSize(const std::vector<Entry> &entries, size_t begin, size_t end) const
+    -> size_t {
+  size_t first = begin + FirstKeyIndex();
+  size_t size = (end - begin) * sizeof(Slot);
+  if (first < end) {
+    size_t prefix_size = CommonPrefixSize(entries[first].first, entries[end - 1].first);
+    size += prefix_size;
+    for (size_t i = first; i < end; i++) {
+      size += entries[i].first.size() - prefix_size;
+    }
+  }
+  return size;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::SplitPoint(const std::vector<Entry> &entries) const -> size_t {
+  BUSTUB_ASSERT(entries.size() >= 2, "cannot split a single entry");
+  size_t first = FirstKeyIndex();
+  // key_bytes[i] is the size of the keys before index i, the unused key of an internal page has none.
+  std::vector<size_t> key_bytes(entries.size() + 1, 0);
+  for (size_t i = 0; i < entries.size(); i++) {
+    key_bytes[i + 1] = key_bytes[i] + entries[i].first.size();
+  }
+  // Both halves of an internal page start with an unused key.
+  auto packed = [&](size_t begin, size_t end) {
+    size_t key_begin = begin + first;
+    size_t size = (end - begin) * sizeof(Slot);
+    if (key_begin < end) {
+      size_t prefix_size = CommonPrefixSize(entries[key_begin].first, entries[end - 1].first);
+      size += key_bytes[end] - key_bytes[key_begin] - (end - key_begin - 1) * prefix_size;
+    }
+    return size;
+  };
+
+  size_t best = 0;
+  size_t best_size = 0;
+  for (size_t split = 1; split < entries.size(); split++) {
+    size_t size = std::max(packed(0, split), packed(split, entries.size()));
+    if (best == 0 || size < best_size) {
+      best = split;
+      best_size = size;
+    }
+  }
+  BUSTUB_ASSERT(best_size <= CAPACITY, "entries do not fit into two pages");
+  return best;
+}
+
+template <typename ValueType>
+auto B_PLUS_TREE_VARLEN_PAGE_TYPE::Separator(std::string_view left, std::string_view right) -> std::string {
+  return std::string(right.substr(0, CommonPrefixSize(left, right) + 1));
+}
+
+template class BPlusTreeVarlenPage<RID>;
+template class BPlusTreeVarlenPage<page_id_t>;
+
+static_assert(sizeof(BPlusTreeVarlenPage<RID>) == VARLEN_PAGE_HEADER_SIZE);
+static_assert(sizeof(BPlusTreeVarlenPage<page_id_t>) == VARLEN_PAGE_HEADER_SIZE);
+
+}  // namespace bustub
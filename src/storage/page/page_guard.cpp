@@ -15,7 +15,7 @@ BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept {
 
 void BasicPageGuard::Drop() {
   if (bpm_ != nullptr && page_ != nullptr) {
-    bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+    bpm_->UnpinPage(page_, is_dirty_);
   }
   bpm_ = nullptr;
   page_ = nullptr;
@@ -24,7 +24,7 @@ void BasicPageGuard::Drop() {
 auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
   if (this != &that) {
     if (this->page_ != nullptr) {
-      this->bpm_->UnpinPage(this->page_->GetPageId(), this->is_dirty_);
+      this->bpm_->UnpinPage(this->page_, this->is_dirty_);
     }
 
     this->bpm_ = that.bpm_;
@@ -52,7 +52,7 @@ auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &
   if (this != &that) {
     if (this->guard_.page_ != nullptr) {
       this->guard_.page_->RUnlatch();
-      this->guard_.bpm_->UnpinPage(this->guard_.page_->GetPageId(), this->guard_.is_dirty_);
+      this->guard_.bpm_->UnpinPage(this->guard_.page_, this->guard_.is_dirty_);
     }
 
     this->guard_.bpm_ = that.guard_.bpm_;
@@ -70,7 +70,7 @@ void ReadPageGuard::Drop() {
     guard_.page_->RUnlatch();
   }
   if (guard_.bpm_ != nullptr && guard_.page_ != nullptr) {
-    guard_.bpm_->UnpinPage(guard_.PageId(), guard_.is_dirty_);
+    guard_.bpm_->UnpinPage(guard_.page_, guard_.is_dirty_);
   }
   guard_.bpm_ = nullptr;
   guard_.page_ = nullptr;
@@ -91,7 +91,7 @@ auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard
   if (this != &that) {
     if (this->guard_.page_ != nullptr) {
       this->guard_.page_->WUnlatch();
-      this->guard_.bpm_->UnpinPage(this->guard_.page_->GetPageId(), this->guard_.is_dirty_);
+      this->guard_.bpm_->UnpinPage(this->guard_.page_, this->guard_.is_dirty_);
     }
 
     this->guard_.bpm_ = that.guard_.bpm_;
@@ -109,7 +109,7 @@ void WritePageGuard::Drop() {
     guard_.page_->WUnlatch();
   }
   if (guard_.bpm_ != nullptr && guard_.page_ != nullptr) {
-    guard_.bpm_->UnpinPage(guard_.PageId(), guard_.is_dirty_);
+    guard_.bpm_->UnpinPage(guard_.page_, guard_.is_dirty_);
   }
   guard_.bpm_ = nullptr;
   guard_.page_ = nullptr;
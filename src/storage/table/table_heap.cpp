@@ -91,8 +91,8 @@ void TableHeap::UpdateTupleMeta(const TupleMeta &meta, RID rid) {
   page->UpdateTupleMeta(meta, rid);
 }
 
-auto TableHeap::GetTuple(RID rid) -> std::pair<TupleMeta, Tuple> {
-  auto page_guard = bpm_->FetchPageRead(rid.GetPageId());
+auto TableHeap::GetTuple(RID rid, AccessType access_type) -> std::pair<TupleMeta, Tuple> {
+  auto page_guard = bpm_->FetchPageRead(rid.GetPageId(), access_type);
   auto page = page_guard.As<TablePage>();
   auto [meta, tuple] = page->GetTuple(rid);
   tuple.rid_ = rid;
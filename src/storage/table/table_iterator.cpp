@@ -24,21 +24,31 @@ TableIterator::TableIterator(TableHeap *table_heap, RID rid, RID stop_at_rid)
     : table_heap_(table_heap), rid_(rid), stop_at_rid_(stop_at_rid) {
   // If the rid doesn't correspond to a tuple (i.e., the table has just been initialized), then
   // we set rid_ to invalid.
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
+  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId(), AccessType::Scan);
   auto page = page_guard.As<TablePage>();
   if (rid_.GetSlotNum() >= page->GetNumTuples()) {
     rid_ = RID{INVALID_PAGE_ID, 0};
   }
+  page_guard.Drop();
+
+  if (!IsEnd()) {
+    read_ahead_ = ReadAheadWindow(table_heap_->bpm_, [](const char *page_data) {
+      return reinterpret_cast<const TablePage *>(page_data)->GetNextPageId();
+    });
+    read_ahead_.Advance(rid_.GetPageId());
+  }
 }
 
-auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> { return table_heap_->GetTuple(rid_); }
+auto TableIterator::GetTuple() -> std::pair<TupleMeta, Tuple> {
+  return table_heap_->GetTuple(rid_, AccessType::Scan);
+}
 
 auto TableIterator::GetRID() -> RID { return rid_; }
 
 auto TableIterator::IsEnd() -> bool { return rid_.GetPageId() == INVALID_PAGE_ID; }
 
 auto TableIterator::operator++() -> TableIterator & {
-  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId());
+  auto page_guard = table_heap_->bpm_->FetchPageRead(rid_.GetPageId(), AccessType::Scan);
   auto page = page_guard.As<TablePage>();
   auto next_tuple_id = rid_.GetSlotNum() + 1;
 
@@ -64,6 +74,10 @@ auto TableIterator::operator++() -> TableIterator & {
 
   page_guard.Drop();
 
+  if (!IsEnd() && rid_.GetSlotNum() == 0) {
+    read_ahead_.Advance(rid_.GetPageId());
+  }
+
   return *this;
 }
 
@@ -12,14 +12,95 @@
 
 #include "buffer/buffer_pool_manager.h"
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <system_error>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 
+#include "common/exception.h"
+#include "fmt/format.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
+/** Counts the pages read from disk, i.e. the misses of the buffer pool. */
+class ReadCountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    read_cnt_++;
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<size_t> read_cnt_{0};
+};
+
+/** Fails every read of one page, like a page that does not match its checksum. */
+class CorruptPageDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  explicit CorruptPageDiskManager(page_id_t corrupt_page_id) : corrupt_page_id_(corrupt_page_id) {}
+
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (page_id == corrupt_page_id_) {
+      throw Exception(ExceptionType::CORRUPTION, "corrupt page", false);
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+ private:
+  page_id_t corrupt_page_id_;
+};
+
+/** Counts the batched writes issued to the disk. */
+class WriteCountingDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePages(page_id_t start_page_id, size_t page_count, const char *page_data) override {
+    write_pages_cnt_++;
+    DiskManagerUnlimitedMemory::WritePages(start_page_id, page_count, page_data);
+  }
+
+  std::atomic<size_t> write_pages_cnt_{0};
+};
+
+/** Fails all writes while fail_writes_ is set, like a full disk, and Submit() itself while fail_submits_ is set. */
+class FailingWriteDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (fail_writes_) {
+      throw Exception("no space left on device");
+    }
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  void Submit(std::vector<DiskRequest> requests) override {
+    if (fail_submits_) {
+      throw Exception("can't submit requests");
+    }
+    DiskManagerUnlimitedMemory::Submit(std::move(requests));
+  }
+
+  std::atomic<bool> fail_writes_{false};
+  std::atomic<bool> fail_submits_{false};
+};
+
+/** Fails reads with a std::system_error, as an I/O backend does, while fail_reads_ is set. */
+class SystemErrorDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void ReadPage(page_id_t page_id, char *page_data) override {
+    if (fail_reads_) {
+      throw std::system_error(EIO, std::generic_category(), "read failed");
+    }
+    DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<bool> fail_reads_{false};
+};
+
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(BufferPoolManagerTest, BinaryDataTest) {
@@ -144,4 +225,703 @@ TEST(BufferPoolManagerTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, PageReuseTest) {
+  const size_t buffer_pool_size = 4;
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  for (page_id_t i = 0; i < 8; i++) {
+    auto page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: deleted pages are reused, whether they are resident or have been evicted.
+  EXPECT_TRUE(bpm->DeletePage(1));
+  EXPECT_TRUE(bpm->DeletePage(7));
+  EXPECT_TRUE(bpm->DeletePage(3));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(1, page_id);
+  // A reused page starts out zeroed, not with the content of the page that was deleted.
+  auto page = bpm->FetchPage(1);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(3, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(7, page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // Scenario: a failed NewPage gives its page id back.
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    pinned.push_back(page_id);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(12, disk_manager->GetPageCount());
+  for (auto pinned_page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(pinned_page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerTest, ShardedTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t num_shards = 3;
+  const size_t k = 5;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+  EXPECT_EQ(num_shards, bpm->GetNumShards());
+
+  // Scenario: page ids are spread over the shards, so the whole pool can be filled.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(static_cast<page_id_t>(i), page_id_temp);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+  }
+
+  // Scenario: every frame is pinned, so neither new pages nor misses can be served.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+
+  // Scenario: a failed NewPage must not burn page ids.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_TRUE(bpm->UnpinPage(i, true));
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(static_cast<page_id_t>(buffer_pool_size), page_id_temp);
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: pages evicted from any shard can be read back.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (size_t round = 0; round < 100; ++round) {
+        for (size_t i = tid; i < buffer_pool_size; i += 4) {
+          auto *page = bpm->FetchPage(i);
+          if (page == nullptr) {
+            continue;
+          }
+          page->RLatch();
+          EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+          page->RUnlatch();
+          EXPECT_TRUE(bpm->UnpinPage(i, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(BufferPoolManagerTest, IoOutsideLatchTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+  const uint64_t latency_ms = 500;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Page 0 stays resident, page 1 is evicted by page 2, and page 2 is left dirty in the pool.
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+  ASSERT_NE(nullptr, page0);
+  for (page_id_t page_id = 1; page_id <= 2; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    ASSERT_EQ(page_id, page_id_temp);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  disk_manager->SetLatency(latency_ms);
+
+  // Scenario: fetching page 1 writes back page 2 and reads page 1, each taking latency_ms. Readers of either page must
+  // wait for the I/O and see the right contents.
+  std::vector<std::thread> threads;
+  for (page_id_t page_id : {1, 1, 2}) {
+    threads.emplace_back([&bpm, page_id] {
+      Page *page = nullptr;
+      while (page == nullptr) {
+        page = bpm->FetchPage(page_id);
+      }
+      EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+
+  // Scenario: meanwhile, a resident page is served without waiting for the disk.
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(page0, bpm->FetchPage(0));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(latency_ms / 2));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(BufferPoolManagerTest, FlushOutsideLatchTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+  const uint64_t latency_ms = 500;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 2; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  disk_manager->SetLatency(latency_ms);
+
+  // Scenario: while page 1 is being flushed, page 0 is served without waiting for the disk.
+  std::thread flusher([&bpm] { EXPECT_TRUE(bpm->FlushPage(1)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_NE(nullptr, bpm->FetchPage(0));
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  EXPECT_LT(elapsed, std::chrono::milliseconds(latency_ms / 2));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+
+  // Scenario: deleting the page waits for the flush instead of failing on its pin.
+  EXPECT_TRUE(bpm->DeletePage(1));
+  flusher.join();
+  EXPECT_FALSE(bpm->IsPageResident(1));
+}
+
+TEST(BufferPoolManagerTest, ScanResistanceTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<ReadCountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 16; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: pages 0 and 1 are the working set of point lookups.
+  for (page_id_t page_id : {0, 1, 0, 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Get));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false, AccessType::Get));
+  }
+
+  // Scenario: a scan over all pages only recycles its own frames.
+  for (page_id_t page_id = 0; page_id < 16; ++page_id) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Scan));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false, AccessType::Scan));
+  }
+  size_t read_cnt = disk_manager->read_cnt_;
+  for (page_id_t page_id : {0, 1}) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, AccessType::Get));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false, AccessType::Get));
+  }
+  EXPECT_EQ(read_cnt, disk_manager->read_cnt_);
+}
+
+TEST(BufferPoolManagerTest, PrefetchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<ReadCountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Pages 0-3 are written back and evicted by pages 4-7.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_FALSE(bpm->IsPageResident(0));
+  EXPECT_TRUE(bpm->IsPageResident(7));
+
+  // Scenario: prefetched pages become resident without being pinned.
+  bpm->Prefetch({0, 1, 2});
+  for (size_t i = 0; i < 1000 && !(bpm->IsPageResident(0) && bpm->IsPageResident(1) && bpm->IsPageResident(2)); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  for (page_id_t page_id : {0, 1, 2}) {
+    ASSERT_TRUE(bpm->IsPageResident(page_id));
+    EXPECT_FALSE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(3, disk_manager->read_cnt_);
+
+  // Scenario: fetching them is served from memory, and prefetching resident pages does nothing.
+  bpm->Prefetch({0, 1, 2});
+  for (page_id_t page_id : {0, 1, 2}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(3, disk_manager->read_cnt_);
+}
+
+TEST(BufferPoolManagerTest, PrefetchSystemErrorTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<SystemErrorDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 2 * buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: a failed prefetch read of a non-Exception error leaves no frame in-flight.
+  disk_manager->fail_reads_ = true;
+  bpm->Prefetch({0});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(bpm->IsPageResident(0));
+
+  // Scenario: the prefetch thread survives it and prefetches again once the disk works.
+  disk_manager->fail_reads_ = false;
+  bpm->Prefetch({0});
+  for (size_t i = 0; i < 1000 && !bpm->IsPageResident(0); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  ASSERT_TRUE(bpm->IsPageResident(0));
+  auto *page = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "page 0"));
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlusherTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<WriteCountingDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+  }
+  // Page 3 stays pinned, so only pages 0-2 can be cleaned.
+  for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: the flusher writes the adjacent dirty pages with a single batched write.
+  bpm->StartBackgroundFlusher(1.0, std::chrono::milliseconds(1));
+  for (size_t i = 0; i < 1000 && bpm->GetBackgroundWriteCount() < 3; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  bpm->StopBackgroundFlusher();
+  EXPECT_EQ(3, bpm->GetBackgroundWriteCount());
+  EXPECT_EQ(1, disk_manager->write_pages_cnt_);
+
+  // Scenario: the cleaned frames are reused without a foreground write, and their content made it to disk.
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWriteCount());
+  for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_TRUE(bpm->UnpinPage(3, true));
+}
+
+TEST(BufferPoolManagerTest, BackgroundFlusherErrorTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<FailingWriteDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %zu", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: the flusher's writes fail. The pages stay dirty, and the flusher keeps running.
+  disk_manager->fail_writes_ = true;
+  bpm->StartBackgroundFlusher(1.0, std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  bpm->StopBackgroundFlusher();
+  EXPECT_EQ(0, bpm->GetBackgroundWriteCount());
+  disk_manager->fail_writes_ = false;
+
+  // Scenario: Submit() itself throws. The flusher survives it and leaves the pages dirty as well.
+  disk_manager->fail_submits_ = true;
+  bpm->StartBackgroundFlusher(1.0, std::chrono::milliseconds(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  bpm->StopBackgroundFlusher();
+  EXPECT_EQ(0, bpm->GetBackgroundWriteCount());
+  disk_manager->fail_submits_ = false;
+
+  // Scenario: the frames were unpinned, and eviction writes the pages back.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(buffer_pool_size, bpm->GetForegroundWriteCount());
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(buffer_pool_size); ++page_id) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+}
+
+TEST(BufferPoolManagerTest, WriteBackErrorTest) {
+  const size_t buffer_pool_size = 1;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<FailingWriteDiskManager>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Page 0 is on disk, page 1 is dirty in the only frame.
+  page_id_t page_id_temp;
+  for (page_id_t page_id = 0; page_id < 2; ++page_id) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  disk_manager->fail_writes_ = true;
+
+  // Scenario: page 1 can't be written back. The fetch of page 0 fails, and page 1 stays in its frame, still dirty.
+  EXPECT_THROW(bpm->FetchPage(0), Exception);
+  auto *page1 = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page1);
+  EXPECT_EQ(0, strcmp(page1->GetData(), "page 1"));
+  EXPECT_TRUE(page1->IsDirty());
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+
+  // Scenario: the same for a new page, which does not use up a page id either.
+  EXPECT_THROW(bpm->NewPage(&page_id_temp), Exception);
+  EXPECT_EQ(2, disk_manager->GetPageCount());
+  EXPECT_TRUE(bpm->IsPageResident(1));
+
+  // Scenario: and for a prefetch.
+  bpm->Prefetch({0});
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_TRUE(bpm->IsPageResident(1));
+  EXPECT_FALSE(bpm->IsPageResident(0));
+
+  // Scenario: once the disk works again, both pages come back with their latest contents.
+  disk_manager->fail_writes_ = false;
+  for (page_id_t page_id : {0, 1}) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+}
+
+TEST(BufferPoolManagerTest, CorruptPageTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<CorruptPageDiskManager>(0);
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+
+  // Scenario: reading the corrupt page throws, and its frame goes back to the free list.
+  EXPECT_THROW(bpm->FetchPage(0), Exception);
+  EXPECT_FALSE(bpm->IsPageResident(0));
+  ASSERT_NE(nullptr, bpm->FetchPage(1));
+  ASSERT_NE(nullptr, bpm->FetchPage(2));
+  EXPECT_TRUE(bpm->UnpinPage(1, false));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+
+  // Scenario: a failed prefetch is dropped without leaking a frame either.
+  bpm->Prefetch({0});
+  bool both_fetched = false;
+  for (size_t i = 0; i < 100 && !both_fetched; ++i) {
+    auto *page1 = bpm->FetchPage(1);
+    auto *page2 = bpm->FetchPage(2);
+    both_fetched = page1 != nullptr && page2 != nullptr;
+    if (page1 != nullptr) {
+      EXPECT_TRUE(bpm->UnpinPage(1, false));
+    }
+    if (page2 != nullptr) {
+      EXPECT_TRUE(bpm->UnpinPage(2, false));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  EXPECT_TRUE(both_fetched);
+  EXPECT_FALSE(bpm->IsPageResident(0));
+}
+
+TEST(BufferPoolManagerTest, LatchFreeUnpinTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t num_shards = 2;
+  const size_t k = 2;
+  const size_t num_pages = 16;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, num_shards);
+
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < num_pages; ++i) {
+    auto guard = bpm->NewPageGuarded(&page_id_temp);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "0");
+  }
+
+  // Scenario: a frame whose guard was dropped can be evicted right away, and its dirty page is written back.
+  std::vector<page_id_t> page_ids;
+  std::vector<BasicPageGuard> guards;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    guards.push_back(bpm->NewPageGuarded(&page_id_temp));
+    page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  snprintf(guards[0].GetDataMut(), BUSTUB_PAGE_SIZE, "dirty");
+  guards.clear();
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  EXPECT_STREQ("dirty", bpm->FetchPageRead(page_ids[0]).GetData());
+
+  // Scenario: concurrent readers and writers drop their pins without the shard latch while pages keep being evicted.
+  // Each thread pins one page at a time, so a shard always has an unpinned frame.
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (size_t round = 0; round < 200; ++round) {
+        auto page_id = static_cast<page_id_t>((round * 7 + tid) % num_pages);
+        if (tid % 2 == 0) {
+          auto guard = bpm->FetchPageWrite(page_id);
+          snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "%d", atoi(guard.GetData()) + 1);
+        } else {
+          auto guard = bpm->FetchPageRead(page_id);
+          EXPECT_GE(atoi(guard.GetData()), 0);
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int total = 0;
+  for (size_t i = 0; i < num_pages; ++i) {
+    auto guard = bpm->FetchPageRead(i);
+    total += atoi(guard.GetData());
+  }
+  EXPECT_EQ(2 * 200, total);
+
+  // Scenario: hits pin their frames without the shard latch while other threads keep reusing the frames. A hit must
+  // never be handed a frame that already holds another page.
+  for (size_t i = 0; i < num_pages; ++i) {
+    auto guard = bpm->FetchPageWrite(i);
+    snprintf(guard.GetDataMut(), BUSTUB_PAGE_SIZE, "%zu", i);
+  }
+  threads.clear();
+  for (size_t tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&bpm, tid] {
+      for (size_t round = 0; round < 500; ++round) {
+        if (tid == 0) {
+          page_id_t page_id;
+          auto guard = bpm->NewPageGuarded(&page_id);
+          guard.Drop();
+          bpm->DeletePage(page_id);
+          continue;
+        }
+        auto page_id = static_cast<page_id_t>((round * 3 + tid) % num_pages);
+        auto guard = bpm->FetchPageRead(page_id);
+        EXPECT_EQ(page_id, atoi(guard.GetData()));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  // Scenario: page 0 and page 1 fill the pool, page 2 evicts the dirty page 0.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  // Scenario: a scan hits page 2, a lookup misses page 0 and evicts the dirty page 1.
+  ASSERT_NE(nullptr, bpm->FetchPage(2, AccessType::Scan));
+  ASSERT_NE(nullptr, bpm->FetchPage(0, AccessType::Get));
+  // Scenario: with both frames pinned, neither a new page nor a miss can be served.
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(1, AccessType::Get));
+
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(3, stats.new_pages_);
+  EXPECT_EQ(1, stats.new_page_failures_);
+  EXPECT_EQ(2, stats.evictions_);
+  EXPECT_EQ(2, stats.foreground_writes_);
+  EXPECT_EQ(1, stats.Access(AccessType::Scan).hits_);
+  EXPECT_EQ(0, stats.Access(AccessType::Scan).misses_);
+  const auto &get_stats = stats.Access(AccessType::Get);
+  EXPECT_EQ(0, get_stats.hits_);
+  EXPECT_EQ(1, get_stats.misses_);
+  EXPECT_EQ(1, get_stats.evictions_);
+  EXPECT_EQ(1, get_stats.write_backs_);
+  EXPECT_EQ(1, get_stats.failures_);
+  EXPECT_EQ(1, get_stats.miss_latency_.Count());
+  EXPECT_DOUBLE_EQ(0.5, stats.AllAccesses().HitRatio());
+
+  // Scenario: percentiles report the upper bound of the bucket they fall into.
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.Percentile(50));
+  for (int i = 0; i < 98; ++i) {
+    histogram.Record(std::chrono::microseconds(3));
+  }
+  histogram.Record(std::chrono::milliseconds(1));
+  histogram.Record(std::chrono::hours(1));
+  EXPECT_EQ(4, histogram.Percentile(50));
+  EXPECT_EQ(1024, histogram.Percentile(99));
+  EXPECT_EQ(LatencyHistogram::BucketUpperBound(LatencyHistogram::NUM_BUCKETS - 1), histogram.Percentile(100));
+}
+
+TEST(BufferPoolManagerTest, SecondTierTest) {
+  const size_t buffer_pool_size = 2;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_unique<ReadCountingDiskManager>();
+  auto bpm =
+      std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 1, 1024 * 1024);
+
+  // Scenario: pages 0 and 1 are evicted by pages 2 and 3 and go to the second tier.
+  page_id_t page_id_temp;
+  for (size_t i = 0; i < 4; ++i) {
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+  }
+  EXPECT_EQ(2, bpm->GetStats().second_tier_.pages_);
+
+  // Scenario: fetching them again does not touch the disk, and each fetch moves its victim to the second tier.
+  for (page_id_t page_id : {0, 1}) {
+    auto *page = bpm->FetchPage(page_id, AccessType::Get);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(fmt::format("page {}", page_id), page->GetData());
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, disk_manager->read_cnt_);
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(2, stats.Access(AccessType::Get).misses_);
+  EXPECT_EQ(2, stats.Access(AccessType::Get).second_tier_hits_);
+  EXPECT_EQ(2, stats.second_tier_.hits_);
+  EXPECT_EQ(2, stats.second_tier_.pages_);
+
+  // Scenario: a deleted page is dropped from the second tier, so that its id can be reused.
+  EXPECT_TRUE(bpm->DeletePage(2));
+  EXPECT_EQ(1, bpm->GetStats().second_tier_.pages_);
+  auto *page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_STREQ("page 3", page->GetData());
+  EXPECT_TRUE(bpm->UnpinPage(3, false));
+  EXPECT_EQ(0, disk_manager->read_cnt_);
+
+  // Scenario: the cache stays within its budget by dropping the oldest pages, and does not store incompressible ones.
+  const size_t budget = 256;
+  CompressedPageCache cache(budget);
+  std::vector<char> data(BUSTUB_PAGE_SIZE);
+  for (page_id_t page_id = 0; page_id < 100; ++page_id) {
+    snprintf(data.data(), data.size(), "page %d", page_id);
+    cache.Insert(page_id, data.data());
+  }
+  auto cache_stats = cache.GetStats();
+  EXPECT_LE(cache_stats.used_bytes_, budget);
+  EXPECT_EQ(100, cache_stats.inserts_);
+  EXPECT_EQ(100 - cache_stats.pages_, cache_stats.evictions_);
+  EXPECT_FALSE(cache.Take(0, data.data()));
+  EXPECT_TRUE(cache.Take(99, data.data()));
+  EXPECT_STREQ("page 99", data.data());
+  EXPECT_FALSE(cache.Take(99, data.data()));
+
+  std::mt19937 gen(0);
+  for (auto &ch : data) {
+    ch = static_cast<char>(gen());
+  }
+  cache.Insert(200, data.data());
+  EXPECT_EQ(1, cache.GetStats().rejects_);
+  EXPECT_FALSE(cache.Take(200, data.data()));
+}
+
+TEST(BufferPoolManagerTest, NumaPartitionTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  NumaUtil::SimulateNodes(2);
+  EXPECT_EQ(2, NumaUtil::NodeCount());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 2, 0,
+                                                 NumaMode::Partition);
+  // Each shard splits its 4 frames into 2 per node.
+  for (frame_id_t frame_id = 0; frame_id < static_cast<frame_id_t>(buffer_pool_size); ++frame_id) {
+    EXPECT_EQ(frame_id % 4 / 2, bpm->GetFrameNode(frame_id));
+  }
+
+  // Scenario: a thread on node 1 gets the frames of node 1 as long as there are free ones, then those of node 0.
+  std::vector<size_t> frame_nodes;
+  std::thread worker([&bpm, &frame_nodes] {
+    EXPECT_EQ(1, NumaUtil::PinThread(1));
+    EXPECT_EQ(1, NumaUtil::CurrentNode());
+    page_id_t page_id_temp;
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      frame_nodes.push_back(bpm->GetFrameNode(static_cast<frame_id_t>(page - bpm->GetPages())));
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+  });
+  worker.join();
+  EXPECT_EQ((std::vector<size_t>{1, 1, 1, 1, 0, 0, 0, 0}), frame_nodes);
+  auto stats = bpm->GetStats();
+  EXPECT_EQ(4, stats.local_frames_);
+  EXPECT_EQ(4, stats.remote_frames_);
+
+  // Scenario: without partitions, every frame belongs to node 0.
+  bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k, nullptr, 2, 0,
+                                            NumaMode::Interleave);
+  EXPECT_EQ(0, bpm->GetFrameNode(3));
+  NumaUtil::SimulateNodes(0);
+}
+
 }  // namespace bustub
@@ -0,0 +1,72 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "buffer/buffer_pool_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, FrameTest) {
+  // Small arenas use regular pages, arenas of 2 MB and more huge pages if there are any.
+  for (size_t frame_cnt : {size_t{1}, size_t{10}, 2 * FrameArena::HUGE_PAGE_SIZE / BUSTUB_PAGE_SIZE + 1}) {
+    FrameArena arena(frame_cnt);
+    char zeros[BUSTUB_PAGE_SIZE] = {0};
+    for (size_t i = 0; i < frame_cnt; i++) {
+      char *frame = arena.GetFrame(i);
+      // Frames start out zeroed, are aligned for direct I/O, and do not overlap.
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(frame) % BUSTUB_PAGE_SIZE);
+      EXPECT_EQ(0, memcmp(frame, zeros, BUSTUB_PAGE_SIZE));
+      memset(frame, static_cast<int>(i % 128) + 1, BUSTUB_PAGE_SIZE);
+      if (i > 0) {
+        EXPECT_GE(frame - arena.GetFrame(i - 1), BUSTUB_PAGE_SIZE);
+        EXPECT_EQ(static_cast<char>((i - 1) % 128 + 1), arena.GetFrame(i - 1)[BUSTUB_PAGE_SIZE - 1]);
+      }
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(FrameArenaTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 16;
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(buffer_pool_size, disk_manager.get(), 2);
+
+  // The pages of the buffer pool take their data from one arena, in frame order.
+  auto *pages = bpm->GetPages();
+  for (size_t i = 1; i < buffer_pool_size; i++) {
+    EXPECT_GE(pages[i].GetData() - pages[i - 1].GetData(), BUSTUB_PAGE_SIZE);
+  }
+  page_id_t page_id;
+  for (size_t i = 0; i < 2 * buffer_pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * buffer_pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+}
+
+}  // namespace bustub
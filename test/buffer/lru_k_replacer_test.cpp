@@ -95,4 +95,135 @@ TEST(LRUKReplacerTest, SampleTest) {
   ASSERT_EQ(false, lru_replacer.Evict(&value));
   ASSERT_EQ(0, lru_replacer.Size());
 }
+TEST(LRUKReplacerTest, InvalidFrameTest) {
+  LRUKReplacer lru_replacer(7, 2);
+  EXPECT_THROW(lru_replacer.RecordAccess(7), std::logic_error);
+  EXPECT_THROW(lru_replacer.RecordAccess(-1), std::logic_error);
+  EXPECT_THROW(lru_replacer.SetEvictable(7, true), std::logic_error);
+  EXPECT_THROW(lru_replacer.Remove(7), std::logic_error);
+
+  // Removing a frame that is tracked but pinned is an error, removing an untracked frame is not.
+  lru_replacer.RecordAccess(0);
+  EXPECT_THROW(lru_replacer.Remove(0), std::logic_error);
+  lru_replacer.Remove(1);
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+
+TEST(LRUKReplacerTest, RandomizedTest) {
+  const size_t num_frames = 64;
+  const size_t k = 3;
+  LRUKReplacer lru_replacer(num_frames, k);
+
+  // Reference model: the full access history of every tracked frame, and whether it is evictable.
+  std::vector<std::vector<size_t>> history(num_frames);
+  std::vector<bool> evictable(num_frames, false);
+  size_t timestamp = 0;
+
+  auto expected_victim = [&]() -> frame_id_t {
+    frame_id_t victim = -1;
+    bool victim_inf = false;
+    size_t victim_ts = 0;
+    for (size_t i = 0; i < num_frames; i++) {
+      if (history[i].empty() || !evictable[i]) {
+        continue;
+      }
+      bool inf = history[i].size() < k;
+      size_t ts = inf ? history[i].front() : history[i][history[i].size() - k];
+      if (victim == -1 || (inf && !victim_inf) || (inf == victim_inf && ts < victim_ts)) {
+        victim = static_cast<frame_id_t>(i);
+        victim_inf = inf;
+        victim_ts = ts;
+      }
+    }
+    return victim;
+  };
+
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<frame_id_t> frame_dist(0, num_frames - 1);
+  std::uniform_int_distribution<int> op_dist(0, 9);
+  for (size_t round = 0; round < 20000; round++) {
+    frame_id_t frame_id = frame_dist(gen);
+    int op = op_dist(gen);
+    if (op < 5) {
+      lru_replacer.RecordAccess(frame_id);
+      history[frame_id].push_back(++timestamp);
+    } else if (op < 8) {
+      bool set_evictable = op == 5 || op == 6;
+      lru_replacer.SetEvictable(frame_id, set_evictable);
+      if (!history[frame_id].empty()) {
+        evictable[frame_id] = set_evictable;
+      }
+    } else if (op == 8) {
+      frame_id_t expected = expected_victim();
+      frame_id_t victim;
+      ASSERT_EQ(expected != -1, lru_replacer.Evict(&victim));
+      if (expected != -1) {
+        ASSERT_EQ(expected, victim);
+        history[victim].clear();
+        evictable[victim] = false;
+      }
+    } else if (!history[frame_id].empty() && evictable[frame_id]) {
+      lru_replacer.Remove(frame_id);
+      history[frame_id].clear();
+      evictable[frame_id] = false;
+    }
+    ASSERT_EQ(static_cast<size_t>(std::count(evictable.begin(), evictable.end(), true)), lru_replacer.Size());
+  }
+}
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  LRUKReplacer lru_replacer(8, 2);
+
+  // Scenario: frames 0-3 hold the working set of point lookups, frames 4-7 are filled by a scan.
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    lru_replacer.RecordAccess(frame_id, AccessType::Get);
+    lru_replacer.RecordAccess(frame_id, AccessType::Get);
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+  for (frame_id_t frame_id = 4; frame_id < 8; frame_id++) {
+    lru_replacer.RecordAccess(frame_id, AccessType::Scan);
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+  ASSERT_EQ(8, lru_replacer.Size());
+
+  // Scenario: a scan touching the working set does not change its order, and scanning frame 4 again makes it the most
+  // recently used scan frame. Frame 7 gets a point lookup and leaves the scan class, with a fresh history.
+  lru_replacer.RecordAccess(0, AccessType::Scan);
+  lru_replacer.RecordAccess(4, AccessType::Scan);
+  lru_replacer.RecordAccess(7, AccessType::Get);
+
+  // Scan frames go first, least recently used first, then frame 7 which has less than k accesses, then the rest.
+  std::vector<frame_id_t> expected{5, 6, 4, 7, 0, 1, 2, 3};
+  ASSERT_EQ(std::vector<frame_id_t>(expected.begin(), expected.begin() + 3), lru_replacer.EvictionCandidates(3));
+  ASSERT_EQ(expected, lru_replacer.EvictionCandidates(100));
+  ASSERT_EQ(8, lru_replacer.Size());
+  for (auto expected_frame_id : expected) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+    ASSERT_EQ(expected_frame_id, frame_id);
+  }
+  ASSERT_EQ(0, lru_replacer.Size());
+}
+TEST(LRUKReplacerTest, PrefetchTest) {
+  LRUKReplacer lru_replacer(4, 2);
+
+  // Scenario: frame 0 was consumed by a scan, frames 1 and 2 were prefetched after it, frame 3 is read by a lookup.
+  lru_replacer.RecordAccess(0, AccessType::Scan);
+  lru_replacer.RecordPrefetch(1);
+  lru_replacer.RecordPrefetch(2);
+  lru_replacer.RecordAccess(3, AccessType::Get);
+  EXPECT_THROW(lru_replacer.RecordPrefetch(3), std::logic_error);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    lru_replacer.SetEvictable(frame_id, true);
+  }
+
+  // Scenario: the scan reaches frame 2, which becomes a scan-only frame. The unused prefetched frame 1 is kept like a
+  // frame with a single access.
+  lru_replacer.RecordAccess(2, AccessType::Scan);
+  std::vector<frame_id_t> expected{0, 2, 1, 3};
+  for (auto expected_frame_id : expected) {
+    frame_id_t frame_id;
+    ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+    ASSERT_EQ(expected_frame_id, frame_id);
+  }
+}
 }  // namespace bustub
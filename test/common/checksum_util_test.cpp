@@ -0,0 +1,51 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util_test.cpp
+//
+// Identification: test/common/checksum_util_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/checksum_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ChecksumUtilTest, Crc32cTest) {
+  // Check values from RFC 3720, appendix B.4.
+  std::string check("123456789");
+  EXPECT_EQ(0xE3069283, ChecksumUtil::Crc32c(check.data(), check.size()));
+  EXPECT_EQ(0xE3069283, ChecksumUtil::Crc32cSoftware(check.data(), check.size()));
+  std::vector<char> zeros(32, 0);
+  EXPECT_EQ(0x8A9136AA, ChecksumUtil::Crc32c(zeros.data(), zeros.size()));
+  std::vector<char> ones(32, static_cast<char>(0xFF));
+  EXPECT_EQ(0x62A8AB43, ChecksumUtil::Crc32c(ones.data(), ones.size()));
+  EXPECT_EQ(0, ChecksumUtil::Crc32c(nullptr, 0));
+
+  // The hardware and the table-driven implementation agree, on any length and alignment, also when chained.
+  std::mt19937 gen(42);
+  std::vector<char> data(1000);
+  for (auto &ch : data) {
+    ch = static_cast<char>(gen());
+  }
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t size = 0; offset + size <= data.size(); size += 37) {
+      auto crc = ChecksumUtil::Crc32c(data.data() + offset, size);
+      ASSERT_EQ(ChecksumUtil::Crc32cSoftware(data.data() + offset, size), crc);
+      auto half = size / 2;
+      ASSERT_EQ(crc, ChecksumUtil::Crc32c(data.data() + offset + half, size - half,
+                                          ChecksumUtil::Crc32c(data.data() + offset, half)));
+    }
+  }
+}
+
+}  // namespace bustub
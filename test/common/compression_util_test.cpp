@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util_test.cpp
+//
+// Identification: test/common/compression_util_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/util/compression_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(CompressionUtilTest, Lz4RoundTripTest) {
+  std::mt19937 gen(42);
+  std::vector<std::vector<char>> inputs;
+  inputs.emplace_back();
+  inputs.emplace_back(7, 'a');
+  inputs.emplace_back(4096, 0);
+  // A page with a few records followed by free space, like a table page.
+  std::vector<char> page(4096, 0);
+  for (size_t i = 0; i < 1000; i++) {
+    page[i] = "record "[i % 7];
+  }
+  inputs.push_back(page);
+  // Repetitions with long literal runs in between, to exercise the length continuation bytes.
+  std::vector<char> mixed;
+  for (size_t i = 0; i < 70000; i++) {
+    mixed.push_back(i % 1000 < 600 ? static_cast<char>(gen()) : static_cast<char>(i % 3));
+  }
+  inputs.push_back(mixed);
+  std::vector<char> random(4096);
+  for (auto &ch : random) {
+    ch = static_cast<char>(gen());
+  }
+  inputs.push_back(random);
+
+  for (const auto &input : inputs) {
+    std::vector<char> compressed(input.size() + input.size() / 255 + 16);
+    size_t compressed_size = CompressionUtil::Lz4Compress(input.data(), input.size(), compressed.data(),
+                                                         compressed.size());
+    ASSERT_GT(compressed_size, 0);
+    std::vector<char> output(input.size());
+    ASSERT_TRUE(CompressionUtil::Lz4Decompress(compressed.data(), compressed_size, output.data(), output.size()));
+    EXPECT_EQ(input, output);
+    // The output size must be exactly right.
+    if (!input.empty()) {
+      EXPECT_FALSE(
+          CompressionUtil::Lz4Decompress(compressed.data(), compressed_size, output.data(), output.size() - 1));
+    }
+  }
+
+  // Redundant data compresses well, random data does not fit into less than its own size.
+  std::vector<char> compressed(4096);
+  EXPECT_LT(CompressionUtil::Lz4Compress(inputs[2].data(), 4096, compressed.data(), compressed.size()), 64);
+  EXPECT_LT(CompressionUtil::Lz4Compress(page.data(), 4096, compressed.data(), compressed.size()), 128);
+  EXPECT_EQ(0, CompressionUtil::Lz4Compress(random.data(), 4096, compressed.data(), 4000));
+
+  // Truncated or corrupted input is rejected instead of read past its end.
+  size_t size = CompressionUtil::Lz4Compress(page.data(), 4096, compressed.data(), compressed.size());
+  std::vector<char> output(4096);
+  for (size_t truncated = 0; truncated < size; truncated++) {
+    EXPECT_FALSE(CompressionUtil::Lz4Decompress(compressed.data(), truncated, output.data(), output.size()));
+  }
+  compressed[0] = static_cast<char>(0x0F);
+  compressed[1] = static_cast<char>(0xFF);
+  compressed[2] = static_cast<char>(0xFF);
+  EXPECT_FALSE(CompressionUtil::Lz4Decompress(compressed.data(), size, output.data(), output.size()));
+}
+
+}  // namespace bustub
@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 #include <vector>
 
+#include "common/hybrid_latch.h"
 #include "common/rwlatch.h"
 #include "gtest/gtest.h"
 
@@ -57,4 +60,65 @@ TEST(RWLatchTest, BasicTest) {
   }
   EXPECT_EQ(counter.Read(), 55);
 }
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, HybridLatchTest) {
+  for (bool prefer_writers : {false, true}) {
+    HybridLatch latch(prefer_writers);
+    int count = 0;
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < 8; tid++) {
+      threads.emplace_back([&, tid]() {
+        for (int i = 0; i < 1000; i++) {
+          if (tid % 2 == 0) {
+            latch.RLock();
+            EXPECT_GE(count, 0);
+            latch.RUnlock();
+          } else {
+            latch.WLock();
+            count++;
+            latch.WUnlock();
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    EXPECT_EQ(count, 4000);
+    EXPECT_EQ(latch.GetStats().acquisitions_, 8000);
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(RWLatchTest, HybridLatchWriterPreferenceTest) {
+  for (bool prefer_writers : {false, true}) {
+    HybridLatch latch(prefer_writers);
+    std::atomic<bool> writer_done{false};
+    std::atomic<bool> reader_done{false};
+    latch.RLock();
+    std::thread writer([&]() {
+      latch.WLock();
+      writer_done = true;
+      latch.WUnlock();
+    });
+    // Long enough for the writer to give up spinning and park.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::thread reader([&]() {
+      latch.RLock();
+      reader_done = true;
+      latch.RUnlock();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    // Only a preferred writer keeps the second reader out while the first one still holds the latch.
+    EXPECT_EQ(reader_done.load(), !prefer_writers);
+    EXPECT_FALSE(writer_done.load());
+    latch.RUnlock();
+    writer.join();
+    reader.join();
+    EXPECT_TRUE(writer_done.load());
+    EXPECT_GT(latch.GetStats().parks_, 0);
+  }
+}
+
 }  // namespace bustub
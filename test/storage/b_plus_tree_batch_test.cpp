@@ -0,0 +1,179 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_batch_test.cpp
+//
+// Identification: test/storage/b_plus_tree_batch_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+namespace {
+
+auto MakePairs(const std::vector<int64_t> &keys) -> std::vector<std::pair<GenericKey<8>, RID>> {
+  std::vector<std::pair<GenericKey<8>, RID>> pairs(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    pairs[i].first.SetFromInteger(keys[i]);
+    pairs[i].second.Set(static_cast<int32_t>(keys[i] >> 32), static_cast<int32_t>(keys[i] & 0xFFFFFFFF));
+  }
+  return pairs;
+}
+
+auto MakeKeys(const std::vector<int64_t> &keys) -> std::vector<GenericKey<8>> {
+  std::vector<GenericKey<8>> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromInteger(keys[i]);
+  }
+  return index_keys;
+}
+
+}  // namespace
+
+TEST(BPlusTreeBatchTest, InsertAndLookup) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 4, 3);
+
+  // Batches of sorted keys, the first one into the empty tree, and each spread over leaves that split in between.
+  std::vector<int64_t> keys(2000);
+  std::iota(keys.begin(), keys.end(), 1);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  size_t inserted = 0;
+  for (size_t begin = 0; begin < keys.size(); begin += 100) {
+    std::vector<int64_t> batch(keys.begin() + begin, keys.begin() + begin + 100);
+    std::sort(batch.begin(), batch.end());
+    inserted += tree.InsertBatch(MakePairs(batch));
+  }
+  EXPECT_EQ(inserted, keys.size());
+
+  // Keys that are already there are not inserted again.
+  EXPECT_EQ(tree.InsertBatch(MakePairs({0, 1, 1000, 2000, 2001})), 2);
+
+  std::vector<int64_t> lookup_keys(2100);
+  std::iota(lookup_keys.begin(), lookup_keys.end(), -50);
+  std::vector<std::optional<RID>> values;
+  EXPECT_EQ(tree.GetValues(MakeKeys(lookup_keys), &values), 2002);
+  ASSERT_EQ(values.size(), lookup_keys.size());
+  for (size_t i = 0; i < lookup_keys.size(); i++) {
+    ASSERT_EQ(values[i].has_value(), lookup_keys[i] >= 0 && lookup_keys[i] <= 2001);
+    if (values[i].has_value()) {
+      EXPECT_EQ(values[i]->GetSlotNum(), lookup_keys[i]);
+    }
+  }
+
+  // Unsorted keys are found as well, they only take more descents.
+  std::shuffle(lookup_keys.begin(), lookup_keys.end(), std::mt19937(15445));
+  EXPECT_EQ(tree.GetValues(MakeKeys(lookup_keys), &values), 2002);
+  for (size_t i = 0; i < lookup_keys.size(); i++) {
+    ASSERT_EQ(values[i].has_value(), lookup_keys[i] >= 0 && lookup_keys[i] <= 2001);
+  }
+
+  // The leaves still chain all the keys in order.
+  int64_t expected = 0;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    EXPECT_EQ((*iter).first.ToString(), expected++);
+  }
+  EXPECT_EQ(expected, 2002);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeBatchTest, EmptyTree) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 4, 3);
+
+  std::vector<std::optional<RID>> values;
+  EXPECT_EQ(tree.GetValues(MakeKeys({1, 2, 3}), &values), 0);
+  EXPECT_EQ(values.size(), 3);
+  EXPECT_EQ(tree.InsertBatch({}), 0);
+  EXPECT_TRUE(tree.IsEmpty());
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeBatchTest, ConcurrentBatches) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 4, 3);
+
+  // Batch writers and readers latch the same leaves and parents, next to single-key writers that split and merge them.
+  const int64_t total = 4000;
+  std::vector<std::thread> threads;
+  for (int64_t writer = 0; writer < 2; writer++) {
+    threads.emplace_back([&tree, writer] {
+      for (int64_t begin = writer; begin < total; begin += 200) {
+        std::vector<int64_t> batch;
+        for (int64_t key = begin; key < begin + 200; key += 2) {
+          batch.push_back(key);
+        }
+        tree.InsertBatch(MakePairs(batch));
+      }
+    });
+  }
+  threads.emplace_back([&tree] {
+    GenericKey<8> index_key;
+    RID rid;
+    for (int64_t key = total; key < total + 1000; key++) {
+      index_key.SetFromInteger(key);
+      tree.Insert(index_key, rid);
+    }
+    for (int64_t key = total; key < total + 1000; key++) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, nullptr);
+    }
+  });
+  threads.emplace_back([&tree] {
+    std::vector<int64_t> keys(total);
+    std::iota(keys.begin(), keys.end(), 0);
+    std::vector<std::optional<RID>> values;
+    for (int round = 0; round < 5; round++) {
+      tree.GetValues(MakeKeys(keys), &values);
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<int64_t> keys(total);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::vector<std::optional<RID>> values;
+  EXPECT_EQ(tree.GetValues(MakeKeys(keys), &values), total);
+  keys = {total, total + 500, total + 999};
+  EXPECT_EQ(tree.GetValues(MakeKeys(keys), &values), 0);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+}  // namespace bustub
@@ -0,0 +1,235 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_builder.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+using Tree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+using Builder = BPlusTreeBuilder<GenericKey<8>, RID, GenericComparator<8>>;
+using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+namespace {
+
+/**
+ * Checks that every page but the root is at least half full, collects the leaf sizes from left to right and counts the
+ * pages.
+ */
+void CheckPage(BufferPoolManager *bpm, page_id_t page_id, bool is_root, std::vector<int> *leaf_sizes, int *pages) {
+  (*pages)++;
+  auto guard = bpm->FetchPageRead(page_id);
+  auto page = guard.As<BPlusTreePage>();
+  if (!is_root) {
+    ASSERT_GE(page->GetSize(), page->GetMinSize());
+  }
+  if (page->IsLeafPage()) {
+    ASSERT_LT(page->GetSize(), page->GetMaxSize());
+    leaf_sizes->push_back(page->GetSize());
+    return;
+  }
+  auto internal = guard.As<InternalPage>();
+  ASSERT_LE(internal->GetSize(), internal->GetMaxSize());
+  for (int i = 0; i < internal->GetSize(); i++) {
+    CheckPage(bpm, internal->ValueAt(i), false, leaf_sizes, pages);
+  }
+}
+
+auto CheckTree(BufferPoolManager *bpm, Tree *tree, int *pages = nullptr) -> std::vector<int> {
+  std::vector<int> leaf_sizes;
+  int tree_pages = 0;
+  if (!tree->IsEmpty()) {
+    CheckPage(bpm, tree->GetRootPageId(), true, &leaf_sizes, &tree_pages);
+  }
+  if (pages != nullptr) {
+    *pages = tree_pages;
+  }
+  return leaf_sizes;
+}
+
+auto ScanKeys(Tree *tree) -> std::vector<int64_t> {
+  std::vector<int64_t> keys;
+  if (tree->IsEmpty()) {
+    return keys;
+  }
+  for (auto iter = tree->Begin(); !iter.IsEnd(); ++iter) {
+    keys.push_back((*iter).first.ToString());
+  }
+  return keys;
+}
+
+}  // namespace
+
+TEST(BPlusTreeBulkLoadTest, ExternalSort) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 5, 4);
+
+  std::vector<int64_t> keys(10000);
+  std::iota(keys.begin(), keys.end(), 1);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  {
+    // 100 runs take two merge passes.
+    Builder builder(&tree, 1.0, 100);
+    GenericKey<8> index_key;
+    RID rid;
+    for (auto key : keys) {
+      index_key.SetFromInteger(key);
+      rid.Set(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF));
+      builder.Add(index_key, rid);
+    }
+    EXPECT_EQ(builder.Finish(), keys.size());
+  }
+
+  std::sort(keys.begin(), keys.end());
+  EXPECT_EQ(ScanKeys(&tree), keys);
+  int pages;
+  auto leaf_sizes = CheckTree(bpm.get(), &tree, &pages);
+  EXPECT_EQ(leaf_sizes.size(), keys.size() / 4);
+  // All pages of the runs were given back, only the header and the tree are left.
+  EXPECT_EQ(disk_manager->GetPageCount() - disk_manager->GetFreePageCount(), pages + 1);
+
+  // The tree keeps working as usual afterwards.
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  for (auto key : keys) {
+    if (key % 2 == 0) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, nullptr);
+    }
+  }
+  RID rid;
+  index_key.SetFromInteger(20001);
+  EXPECT_TRUE(tree.Insert(index_key, rid));
+  CheckTree(bpm.get(), &tree);
+  EXPECT_EQ(ScanKeys(&tree).size(), keys.size() / 2 + 1);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeBulkLoadTest, PageSizes) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  // Every number of keys leaves a different remainder for the last pages of each level.
+  for (int64_t size = 0; size <= 80; size++) {
+    for (double fill_factor : {0.5, 1.0}) {
+      auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+      auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 5, 4);
+      Builder builder(&tree, fill_factor);
+      GenericKey<8> index_key;
+      RID rid;
+      std::vector<int64_t> keys;
+      for (int64_t key = size; key > 0; key--) {
+        index_key.SetFromInteger(key);
+        builder.Add(index_key, rid);
+        keys.insert(keys.begin(), key);
+      }
+      EXPECT_EQ(builder.Finish(), keys.size());
+      EXPECT_EQ(tree.IsEmpty(), size == 0);
+      EXPECT_EQ(ScanKeys(&tree), keys);
+
+      auto leaf_sizes = CheckTree(bpm.get(), &tree);
+      int fill = fill_factor == 1.0 ? 4 : 2;
+      for (size_t i = 0; i + 2 < leaf_sizes.size(); i++) {
+        EXPECT_EQ(leaf_sizes[i], fill);
+      }
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+    }
+  }
+}
+
+TEST(BPlusTreeBulkLoadTest, DuplicateKeys) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 5, 4);
+
+  Builder builder(&tree, 1.0, 7);
+  GenericKey<8> index_key;
+  RID rid;
+  // Each key comes three times, in different runs. The first one added wins.
+  for (int round = 0; round < 3; round++) {
+    for (int64_t key = 1; key <= 20; key++) {
+      index_key.SetFromInteger(key);
+      rid.Set(round, static_cast<uint32_t>(key));
+      builder.Add(index_key, rid);
+    }
+  }
+  EXPECT_EQ(builder.Finish(), 20);
+
+  std::vector<RID> rids;
+  for (int64_t key = 1; key <= 20; key++) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.GetValue(index_key, &rids));
+    EXPECT_EQ(rids[0].GetPageId(), 0);
+  }
+
+  // Only an empty tree can be bulk loaded.
+  Builder again(&tree);
+  again.Add(index_key, rid);
+  EXPECT_THROW(again.Finish(), Exception);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeBulkLoadTest, NullKeys) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  Tree tree("foo_pk", header_page->GetPageId(), bpm.get(), comparator, 5, 4);
+
+  // A NULL key compares equal to both of its neighbors, and must not keep them from being sorted.
+  Builder builder(&tree, 1.0, 7);
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key : {5, 3, 9, 1, 7}) {
+    index_key.SetFromInteger(key);
+    builder.Add(index_key, rid);
+    index_key.SetFromInteger(BUSTUB_INT64_NULL);
+    builder.Add(index_key, rid);
+  }
+  EXPECT_EQ(builder.Finish(), 5);
+  EXPECT_EQ(ScanKeys(&tree), (std::vector<int64_t>{1, 3, 5, 7, 9}));
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -402,4 +403,181 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest2) {
   delete bpm;
 }
 
+TEST(BPlusTreeConcurrentTest, OptimisticReadTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // small nodes, so that the writers keep splitting and merging the nodes the readers walk through
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 4);
+
+  // the even keys stay in the tree, the odd ones come and go
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> moving_keys;
+  for (int64_t key = 1; key <= 400; key++) {
+    (key % 2 == 0 ? stable_keys : moving_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::vector<std::thread> threads;
+  for (uint64_t i = 0; i < 2; i++) {
+    threads.emplace_back([&, i] {
+      for (int round = 0; round < 20; round++) {
+        InsertHelperSplit(&tree, moving_keys, 2, i);
+        DeleteHelperSplit(&tree, moving_keys, 2, i);
+      }
+    });
+  }
+  for (uint64_t i = 0; i < 2; i++) {
+    threads.emplace_back([&, i] {
+      for (int round = 0; round < 20; round++) {
+        LookupHelper(&tree, stable_keys, i);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<RID> rids;
+  GenericKey<8> index_key;
+  for (auto key : moving_keys) {
+    index_key.SetFromInteger(key);
+    EXPECT_FALSE(tree.GetValue(index_key, &rids));
+  }
+  LookupHelper(&tree, stable_keys, 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, OptimisticWriteTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // leaves large enough that most writes only latch the leaf, while the others still split and merge next to them
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 8, 5);
+
+  std::vector<int64_t> keys;
+  for (int64_t key = 1; key <= 4000; key++) {
+    keys.push_back(key);
+  }
+  std::vector<int64_t> remove_keys;
+  for (int64_t key = 1; key <= 4000; key += 3) {
+    remove_keys.push_back(key);
+  }
+  for (int round = 0; round < 3; round++) {
+    LaunchParallelTest(4, InsertHelperSplit, &tree, keys, 4);
+    LaunchParallelTest(4, DeleteHelperSplit, &tree, remove_keys, 4);
+  }
+
+  int64_t size = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    ASSERT_NE((*iter).first.ToString() % 3, 1);
+    size++;
+  }
+  EXPECT_EQ(size, keys.size() - remove_keys.size());
+  LaunchParallelTest(4, DeleteHelperSplit, &tree, keys, 4);
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
+TEST(BPlusTreeConcurrentTest, ScanWhileWritingTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  // the tree is deep with pages this small, and writers that merge pin the whole path and the siblings on it
+  auto *bpm = new BufferPoolManager(200, disk_manager.get());
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  // small pages, so that the writers keep splitting and merging the leaves the scans are on
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 4, 3);
+
+  // even keys stay in the tree for the whole test, odd keys come and go
+  const int64_t total = 2000;
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 0; key < total; key += 2) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<int>(key & 0xFFFFFFFF));
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> writers;
+  for (int64_t writer = 0; writer < 2; writer++) {
+    writers.emplace_back([&tree, writer, total] {
+      GenericKey<8> index_key;
+      RID rid;
+      for (int round = 0; round < 5; round++) {
+        for (int64_t key = 1 + writer * 2; key < total; key += 4) {
+          rid.Set(static_cast<int32_t>(key >> 32), static_cast<int>(key & 0xFFFFFFFF));
+          index_key.SetFromInteger(key);
+          tree.Insert(index_key, rid);
+        }
+        for (int64_t key = 1 + writer * 2; key < total; key += 4) {
+          index_key.SetFromInteger(key);
+          tree.Remove(index_key, nullptr);
+        }
+      }
+    });
+  }
+  std::vector<std::thread> scanners;
+  for (int reverse = 0; reverse < 2; reverse++) {
+    scanners.emplace_back([&tree, &done, reverse, total] {
+      do {
+        // every even key is seen once and in order, whatever the writers do around it
+        int64_t last = reverse != 0 ? total : -1;
+        int64_t next_even = reverse != 0 ? total - 2 : 0;
+        for (auto iter = reverse != 0 ? tree.RBegin() : tree.Begin(); iter != tree.End(); ++iter) {
+          int64_t key = (*iter).first.ToString();
+          ASSERT_TRUE(reverse != 0 ? key < last : key > last);
+          if (key % 2 == 0) {
+            ASSERT_EQ(key, next_even);
+            next_even += reverse != 0 ? -2 : 2;
+          }
+          last = key;
+        }
+        ASSERT_EQ(next_even, reverse != 0 ? -2 : total);
+      } while (!done);
+    });
+  }
+  for (auto &writer : writers) {
+    writer.join();
+  }
+  done = true;
+  for (auto &scanner : scanners) {
+    scanner.join();
+  }
+
+  int64_t size = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    ASSERT_EQ((*iter).first.ToString(), size * 2);
+    size++;
+  }
+  EXPECT_EQ(size, total / 2);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
+
 }  // namespace bustub
@@ -186,4 +186,37 @@ TEST(BPlusTreeTests, InsertTest3) {
   delete transaction;
   delete bpm;
 }
+
+TEST(BPlusTreeTests, ScanLargerThanBufferPool) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto *bpm = new BufferPoolManager(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", header_page->GetPageId(), bpm, comparator, 3, 3);
+  GenericKey<8> index_key;
+  RID rid;
+
+  // Far more leaves than frames, so the pages read ahead of the iterator keep evicting others.
+  int64_t size = 1000;
+  for (int64_t key = 1; key <= size; key++) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    tree.Insert(index_key, rid);
+  }
+
+  for (int round = 0; round < 3; round++) {
+    int64_t current_key = 1;
+    for (auto iterator = tree.Begin(); !iterator.IsEnd(); ++iterator) {
+      ASSERT_EQ((*iterator).second.GetSlotNum(), current_key);
+      current_key++;
+    }
+    EXPECT_EQ(current_key, size + 1);
+  }
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+}
 }  // namespace bustub
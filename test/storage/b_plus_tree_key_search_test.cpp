@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_key_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_key_search_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "gtest/gtest.h"
+#include "storage/index/key_search.h"
+#include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
+
+namespace bustub {
+
+using Search = KeySearch<GenericKey<8>, RID, GenericComparator<8>>;
+using GeneralSearch = KeySearch<GenericKey<8>, RID, std::function<int(const GenericKey<8> &, const GenericKey<8> &)>>;
+
+namespace {
+
+auto MakeKey(Schema *key_schema, const Value &value) -> GenericKey<8> {
+  GenericKey<8> key;
+  key.SetFromKey(Tuple({value}, key_schema));
+  return key;
+}
+
+void CheckSearch(const std::string &column_type) {
+  auto key_schema = ParseCreateStatement("a " + column_type);
+  GenericComparator<8> comparator(key_schema.get());
+  ASSERT_TRUE(comparator.IsIntegerKey());
+  // The general search through a comparator without the fast path.
+  std::function<int(const GenericKey<8> &, const GenericKey<8> &)> general = [&](const auto &lhs, const auto &rhs) {
+    Value lhs_value = lhs.ToValue(key_schema.get(), 0);
+    Value rhs_value = rhs.ToValue(key_schema.get(), 0);
+    return lhs_value.CompareLessThan(rhs_value) == CmpBool::CmpTrue
+               ? -1
+               : (lhs_value.CompareGreaterThan(rhs_value) == CmpBool::CmpTrue ? 1 : 0);
+  };
+  TypeId type = key_schema->GetColumn(0).GetType();
+
+  std::mt19937 rng(15445);
+  std::uniform_int_distribution<int> dist(-100, 100);
+  for (int size : {0, 1, 2, 3, 7, 64, 255}) {
+    std::vector<int> integers;
+    for (int i = 0; i < size; i++) {
+      integers.push_back(dist(rng));
+    }
+    std::sort(integers.begin(), integers.end());
+    std::vector<std::pair<GenericKey<8>, RID>> array;
+    for (int integer : integers) {
+      array.emplace_back(MakeKey(key_schema.get(), ValueFactory::GetIntegerValue(integer).CastAs(type)), RID());
+    }
+
+    for (int target = -101; target <= 101; target++) {
+      auto key = MakeKey(key_schema.get(), ValueFactory::GetIntegerValue(target).CastAs(type));
+      for (int begin : {0, size / 2}) {
+        int lower = Search::LowerBound(array.data(), begin, size, key, comparator);
+        int upper = Search::UpperBound(array.data(), begin, size, key, comparator);
+        EXPECT_EQ(lower, std::lower_bound(integers.begin() + begin, integers.end(), target) - integers.begin());
+        EXPECT_EQ(upper, std::upper_bound(integers.begin() + begin, integers.end(), target) - integers.begin());
+        EXPECT_EQ(lower, GeneralSearch::LowerBound(array.data(), begin, size, key, general));
+        EXPECT_EQ(upper, GeneralSearch::UpperBound(array.data(), begin, size, key, general));
+      }
+    }
+
+    // A NULL key compares equal to everything, in the fast path as in the Value comparison.
+    auto null_key = MakeKey(key_schema.get(), ValueFactory::GetNullValueByType(type));
+    EXPECT_EQ(Search::LowerBound(array.data(), 0, size, null_key, comparator),
+              GeneralSearch::LowerBound(array.data(), 0, size, null_key, general));
+    EXPECT_EQ(Search::UpperBound(array.data(), 0, size, null_key, comparator),
+              GeneralSearch::UpperBound(array.data(), 0, size, null_key, general));
+  }
+}
+
+}  // namespace
+
+TEST(BPlusTreeKeySearchTest, IntegerKeys) {
+  CheckSearch("bigint");
+  CheckSearch("integer");
+  CheckSearch("smallint");
+}
+
+TEST(BPlusTreeKeySearchTest, ComparatorFastPath) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  ASSERT_TRUE(comparator.IsIntegerKey());
+  GenericComparator<8> copy(comparator);
+  ASSERT_TRUE(copy.IsIntegerKey());
+
+  auto small = MakeKey(key_schema.get(), ValueFactory::GetBigIntValue(-5));
+  auto large = MakeKey(key_schema.get(), ValueFactory::GetBigIntValue(1LL << 40));
+  auto null = MakeKey(key_schema.get(), ValueFactory::GetNullValueByType(TypeId::BIGINT));
+  EXPECT_EQ(comparator(small, large), -1);
+  EXPECT_EQ(comparator(large, small), 1);
+  EXPECT_EQ(comparator(large, large), 0);
+  EXPECT_EQ(copy(small, large), -1);
+  EXPECT_EQ(comparator(null, small), 0);
+  EXPECT_EQ(comparator(large, null), 0);
+
+  // Keys that are not a single integer column keep the general comparison.
+  auto varchar_schema = ParseCreateStatement("a varchar(8)");
+  EXPECT_FALSE(GenericComparator<8>(varchar_schema.get()).IsIntegerKey());
+  auto pair_schema = ParseCreateStatement("a integer,b integer");
+  EXPECT_FALSE(GenericComparator<8>(pair_schema.get()).IsIntegerKey());
+}
+
+}  // namespace bustub
@@ -0,0 +1,317 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_varlen_test.cpp
+//
+// Identification: test/storage/b_plus_tree_varlen_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "fmt/format.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/varlen_b_plus_tree.h"
+#include "storage/index/varlen_b_plus_tree_index.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using bustub::DiskManagerUnlimitedMemory;
+
+using LeafPage = BPlusTreeVarlenPage<RID>;
+using InternalPage = BPlusTreeVarlenPage<page_id_t>;
+
+namespace {
+
+auto MakeKey(int64_t key) -> std::string { return fmt::format("customer-{:010}@example.com", key); }
+
+/** Walks the tree, checking that each page's keys are in order and within the separators above it. */
+void CheckPage(BufferPoolManager *bpm, page_id_t page_id, const std::string &low, const std::string *high,
+               int *leaves, int *prefixed_leaves) {
+  auto guard = bpm->FetchPageRead(page_id);
+  if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+    auto leaf = guard.As<LeafPage>();
+    (*leaves)++;
+    *prefixed_leaves += leaf->GetPrefix().empty() ? 0 : 1;
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      ASSERT_GE(leaf->KeyAt(i), low);
+      if (high != nullptr) {
+        ASSERT_LT(leaf->KeyAt(i), *high);
+      }
+    }
+    return;
+  }
+  auto internal = guard.As<InternalPage>();
+  ASSERT_GE(internal->GetSize(), 2);
+  for (int i = 0; i < internal->GetSize(); i++) {
+    std::string child_low = i == 0 ? low : internal->KeyAt(i);
+    std::string child_high = i + 1 < internal->GetSize() ? internal->KeyAt(i + 1) : "";
+    CheckPage(bpm, internal->ValueAt(i), child_low, i + 1 < internal->GetSize() ? &child_high : high, leaves,
+              prefixed_leaves);
+  }
+}
+
+}  // namespace
+
+TEST(BPlusTreeVarlenTest, PageLayout) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto guard = bpm->NewPageGuarded(&page_id);
+  auto leaf = guard.AsMut<LeafPage>();
+  leaf->Init(IndexPageType::LEAF_PAGE);
+
+  std::vector<LeafPage::Entry> entries;
+  for (int64_t key = 0; key < 10; key++) {
+    entries.emplace_back(MakeKey(key * 10), RID(0, key));
+  }
+  leaf->Rebuild(entries, 0, entries.size());
+  EXPECT_EQ(leaf->GetPrefix(), "customer-00000000");
+  EXPECT_EQ(leaf->KeyAt(3), MakeKey(30));
+  EXPECT_EQ(leaf->LowerBound(MakeKey(31)), 4);
+  EXPECT_EQ(leaf->UpperBound(MakeKey(30)), 4);
+  EXPECT_EQ(leaf->LowerBound("a"), 0);
+  EXPECT_EQ(leaf->LowerBound("z"), 10);
+
+  // A key between two others keeps the prefix, a key past the end gives it up.
+  ASSERT_TRUE(leaf->Insert(leaf->LowerBound(MakeKey(15)), MakeKey(15), RID(0, 15)));
+  EXPECT_EQ(leaf->GetPrefix(), "customer-00000000");
+  ASSERT_TRUE(leaf->Insert(leaf->LowerBound("customer-1"), "customer-1", RID(0, 100)));
+  EXPECT_EQ(leaf->GetPrefix(), "customer-");
+  leaf->Remove(0);
+  EXPECT_EQ(leaf->GetSize(), 11);
+  EXPECT_EQ(leaf->KeyAt(0), MakeKey(10));
+  EXPECT_EQ(leaf->KeyAt(1), MakeKey(15));
+  EXPECT_EQ(leaf->KeyAt(10), "customer-1");
+  EXPECT_EQ(leaf->ValueAt(10).GetSlotNum(), 100);
+
+  // Separators are cut down to the first byte that tells the keys apart.
+  EXPECT_EQ(LeafPage::Separator("customer-0000000019", "customer-0000000020"), "customer-000000002");
+  EXPECT_EQ(LeafPage::Separator("abc", "abcd"), "abcd");
+  EXPECT_EQ(LeafPage::Separator("abc", "b"), "b");
+  bpm->UnpinPage(page_id, true);
+}
+
+TEST(BPlusTreeVarlenTest, InsertLookupAndScan) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  VarlenBPlusTree tree("foo_pk", header_page->GetPageId(), bpm.get());
+
+  std::vector<int64_t> keys(20000);
+  std::iota(keys.begin(), keys.end(), 0);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(15445));
+  for (auto key : keys) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  EXPECT_FALSE(tree.Insert(MakeKey(100), RID()));
+  EXPECT_THROW(tree.Insert(std::string(VARLEN_KEY_MAX_SIZE + 1, 'x'), RID()), Exception);
+
+  int leaves = 0;
+  int prefixed_leaves = 0;
+  CheckPage(bpm.get(), tree.GetRootPageId(), "", nullptr, &leaves, &prefixed_leaves);
+  // 38 byte keys fit about 70 to a page if their shared prefix is stored once.
+  EXPECT_LT(leaves, 20000 / 60);
+  EXPECT_EQ(prefixed_leaves, leaves);
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 20000; key++) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(MakeKey(key), &rids));
+    EXPECT_EQ(rids[0].GetSlotNum(), key);
+  }
+  EXPECT_FALSE(tree.GetValue("customer-", &rids));
+  EXPECT_FALSE(tree.GetValue(MakeKey(20000), &rids));
+
+  int64_t expected = 0;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    ASSERT_EQ(iter.Key(), MakeKey(expected++));
+  }
+  EXPECT_EQ(expected, 20000);
+
+  // Removed keys are skipped by lookups and scans, and leaves that are left underfull are merged.
+  for (int64_t key = 0; key < 20000; key++) {
+    if (key % 3 != 0 || (key >= 5000 && key < 10000)) {
+      tree.Remove(MakeKey(key));
+    }
+  }
+  int full_leaves = leaves;
+  leaves = 0;
+  CheckPage(bpm.get(), tree.GetRootPageId(), "", nullptr, &leaves, &prefixed_leaves);
+  EXPECT_LT(leaves, full_leaves / 3);
+  expected = 0;
+  for (auto iter = tree.Begin(MakeKey(1)); !iter.IsEnd(); ++iter) {
+    expected += 3;
+    if (expected == 5001) {
+      expected = 10002;
+    }
+    ASSERT_EQ(iter.Key(), MakeKey(expected));
+  }
+  EXPECT_EQ(expected, 19998);
+  EXPECT_FALSE(tree.GetValue(MakeKey(1), &rids));
+
+  // Removed ranges take new keys again.
+  for (int64_t key = 5000; key < 10000; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  rids.clear();
+  EXPECT_TRUE(tree.GetValue(MakeKey(7777), &rids));
+
+  // Removing every key merges the tree down to nothing.
+  for (int64_t key = 0; key < 20000; key++) {
+    tree.Remove(MakeKey(key));
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_TRUE(tree.Begin().IsEnd());
+  ASSERT_TRUE(tree.Insert(MakeKey(1), RID(0, 1)));
+  EXPECT_TRUE(tree.GetValue(MakeKey(1), &rids));
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeVarlenTest, LongAndShortKeys) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  VarlenBPlusTree tree("foo_pk", header_page->GetPageId(), bpm.get());
+
+  // Keys from one byte to the longest allowed, of few letters so that neighbors share prefixes of any length.
+  std::mt19937 gen(15445);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 3000; i++) {
+    size_t size = std::uniform_int_distribution<size_t>(1, VARLEN_KEY_MAX_SIZE)(gen);
+    std::string key(size, 'a');
+    for (auto &c : key) {
+      c = static_cast<char>(std::uniform_int_distribution<int>('a', 'c')(gen));
+    }
+    keys.push_back(std::move(key));
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  auto shuffled = keys;
+  std::shuffle(shuffled.begin(), shuffled.end(), gen);
+  for (const auto &key : shuffled) {
+    ASSERT_TRUE(tree.Insert(key, RID()));
+  }
+
+  int leaves = 0;
+  int prefixed_leaves = 0;
+  CheckPage(bpm.get(), tree.GetRootPageId(), "", nullptr, &leaves, &prefixed_leaves);
+  std::vector<std::string> scanned;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    scanned.push_back(iter.Key());
+  }
+  EXPECT_EQ(scanned, keys);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeVarlenTest, ConcurrentInsertAndScan) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  VarlenBPlusTree tree("foo_pk", header_page->GetPageId(), bpm.get());
+
+  const int64_t total = 8000;
+  std::vector<std::thread> threads;
+  for (int64_t writer = 0; writer < 4; writer++) {
+    threads.emplace_back([&tree, writer] {
+      for (int64_t key = writer; key < total; key += 4) {
+        tree.Insert(MakeKey(key), RID(0, key));
+      }
+    });
+  }
+  threads.emplace_back([&tree] {
+    for (int round = 0; round < 5; round++) {
+      std::string last;
+      for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+        ASSERT_LT(last, iter.Key());
+        last = iter.Key();
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < total; key++) {
+    ASSERT_TRUE(tree.GetValue(MakeKey(key), &rids));
+  }
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeVarlenTest, ConcurrentRemoveAndScan) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManager>(50, disk_manager.get());
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  VarlenBPlusTree tree("foo_pk", header_page->GetPageId(), bpm.get());
+
+  const int64_t total = 8000;
+  for (int64_t key = 0; key < total; key++) {
+    ASSERT_TRUE(tree.Insert(MakeKey(key), RID(0, key)));
+  }
+  // Every key but the multiples of 8 goes, so the scanner crosses leaves while they are merged.
+  std::vector<std::thread> threads;
+  for (int64_t remover = 0; remover < 4; remover++) {
+    threads.emplace_back([&tree, remover] {
+      for (int64_t key = remover; key < total; key += 4) {
+        if (key % 8 != 0) {
+          tree.Remove(MakeKey(key));
+        }
+      }
+    });
+  }
+  threads.emplace_back([&tree] {
+    for (int round = 0; round < 5; round++) {
+      std::string last;
+      for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+        ASSERT_LT(last, iter.Key());
+        last = iter.Key();
+      }
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  int64_t expected = 0;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    ASSERT_EQ(iter.Key(), MakeKey(expected));
+    expected += 8;
+  }
+  EXPECT_EQ(expected, total);
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+}
+
+TEST(BPlusTreeVarlenTest, KeyEncoding) {
+  auto key_schema = ParseCreateStatement("a integer,b varchar(16)");
+  std::vector<std::pair<int32_t, std::string>> values{{-100, "b"}, {-1, ""},      {-1, std::string("a\0b", 3)},
+                                                      {-1, "a"},   {0, "abc"},    {0, "abcd"},
+                                                      {7, "a"},    {1 << 20, ""}, {1 << 20, "z"}};
+  std::sort(values.begin(), values.end());
+
+  std::vector<std::string> encoded;
+  for (const auto &[number, text] : values) {
+    Tuple key({Value(TypeId::INTEGER, number), Value(TypeId::VARCHAR, text)}, key_schema.get());
+    encoded.push_back(VarlenBPlusTreeIndex::EncodeKey(key, *key_schema));
+  }
+  // The encoded keys sort as the values they were made from, and no two are equal.
+  EXPECT_TRUE(std::is_sorted(encoded.begin(), encoded.end()));
+  EXPECT_EQ(std::adjacent_find(encoded.begin(), encoded.end()), encoded.end());
+}
+
+}  // namespace bustub
@@ -10,11 +10,20 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <sys/stat.h>
+#include <unistd.h>
 #include <cstring>
+#include <fstream>
+#include <future>  // NOLINT
+#include <memory>
+#include <vector>
 
 #include "common/exception.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_async.h"
+#include "storage/disk/disk_manager_posix.h"
+#include "storage/page/page.h"
 
 namespace bustub {
 
@@ -24,12 +33,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.fsm");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.crc");
+    remove("test.fsm");
   };
 };
 
@@ -75,4 +88,282 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixReadWritePageTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[3 * BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManagerPosix(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+  std::strncpy(data + 2 * BUSTUB_PAGE_SIZE, "Another test string.", BUSTUB_PAGE_SIZE);
+
+  std::memset(buf, 'x', sizeof(buf));
+  dm.ReadPage(0, buf);  // reads past the end of the file as zeros
+  EXPECT_EQ(std::memcmp(buf, data + BUSTUB_PAGE_SIZE, sizeof(buf)), 0);
+
+  dm.WritePage(0, data);
+  dm.ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+  dm.WritePages(4, 3, data);
+  for (page_id_t page_id = 4; page_id < 7; ++page_id) {
+    dm.ReadPage(page_id, buf);
+    EXPECT_EQ(std::memcmp(buf, data + (page_id - 4) * BUSTUB_PAGE_SIZE, sizeof(buf)), 0);
+  }
+  EXPECT_EQ(4, dm.GetNumWrites());
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixDirectIoTest) {
+  std::string db_file("test.db");
+  auto dm = DiskManagerPosix(db_file, true);
+
+  // Page frames are aligned, so they go to the disk as they are.
+  Page page;
+  std::strncpy(page.GetData(), "A test string.", BUSTUB_PAGE_SIZE);
+  dm.WritePage(0, page.GetData());
+  Page read_page;
+  dm.ReadPage(0, read_page.GetData());
+  EXPECT_EQ(std::memcmp(read_page.GetData(), page.GetData(), BUSTUB_PAGE_SIZE), 0);
+
+  // Unaligned buffers are copied through an aligned one.
+  std::vector<char> buf(BUSTUB_PAGE_SIZE + 1);
+  std::vector<char> data(BUSTUB_PAGE_SIZE + 1);
+  std::strncpy(data.data() + 1, "Another test string.", BUSTUB_PAGE_SIZE);
+  dm.WritePage(1, data.data() + 1);
+  dm.ReadPage(1, buf.data() + 1);
+  EXPECT_EQ(std::memcmp(buf.data() + 1, data.data() + 1, BUSTUB_PAGE_SIZE), 0);
+  dm.ReadPage(0, buf.data() + 1);
+  EXPECT_EQ(std::memcmp(buf.data() + 1, page.GetData(), BUSTUB_PAGE_SIZE), 0);
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, PosixThrowBadFileTest) {
+  EXPECT_THROW(DiskManagerPosix("dev/null\\/foo/bar/baz/test.db"), Exception);
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePageTest) {
+  const int page_cnt = 16;
+  std::string db_file("test.db");
+  for (bool use_io_uring : {true, false}) {
+    remove("test.db");
+    // A queue depth below the batch size makes Submit() wait for completions.
+    auto dm = DiskManagerAsync(db_file, false, 4, use_io_uring);
+    std::vector<char> data(page_cnt * BUSTUB_PAGE_SIZE);
+    std::vector<DiskRequest> requests;
+    std::vector<std::future<void>> futures;
+    for (page_id_t page_id = 0; page_id < page_cnt; ++page_id) {
+      snprintf(data.data() + page_id * BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE, "page %d", page_id);
+    }
+    // Pages 0-7 are written one by one, pages 8-11 by a single request, and pages 12-15 by WritePageAsync().
+    for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+      requests.push_back(DiskRequest{true, page_id, data.data() + page_id * BUSTUB_PAGE_SIZE, 1, {}});
+      futures.push_back(requests.back().callback_.get_future());
+    }
+    requests.push_back(DiskRequest{true, 8, data.data() + 8 * BUSTUB_PAGE_SIZE, 4, {}});
+    futures.push_back(requests.back().callback_.get_future());
+    for (page_id_t page_id = 12; page_id < page_cnt; ++page_id) {
+      futures.push_back(dm.WritePageAsync(page_id, data.data() + page_id * BUSTUB_PAGE_SIZE));
+    }
+    dm.Submit(std::move(requests));
+    for (auto &future : futures) {
+      future.get();
+    }
+    EXPECT_EQ(page_cnt, dm.GetNumWrites());
+
+    std::vector<char> buf(page_cnt * BUSTUB_PAGE_SIZE, 'x');
+    futures.clear();
+    for (page_id_t page_id = 0; page_id < page_cnt; ++page_id) {
+      futures.push_back(dm.ReadPageAsync(page_id, buf.data() + page_id * BUSTUB_PAGE_SIZE));
+    }
+    for (auto &future : futures) {
+      future.get();
+    }
+    EXPECT_EQ(std::memcmp(buf.data(), data.data(), buf.size()), 0);
+
+    // Reading past the end of the file yields zeros, just like ReadPage().
+    dm.ReadPageAsync(page_cnt + 1, buf.data()).get();
+    EXPECT_EQ(std::string(BUSTUB_PAGE_SIZE, '\0'), std::string(buf.data(), BUSTUB_PAGE_SIZE));
+
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  for (bool posix : {false, true}) {
+    remove("test.db");
+    remove("test.crc");
+    {
+      std::unique_ptr<DiskManager> dm;
+      if (posix) {
+        dm = std::make_unique<DiskManagerPosix>(db_file);
+      } else {
+        dm = std::make_unique<DiskManager>(db_file);
+      }
+      dm->EnableChecksums();
+      dm->ReadPage(3, buf);  // pages that were never written are not checked
+      dm->WritePage(0, data);
+      dm->WritePages(1, 1, data);
+      dm->ReadPage(0, buf);
+      EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+      dm->ShutDown();
+    }
+
+    // Scenario: page 1 is torn, only its first half made it to the disk.
+    {
+      std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2);
+      file.write(std::string(BUSTUB_PAGE_SIZE / 2, 'x').data(), BUSTUB_PAGE_SIZE / 2);
+    }
+    std::unique_ptr<DiskManager> dm;
+    if (posix) {
+      dm = std::make_unique<DiskManagerPosix>(db_file);
+    } else {
+      dm = std::make_unique<DiskManager>(db_file);
+    }
+    dm->EnableChecksums();
+    dm->ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    try {
+      dm->ReadPage(1, buf);
+      FAIL() << "a torn page was not detected";
+    } catch (Exception &e) {
+      EXPECT_EQ(ExceptionType::CORRUPTION, e.GetType());
+    }
+    // Recovering the checksums after a crash of the machine reports the page and keeps failing it.
+    EXPECT_EQ(dm->RecoverChecksums(), std::vector<page_id_t>{1});
+    EXPECT_THROW(dm->ReadPage(1, buf), Exception);
+    // Rewriting the page fixes it.
+    dm->WritePage(1, data);
+    dm->ReadPage(1, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+
+    // Scenario: the machine crashed after the checksum of a new version of page 0 was recorded, but before the page
+    // was written. The old version is still accepted, and so is the new one once it is written after all.
+    char new_data[BUSTUB_PAGE_SIZE] = {0};
+    std::strncpy(new_data, "Another test string.", sizeof(new_data));
+    dm->WritePage(0, new_data);
+    {
+      std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+      file.write(data, BUSTUB_PAGE_SIZE);
+    }
+    dm->ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+    EXPECT_TRUE(dm->RecoverChecksums().empty());
+    dm->WritePage(0, new_data);
+    dm->ReadPage(0, buf);
+    EXPECT_EQ(std::memcmp(buf, new_data, sizeof(buf)), 0);
+
+    // Scenario: the file lost its last page.
+    dm->ShutDown();
+    ASSERT_EQ(0, truncate(db_file.c_str(), BUSTUB_PAGE_SIZE));
+    dm.reset();
+    if (posix) {
+      dm = std::make_unique<DiskManagerPosix>(db_file);
+    } else {
+      dm = std::make_unique<DiskManager>(db_file);
+    }
+    dm->EnableChecksums();
+    EXPECT_THROW(dm->ReadPage(1, buf), Exception);
+    dm->ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreeSpaceMapTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  {
+    DiskManagerPosix dm(db_file);
+    dm.EnableFreeSpaceMap();
+    dm.EnableChecksums();
+    for (page_id_t page_id = 0; page_id < 8; page_id++) {
+      EXPECT_EQ(page_id, dm.AllocatePage());
+      dm.WritePage(page_id, data);
+    }
+
+    // Scenario: freed pages are reused, lowest first, before the file grows.
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(2);
+    dm.DeallocatePage(2);  // freeing a page twice is ignored
+    EXPECT_EQ(2, dm.GetFreePageCount());
+    EXPECT_EQ(2, dm.AllocatePage());
+    EXPECT_EQ(5, dm.AllocatePage());
+    EXPECT_EQ(8, dm.AllocatePage());
+    dm.WritePage(8, data);
+
+    // Scenario: the free pages at the end of the file are cut off.
+    dm.DeallocatePage(6);
+    dm.DeallocatePage(8);
+    dm.DeallocatePage(7);
+    EXPECT_EQ(6, dm.GetPageCount());
+    EXPECT_EQ(0, dm.GetFreePageCount());
+    EXPECT_EQ(3, dm.ShrinkToFit());
+    EXPECT_EQ(0, dm.ShrinkToFit());
+    struct stat stat_buf;
+    ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+    EXPECT_EQ(6 * BUSTUB_PAGE_SIZE, stat_buf.st_size);
+
+    // A page that was cut off reads back as zeros once reused, which must not fail its old checksum.
+    EXPECT_EQ(6, dm.AllocatePage());
+    char buf[BUSTUB_PAGE_SIZE];
+    dm.ReadPage(6, buf);
+    dm.DeallocatePage(6);
+    dm.DeallocatePage(1);
+    dm.ShutDown();
+  }
+
+  // Scenario: the free pages are known again after reopening the database.
+  DiskManagerPosix dm(db_file);
+  dm.EnableFreeSpaceMap();
+  EXPECT_EQ(6, dm.GetPageCount());
+  EXPECT_EQ(1, dm.GetFreePageCount());
+  EXPECT_EQ(1, dm.AllocatePage());
+  EXPECT_EQ(6, dm.AllocatePage());
+  dm.ShutDown();
+
+  // Scenario: a database created with another page size is not opened.
+  {
+    std::fstream file("test.fsm", std::ios::binary | std::ios::in | std::ios::out);
+    uint64_t page_size = 2 * BUSTUB_PAGE_SIZE;
+    file.write(reinterpret_cast<char *>(&page_size), sizeof(page_size));
+  }
+  DiskManagerPosix other_dm(db_file);
+  EXPECT_THROW(other_dm.EnableFreeSpaceMap(), Exception);
+  other_dm.ShutDown();
+}
+
+TEST_F(DiskManagerTest, ShrinkLargeFileTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  DiskManagerPosix dm(db_file);
+  dm.EnableFreeSpaceMap();
+
+  // A sparse file just over 2 GiB, whose size does not fit in an int.
+  const auto page_cnt = static_cast<page_id_t>((int64_t{1} << 31) / BUSTUB_PAGE_SIZE) + 1;
+  for (page_id_t page_id = 0; page_id < page_cnt; page_id++) {
+    ASSERT_EQ(page_id, dm.AllocatePage());
+  }
+  dm.WritePage(page_cnt - 1, data);
+  dm.DeallocatePage(page_cnt - 1);
+  EXPECT_EQ(1, dm.ShrinkToFit());
+  struct stat stat_buf;
+  ASSERT_EQ(0, stat(db_file.c_str(), &stat_buf));
+  EXPECT_EQ(static_cast<off_t>(page_cnt - 1) * BUSTUB_PAGE_SIZE, stat_buf.st_size);
+  dm.ShutDown();
+}
+
 }  // namespace bustub
@@ -235,4 +235,52 @@ TEST(PageGuardTest, MoveTest) {
   disk_manager->ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticTest) {
+  const size_t buffer_pool_size = 1;
+  const size_t k = 2;
+
+  auto disk_manager = std::make_shared<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_shared<BufferPoolManager>(buffer_pool_size, disk_manager.get(), k);
+
+  page_id_t page_id0;
+  bpm->NewPageGuarded(&page_id0).Drop();
+
+  // Nothing has changed since the guard was taken, and readers leave the version alone.
+  auto guard = bpm->FetchPageOptimistic(page_id0);
+  EXPECT_EQ(page_id0, guard.PageId());
+  EXPECT_TRUE(guard.Validate());
+  bpm->FetchPageRead(page_id0).Drop();
+  EXPECT_TRUE(guard.Validate());
+
+  // A writer invalidates the guard, even if it changes nothing.
+  bpm->FetchPageWrite(page_id0).Drop();
+  EXPECT_FALSE(guard.Validate());
+
+  // So does handing the frame to another page.
+  guard = bpm->FetchPageOptimistic(page_id0);
+  EXPECT_TRUE(guard.Validate());
+  page_id_t page_id_temp;
+  bpm->NewPageGuarded(&page_id_temp).Drop();
+  EXPECT_FALSE(guard.Validate());
+
+  // A page that has to be read from disk first can be looked at as well.
+  guard = bpm->FetchPageOptimistic(page_id0);
+  EXPECT_TRUE(guard.Validate());
+  EXPECT_EQ(page_id0, guard.PageId());
+
+  // Hits go to the access log without a latch, and are all counted even when they overflow it.
+  auto hits = bpm->GetStats().Access(AccessType::Unknown).hits_;
+  for (int i = 0; i < 2 * ACCESS_LOG_SIZE; i++) {
+    EXPECT_TRUE(bpm->FetchPageOptimistic(page_id0).Validate());
+  }
+  EXPECT_EQ(hits + 2 * ACCESS_LOG_SIZE, bpm->GetStats().Access(AccessType::Unknown).hits_);
+
+  guard.Drop();
+  EXPECT_FALSE(guard.Validate());
+  EXPECT_FALSE(OptimisticPageGuard().Validate());
+
+  disk_manager->ShutDown();
+}
+
 }  // namespace bustub
@@ -1,4 +1,6 @@
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -6,6 +8,7 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <tuple>
 #include <vector>
 
 #include <cpp_random_distributions/zipfian_int_distribution.h>
@@ -16,10 +19,14 @@
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
 #include "common/exception.h"
+#include "common/util/numa_util.h"
 #include "common/util/string_util.h"
 #include "fmt/core.h"
+#include "fmt/format.h"
 #include "fmt/std.h"
+#include "storage/disk/disk_manager_async.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_manager_posix.h"
 
 #include <sys/time.h>
 
@@ -33,11 +40,78 @@ static const size_t BUSTUB_SCAN_THREAD = 8;
 static const size_t BUSTUB_GET_THREAD = 8;
 static const size_t LRU_K_SIZE = 16;
 static const size_t BUSTUB_PAGE_CNT = 6400;
-static const size_t BUSTUB_BPM_SIZE = 64;
+static const size_t BUSTUB_BPM_SIZE = 64;  // default size of the buffer pool, see --bpm-size
+
+/** Set in get threads, so that the disk manager can tell misses of the hot set from scan misses. */
+static thread_local bool is_get_thread = false;
+
+/** Forwards page I/O to the disk manager under test and counts the pages read on behalf of get threads. */
+class GetMissCountingDiskManager : public bustub::DiskManager {
+ public:
+  explicit GetMissCountingDiskManager(std::unique_ptr<bustub::DiskManager> disk_manager)
+      : disk_manager_(std::move(disk_manager)) {}
+
+  void ShutDown() override { disk_manager_->ShutDown(); }
+
+  void WritePage(bustub::page_id_t page_id, const char *page_data) override {
+    disk_manager_->WritePage(page_id, page_data);
+  }
+
+  void WritePages(bustub::page_id_t start_page_id, size_t page_count, const char *page_data) override {
+    disk_manager_->WritePages(start_page_id, page_count, page_data);
+  }
+
+  void ReadPage(bustub::page_id_t page_id, char *page_data) override {
+    if (is_get_thread) {
+      get_miss_cnt_++;
+    }
+    disk_manager_->ReadPage(page_id, page_data);
+  }
+
+  void Submit(std::vector<bustub::DiskRequest> requests) override { disk_manager_->Submit(std::move(requests)); }
+
+  std::atomic<uint64_t> get_miss_cnt_{0};
+
+ private:
+  std::unique_ptr<bustub::DiskManager> disk_manager_;
+};
+
+/**
+ * Print the buffer pool counters as one line of JSON. Bucket i of a latency histogram counts the misses that took less
+ * than 2^i microseconds (and at least 2^(i-1) for i > 0), the last bucket also counts all longer ones.
+ */
+void PrintStatsJson(bustub::BufferPoolManager *bpm) {
+  auto stats = bpm->GetStats();
+  std::vector<std::string> accesses;
+  for (size_t i = 0; i < bustub::NUM_ACCESS_TYPES; i++) {
+    auto access_type = static_cast<bustub::AccessType>(i);
+    const auto &access_stats = stats.Access(access_type);
+    const auto &latency = access_stats.miss_latency_;
+    accesses.push_back(fmt::format(
+        R"("{}":{{"hits":{},"misses":{},"second_tier_hits":{},"evictions":{},"write_backs":{},"failures":{},)"
+        R"("miss_latency_us":{{"p50":{},"p99":{},"buckets":[{}]}}}})",
+        bustub::AccessTypeToString(access_type), access_stats.hits_, access_stats.misses_,
+        access_stats.second_tier_hits_, access_stats.evictions_,
+        access_stats.write_backs_, access_stats.failures_, latency.Percentile(50), latency.Percentile(99),
+        fmt::join(latency.buckets_, ",")));
+  }
+  const auto &second_tier = stats.second_tier_;
+  fmt::print(
+      R"(bpm_stats: {{"pool_size":{},"new_pages":{},"new_page_failures":{},"evictions":{},"foreground_writes":{},)"
+      R"("background_writes":{},"local_frames":{},"remote_frames":{},"second_tier":{{"budget_bytes":{},)"
+      R"("used_bytes":{},"pages":{},"hits":{},"misses":{},"inserts":{},"evictions":{},"rejects":{}}},)"
+      R"("accesses":{{{}}}}})"
+      "\n",
+      bpm->GetPoolSize(), stats.new_pages_, stats.new_page_failures_, stats.evictions_, stats.foreground_writes_,
+      stats.background_writes_, stats.local_frames_, stats.remote_frames_, second_tier.budget_bytes_,
+      second_tier.used_bytes_, second_tier.pages_, second_tier.hits_, second_tier.misses_, second_tier.inserts_,
+      second_tier.evictions_, second_tier.rejects_, fmt::join(accesses, ","));
+}
 
 struct BpmTotalMetrics {
   uint64_t scan_cnt_{0};
   uint64_t get_cnt_{0};
+  uint64_t get_miss_cnt_{0};
   uint64_t start_time_{0};
   std::mutex mutex_;
 
@@ -53,15 +127,30 @@ struct BpmTotalMetrics {
     get_cnt_ += get_cnt;
   }
 
-  void Report() {
-    auto now = ClockMs();
-    auto elsped = now - start_time_;
-    auto scan_per_sec = scan_cnt_ / static_cast<double>(elsped) * 1000;
-    auto get_per_sec = get_cnt_ / static_cast<double>(elsped) * 1000;
+  auto ScanPerSec() -> double { return scan_cnt_ / static_cast<double>(ClockMs() - start_time_) * 1000; }
+
+  auto GetPerSec() -> double { return get_cnt_ / static_cast<double>(ClockMs() - start_time_) * 1000; }
+
+  auto GetHitRatio() -> double {
+    return get_cnt_ == 0 ? 0 : 1 - get_miss_cnt_ / static_cast<double>(get_cnt_);
+  }
+
+  void Report(bustub::BufferPoolManager *bpm) {
+    auto scan_per_sec = ScanPerSec();
+    auto get_per_sec = GetPerSec();
+    auto get_hit_ratio = GetHitRatio();
 
     fmt::print("<<< BEGIN\n");
     fmt::print("scan: {}\n", scan_per_sec);
     fmt::print("get: {}\n", get_per_sec);
+    fmt::print("get_hit_ratio: {}\n", get_hit_ratio);
+    // get_hit_ratio counts every get that did not reach the disk, these split it up by tier.
+    auto stats = bpm->GetStats();
+    fmt::print("bpm_hit_ratio: {}\n", stats.AllAccesses().HitRatio());
+    fmt::print("second_tier_hit_ratio: {}\n", stats.second_tier_.HitRatio());
+    fmt::print("foreground_writes: {}\n", bpm->GetForegroundWriteCount());
+    fmt::print("background_writes: {}\n", bpm->GetBackgroundWriteCount());
+    PrintStatsJson(bpm);
     fmt::print(">>> END\n");
   }
 };
@@ -100,73 +189,42 @@ struct BpmMetrics {
   }
 };
 
-// NOLINTNEXTLINE
-auto main(int argc, char **argv) -> int {
+/**
+ * Run scan_thread_n scanning threads and get_thread_n zipfian point-lookup threads against the buffer pool for
+ * duration_ms, and accumulate their operation and miss counts into total_metrics. With read_ahead, the scanning threads
+ * prefetch the read_ahead pages after the next read_ahead ones whenever they cross a multiple of read_ahead. With
+ * pin_threads, the threads are pinned to CPUs round-robin over the NUMA nodes, scanning threads first.
+ */
+void RunWorkload(bustub::BufferPoolManager *bpm, GetMissCountingDiskManager *disk_manager,
+                 const std::vector<bustub::page_id_t> &page_ids, size_t scan_thread_n, size_t get_thread_n,
+                 uint64_t duration_ms, size_t read_ahead, bool pin_threads, BpmTotalMetrics *total_metrics_ptr) {
   using bustub::AccessType;
-  using bustub::BufferPoolManager;
-  using bustub::DiskManagerUnlimitedMemory;
-  using bustub::page_id_t;
-
-  argparse::ArgumentParser program("bustub-bpm-bench");
-  program.add_argument("--duration").help("run bpm bench for n milliseconds");
-  program.add_argument("--latency").help("set disk latency to n milliseconds");
-
-  try {
-    program.parse_args(argc, argv);
-  } catch (const std::runtime_error &err) {
-    std::cerr << err.what() << std::endl;
-    std::cerr << program;
-    return 1;
-  }
-
-  uint64_t duration_ms = 30000;
-  if (program.present("--duration")) {
-    duration_ms = std::stoi(program.get("--duration"));
-  }
-
-  uint64_t latency_ms = 0;
-  if (program.present("--latency")) {
-    latency_ms = std::stoi(program.get("--latency"));
-  }
-
-  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
-  std::vector<page_id_t> page_ids;
-
-  fmt::print(stderr, "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}\n",
-             BUSTUB_PAGE_CNT, duration_ms, latency_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE);
-
-  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
-    page_id_t page_id;
-    auto *page = bpm->NewPage(&page_id);
-    if (page == nullptr) {
-      throw std::runtime_error("new page failed");
-    }
-    char &ch = page->GetData()[i % 1024];
-    ch = 1;
-
-    bpm->UnpinPage(page_id, true);
-    page_ids.push_back(page_id);
-  }
-
-  // enable disk latency after creating all pages
-  disk_manager->SetLatency(latency_ms);
-
-  fmt::print(stderr, "[info] benchmark start\n");
-
-  BpmTotalMetrics total_metrics;
+  auto &total_metrics = *total_metrics_ptr;
   total_metrics.Begin();
+  auto get_miss_cnt_before = disk_manager->get_miss_cnt_.load();
 
   std::vector<std::thread> threads;
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_SCAN_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+  for (size_t thread_id = 0; thread_id < scan_thread_n; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &page_ids, bpm, duration_ms, scan_thread_n, read_ahead, pin_threads,
+                                      &total_metrics] {
+      if (pin_threads) {
+        bustub::NumaUtil::PinThread(thread_id);
+      }
       BpmMetrics metrics(fmt::format("scan {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
-      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / BUSTUB_SCAN_THREAD;
+      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / scan_thread_n;
 
+      std::vector<bustub::page_id_t> prefetch_page_ids;
       while (!metrics.ShouldFinish()) {
+        if (read_ahead > 0 && page_idx % read_ahead == 0) {
+          prefetch_page_ids.clear();
+          for (size_t i = read_ahead; i < 2 * read_ahead; i++) {
+            prefetch_page_ids.push_back(page_ids[(page_idx + i) % BUSTUB_PAGE_CNT]);
+          }
+          bpm->Prefetch(prefetch_page_ids);
+        }
         auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Scan);
         if (page == nullptr) {
           continue;
@@ -180,7 +238,7 @@ auto main(int argc, char **argv) -> int {
         }
         page->WUnlatch();
 
-        bpm->UnpinPage(page->GetPageId(), true, AccessType::Scan);
+        bpm->UnpinPage(page, true);
         page_idx = (page_idx + 1) % BUSTUB_PAGE_CNT;
         metrics.Tick();
         metrics.Report();
@@ -190,8 +248,13 @@ auto main(int argc, char **argv) -> int {
     }));
   }
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+  for (size_t thread_id = 0; thread_id < get_thread_n; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &page_ids, bpm, duration_ms, scan_thread_n, pin_threads,
+                                      &total_metrics] {
+      if (pin_threads) {
+        bustub::NumaUtil::PinThread(scan_thread_n + thread_id);
+      }
+      is_get_thread = true;
       std::random_device r;
       std::default_random_engine gen(r());
       zipfian_int_distribution<size_t> dist(0, BUSTUB_PAGE_CNT - 1, 0.8);
@@ -213,7 +276,7 @@ auto main(int argc, char **argv) -> int {
           throw std::runtime_error("invalid data");
         }
 
-        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+        bpm->UnpinPage(page, false);
         metrics.Tick();
         metrics.Report();
       }
@@ -225,8 +288,242 @@ auto main(int argc, char **argv) -> int {
   for (auto &thread : threads) {
     thread.join();
   }
+  total_metrics.get_miss_cnt_ = disk_manager->get_miss_cnt_.load() - get_miss_cnt_before;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  using bustub::BUSTUB_PAGE_SIZE;
+  using bustub::BufferPoolManager;
+  using bustub::page_id_t;
+
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run bpm bench for n milliseconds");
+  program.add_argument("--latency").help("set disk latency to n milliseconds (memory disk only)");
+  program.add_argument("--disk").help(
+      "disk manager to run against: memory (default), fstream, posix, direct, uring (io_uring) or threads (async with "
+      "a thread pool)");
+  program.add_argument("--queue-depth").help("number of I/Os in flight for the uring and threads disk managers");
+  program.add_argument("--checksums")
+      .help("checksum pages on write and verify them on read (file based disks only)")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--read-ahead").help("scan threads prefetch the next n pages, n pages at a time");
+  program.add_argument("--db-file").help("database file used by the file based disk managers");
+  program.add_argument("--shards").help("partition the buffer pool into n shards");
+  program.add_argument("--bpm-size").help("number of frames in the buffer pool");
+  program.add_argument("--scan-threads").help("number of scan threads");
+  program.add_argument("--get-threads").help("number of get threads");
+  program.add_argument("--thread-sweep").help("comma-separated list of total thread counts to run one after another");
+  program.add_argument("--second-tier").help("keep evicted pages compressed in a second tier of n MB");
+  program.add_argument("--numa").help(
+      "place the frames on the NUMA nodes: none (default), interleave, or partition (prefer the local node's frames)");
+  program.add_argument("--numa-nodes").help("simulate n NUMA nodes, e.g. on a single-node machine");
+  program.add_argument("--pin-threads")
+      .help("pin the worker threads to CPUs, round-robin over the NUMA nodes")
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--flusher").help("run the background flusher, keeping this share of frames clean");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 30000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  uint64_t latency_ms = 0;
+  if (program.present("--latency")) {
+    latency_ms = std::stoi(program.get("--latency"));
+  }
+
+  size_t bpm_size = BUSTUB_BPM_SIZE;
+  if (program.present("--bpm-size")) {
+    bpm_size = std::stoi(program.get("--bpm-size"));
+  }
+
+  size_t shards = 1;
+  if (program.present("--shards")) {
+    shards = std::stoi(program.get("--shards"));
+  }
+
+  size_t scan_thread_n = BUSTUB_SCAN_THREAD;
+  if (program.present("--scan-threads")) {
+    scan_thread_n = std::stoi(program.get("--scan-threads"));
+  }
+
+  size_t get_thread_n = BUSTUB_GET_THREAD;
+  if (program.present("--get-threads")) {
+    get_thread_n = std::stoi(program.get("--get-threads"));
+  }
+
+  std::vector<size_t> thread_sweep;
+  if (program.present("--thread-sweep")) {
+    for (const auto &thread_n : bustub::StringUtil::Split(program.get("--thread-sweep"), ',')) {
+      thread_sweep.push_back(std::stoi(thread_n));
+    }
+  }
+
+  double flusher_clean_share = 0;
+  if (program.present("--flusher")) {
+    flusher_clean_share = std::stod(program.get("--flusher"));
+  }
+
+  std::string disk = "memory";
+  if (program.present("--disk")) {
+    disk = program.get("--disk");
+  }
+
+  std::string db_file = "bpm_bench.db";
+  if (program.present("--db-file")) {
+    db_file = program.get("--db-file");
+  }
+
+  size_t queue_depth = bustub::DISK_QUEUE_DEPTH;
+  if (program.present("--queue-depth")) {
+    queue_depth = std::stoi(program.get("--queue-depth"));
+  }
+
+  auto numa_mode = bustub::NumaMode::None;
+  if (program.present("--numa")) {
+    auto numa = program.get("--numa");
+    if (numa == "interleave") {
+      numa_mode = bustub::NumaMode::Interleave;
+    } else if (numa == "partition") {
+      numa_mode = bustub::NumaMode::Partition;
+    } else if (numa != "none") {
+      std::cerr << "unknown NUMA mode: " << numa << std::endl;
+      return 1;
+    }
+  }
+  if (program.present("--numa-nodes")) {
+    bustub::NumaUtil::SimulateNodes(std::stoi(program.get("--numa-nodes")));
+  }
+  bool pin_threads = program.get<bool>("--pin-threads");
 
-  total_metrics.Report();
+  size_t second_tier_mb = 0;
+  if (program.present("--second-tier")) {
+    second_tier_mb = std::stoi(program.get("--second-tier"));
+  }
+
+  size_t read_ahead = 0;
+  if (program.present("--read-ahead")) {
+    read_ahead = std::stoi(program.get("--read-ahead"));
+  }
+
+  bustub::DiskManagerUnlimitedMemory *memory_disk_manager = nullptr;
+  std::unique_ptr<bustub::DiskManager> bench_disk_manager;
+  if (disk == "memory") {
+    auto memory = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+    memory_disk_manager = memory.get();
+    bench_disk_manager = std::move(memory);
+  } else if (disk == "fstream" || disk == "posix" || disk == "direct" || disk == "uring" || disk == "threads") {
+    // Start from an empty file, so that runs are comparable.
+    std::remove(db_file.c_str());
+    if (disk == "fstream") {
+      bench_disk_manager = std::make_unique<bustub::DiskManager>(db_file);
+    } else if (disk == "uring" || disk == "threads") {
+      auto async = std::make_unique<bustub::DiskManagerAsync>(db_file, false, queue_depth, disk == "uring");
+      if (disk == "uring" && !async->UsesIoUring()) {
+        fmt::print(stderr, "[warn] io_uring is not available, using a thread pool\n");
+      }
+      bench_disk_manager = std::move(async);
+    } else {
+      auto posix = std::make_unique<bustub::DiskManagerPosix>(db_file, disk == "direct");
+      if (disk == "direct" && !posix->IsDirectIo()) {
+        fmt::print(stderr, "[warn] O_DIRECT is not supported for {}, using buffered I/O\n", db_file);
+      }
+      bench_disk_manager = std::move(posix);
+    }
+  } else {
+    std::cerr << "unknown disk manager: " << disk << std::endl;
+    return 1;
+  }
+  bool checksums = program.get<bool>("--checksums");
+  if (checksums) {
+    if (memory_disk_manager != nullptr) {
+      std::cerr << "--checksums is only supported by the file based disk managers" << std::endl;
+      return 1;
+    }
+    std::remove((db_file.substr(0, db_file.rfind('.')) + ".crc").c_str());
+    bench_disk_manager->EnableChecksums();
+  }
+  if (latency_ms > 0 && memory_disk_manager == nullptr) {
+    std::cerr << "--latency is only supported by the memory disk manager" << std::endl;
+    return 1;
+  }
+
+  auto disk_manager = std::make_unique<GetMissCountingDiskManager>(std::move(bench_disk_manager));
+  auto bpm = std::make_unique<BufferPoolManager>(bpm_size, disk_manager.get(), LRU_K_SIZE, nullptr, shards,
+                                                 second_tier_mb * 1024 * 1024, numa_mode);
+  std::vector<page_id_t> page_ids;
+
+  fmt::print(stderr,
+             "[info] total_page={}, page_size={}, duration_ms={}, disk={}, queue_depth={}, latency_ms={}, "
+             "lru_k_size={}, bpm_size={}, shards={}, scan_threads={}, get_threads={}, read_ahead={}, flusher={}, "
+             "checksums={}, second_tier_mb={}, numa_nodes={}, pin_threads={}\n",
+             BUSTUB_PAGE_CNT, BUSTUB_PAGE_SIZE, duration_ms, disk, queue_depth, latency_ms, LRU_K_SIZE,
+             bpm_size, shards, scan_thread_n, get_thread_n, read_ahead, flusher_clean_share, checksums,
+             second_tier_mb, bustub::NumaUtil::NodeCount(), pin_threads);
+
+  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      throw std::runtime_error("new page failed");
+    }
+    char &ch = page->GetData()[i % 1024];
+    ch = 1;
+
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  // enable disk latency after creating all pages
+  if (memory_disk_manager != nullptr) {
+    memory_disk_manager->SetLatency(latency_ms);
+  }
+  if (flusher_clean_share > 0) {
+    bpm->StartBackgroundFlusher(flusher_clean_share);
+  }
+
+  fmt::print(stderr, "[info] benchmark start\n");
+
+  if (thread_sweep.empty()) {
+    BpmTotalMetrics total_metrics;
+    RunWorkload(bpm.get(), disk_manager.get(), page_ids, scan_thread_n, get_thread_n, duration_ms, read_ahead,
+                pin_threads, &total_metrics);
+    total_metrics.Report(bpm.get());
+    return 0;
+  }
+
+  // Run the same workload once per thread count, half of the threads scan and the other half do point lookups.
+  std::vector<std::pair<size_t, std::tuple<double, double, double>>> sweep_results;
+  for (auto thread_n : thread_sweep) {
+    fmt::print(stderr, "[info] running with {} threads\n", thread_n);
+    BpmTotalMetrics total_metrics;
+    RunWorkload(bpm.get(), disk_manager.get(), page_ids, thread_n / 2, thread_n - thread_n / 2, duration_ms, read_ahead,
+                pin_threads, &total_metrics);
+    sweep_results.push_back(
+        {thread_n, {total_metrics.ScanPerSec(), total_metrics.GetPerSec(), total_metrics.GetHitRatio()}});
+  }
+
+  fmt::print("<<< BEGIN\n");
+  for (const auto &[thread_n, result] : sweep_results) {
+    auto [scan_per_sec, get_per_sec, get_hit_ratio] = result;
+    fmt::print("threads={} scan: {} get: {} total: {} get_hit_ratio: {}\n", thread_n, scan_per_sec, get_per_sec,
+               scan_per_sec + get_per_sec, get_hit_ratio);
+  }
+  fmt::print("foreground_writes: {}\n", bpm->GetForegroundWriteCount());
+  fmt::print("background_writes: {}\n", bpm->GetBackgroundWriteCount());
+  PrintStatsJson(bpm.get());
+  fmt::print(">>> END\n");
 
   return 0;
 }
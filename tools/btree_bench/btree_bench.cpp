@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <numeric>
 #include <mutex>  // NOLINT
+#include <optional>
 #include <random>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 #include <cpp_random_distributions/zipfian_int_distribution.h>
@@ -17,11 +21,13 @@
 #include "common/config.h"
 #include "common/exception.h"
 #include "common/rid.h"
+#include "common/util/numa_util.h"
 #include "common/util/string_util.h"
 #include "fmt/format.h"
 #include "storage/disk/disk_manager_memory.h"
 #include "storage/index/b_plus_tree.h"
 #include "storage/index/generic_key.h"
+#include "storage/index/varlen_b_plus_tree_index.h"
 #include "test_util.h"
 
 #include <sys/time.h>
@@ -32,6 +38,24 @@ auto ClockMs() -> uint64_t {
   return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
 }
 
+/** Prints the frames whose latches made threads wait the most, if the latch counts its contention. */
+static void PrintHotLatches(bustub::BufferPoolManager *bpm, size_t top_n) {
+  auto stats = bpm->GetLatchStats();
+  if (std::all_of(stats.begin(), stats.end(), [](const auto &s) { return s.second.acquisitions_ == 0; })) {
+    fmt::print(stderr, "[info] no latch counters, build with -DBUSTUB_RWLATCH=hybrid to get them\n");
+    return;
+  }
+  auto waits = [](const bustub::LatchStats &s) { return s.spins_ + s.parks_; };
+  top_n = std::min(top_n, stats.size());
+  std::partial_sort(stats.begin(), stats.begin() + top_n, stats.end(),
+                    [&](const auto &a, const auto &b) { return waits(a.second) > waits(b.second); });
+  for (size_t i = 0; i < top_n; i++) {
+    const auto &[page_id, s] = stats[i];
+    fmt::print(stderr, "[info] hot latch: page_id={} acquisitions={} spins={} parks={}\n", page_id, s.acquisitions_,
+               s.spins_, s.parks_);
+  }
+}
+
 static const size_t BUSTUB_READ_THREAD = 4;
 static const size_t BUSTUB_WRITE_THREAD = 2;
 static const size_t LRU_K_SIZE = 4;
@@ -110,6 +134,76 @@ auto KeyWillVanish(size_t key) -> bool { return key % 7 == 0; }
 // These keys will be overwritten to a new value
 auto KeyWillChange(size_t key) -> bool { return key % 5 == 0; }
 
+/**
+ * Loads the same string keys in random order into a GenericKey<64> tree and into a varlen tree, then looks them all up
+ * on one thread, to compare the space and time each takes.
+ */
+static void RunStringKeys() {
+  using bustub::Value;
+
+  auto key_schema = bustub::ParseCreateStatement("a varchar(64)");
+  std::vector<size_t> order(TOTAL_KEYS);
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), std::mt19937(15445));
+  std::vector<bustub::Tuple> keys;
+  keys.reserve(TOTAL_KEYS);
+  for (auto key : order) {
+    std::vector<Value> values{Value(bustub::TypeId::VARCHAR, fmt::format("user-{:012}@example.com", key))};
+    keys.emplace_back(values, key_schema.get());
+  }
+
+  auto report = [](const char *tree, uint64_t insert_ms, uint64_t lookup_ms, size_t pages) {
+    fmt::print(stderr, "[info] {}: insert: {:.0f} keys/s, lookup: {:.0f} keys/s, pages={}\n", tree,
+               TOTAL_KEYS / static_cast<double>(std::max<uint64_t>(insert_ms, 1)) * 1000,
+               TOTAL_KEYS / static_cast<double>(std::max<uint64_t>(lookup_ms, 1)) * 1000, pages);
+  };
+
+  {
+    auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<bustub::BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+    bustub::page_id_t page_id;
+    auto header_page = bpm->NewPageGuarded(&page_id);
+    bustub::GenericComparator<64> comparator(key_schema.get());
+    bustub::BPlusTree<bustub::GenericKey<64>, bustub::RID, bustub::GenericComparator<64>> tree("foo_pk", page_id,
+                                                                                               bpm.get(), comparator);
+    bustub::GenericKey<64> index_key;
+    std::vector<bustub::RID> rids;
+    auto start = ClockMs();
+    for (size_t i = 0; i < TOTAL_KEYS; i++) {
+      index_key.SetFromKey(keys[i]);
+      tree.Insert(index_key, bustub::RID(order[i], order[i]));
+    }
+    auto insert_ms = ClockMs() - start;
+    start = ClockMs();
+    for (const auto &key : keys) {
+      rids.clear();
+      index_key.SetFromKey(key);
+      tree.GetValue(index_key, &rids);
+    }
+    report("generic_key<64>", insert_ms, ClockMs() - start, disk_manager->GetPageCount());
+  }
+
+  {
+    auto disk_manager = std::make_unique<bustub::DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<bustub::BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+    bustub::page_id_t page_id;
+    auto header_page = bpm->NewPageGuarded(&page_id);
+    bustub::VarlenBPlusTree tree("foo_pk", page_id, bpm.get());
+    std::vector<bustub::RID> rids;
+    auto start = ClockMs();
+    for (size_t i = 0; i < TOTAL_KEYS; i++) {
+      tree.Insert(bustub::VarlenBPlusTreeIndex::EncodeKey(keys[i], *key_schema), bustub::RID(order[i], order[i]));
+    }
+    auto insert_ms = ClockMs() - start;
+    start = ClockMs();
+    for (const auto &key : keys) {
+      rids.clear();
+      tree.GetValue(bustub::VarlenBPlusTreeIndex::EncodeKey(key, *key_schema), &rids);
+    }
+    report("varlen", insert_ms, ClockMs() - start, disk_manager->GetPageCount());
+  }
+}
+
 // NOLINTNEXTLINE
 auto main(int argc, char **argv) -> int {
   using bustub::AccessType;
@@ -119,6 +213,20 @@ auto main(int argc, char **argv) -> int {
 
   argparse::ArgumentParser program("bustub-btree-bench");
   program.add_argument("--duration").help("run btree bench for n milliseconds");
+  program.add_argument("--numa").help(
+      "place the frames on the NUMA nodes: none (default), interleave, or partition (prefer the local node's frames)");
+  program.add_argument("--numa-nodes").help("simulate n NUMA nodes, e.g. on a single-node machine");
+  program.add_argument("--key-compare")
+      .help("compare keys as integers (default, which the in-page search is specialized for) or as values");
+  program.add_argument("--batch").help(
+      "insert and look up the keys before the run n at a time with InsertBatch() and GetValues() (default 1, one by "
+      "one)");
+  program.add_argument("--key-type")
+      .help("integer keys (default), or string keys to compare GenericKey<64> and varlen B+ trees on one thread");
+  program.add_argument("--pin-threads")
+      .help("pin the worker threads to CPUs, round-robin over the NUMA nodes")
+      .default_value(false)
+      .implicit_value(true);
 
   try {
     program.parse_args(argc, argv);
@@ -133,14 +241,60 @@ auto main(int argc, char **argv) -> int {
     duration_ms = std::stoi(program.get("--duration"));
   }
 
+  auto numa_mode = bustub::NumaMode::None;
+  if (program.present("--numa")) {
+    auto numa = program.get("--numa");
+    if (numa == "interleave") {
+      numa_mode = bustub::NumaMode::Interleave;
+    } else if (numa == "partition") {
+      numa_mode = bustub::NumaMode::Partition;
+    } else if (numa != "none") {
+      std::cerr << "unknown NUMA mode: " << numa << std::endl;
+      return 1;
+    }
+  }
+  if (program.present("--numa-nodes")) {
+    bustub::NumaUtil::SimulateNodes(std::stoi(program.get("--numa-nodes")));
+  }
+  bool pin_threads = program.get<bool>("--pin-threads");
+  bool compare_integers = true;
+  if (program.present("--key-compare")) {
+    auto key_compare = program.get("--key-compare");
+    if (key_compare == "values") {
+      compare_integers = false;
+    } else if (key_compare != "integers") {
+      std::cerr << "unknown key comparison: " << key_compare << std::endl;
+      return 1;
+    }
+  }
+
+  if (program.present("--key-type")) {
+    auto key_type = program.get("--key-type");
+    if (key_type == "string") {
+      RunStringKeys();
+      return 0;
+    }
+    if (key_type != "integer") {
+      std::cerr << "unknown key type: " << key_type << std::endl;
+      return 1;
+    }
+  }
+
+  size_t batch_size = 1;
+  if (program.present("--batch")) {
+    batch_size = std::max(std::stoi(program.get("--batch")), 1);
+  }
+
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE, nullptr, 1, 0,
+                                                 numa_mode);
 
-  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS, duration_ms,
-             LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}, numa_nodes={}, pin_threads={}\n",
+             TOTAL_KEYS, duration_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE, bustub::NumaUtil::NodeCount(), pin_threads);
 
   auto key_schema = bustub::ParseCreateStatement("a bigint");
-  bustub::GenericComparator<8> comparator(key_schema.get());
+  bustub::GenericComparator<8> comparator(key_schema.get(), compare_integers);
 
   page_id_t page_id;
   auto header_page = bpm->NewPageGuarded(&page_id);
@@ -148,16 +302,56 @@ auto main(int argc, char **argv) -> int {
   bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>> index("foo_pk", page_id,
                                                                                             bpm.get(), comparator);
 
-  for (size_t key = 0; key < TOTAL_KEYS; key++) {
+  {
+    auto start = ClockMs();
+    std::vector<std::pair<bustub::GenericKey<8>, bustub::RID>> pairs;
+    for (size_t key = 0; key < TOTAL_KEYS; key++) {
+      bustub::GenericKey<8> index_key;
+      bustub::RID rid;
+      uint32_t value = key;
+      rid.Set(value, value);
+      index_key.SetFromInteger(key);
+      if (batch_size == 1) {
+        index.Insert(index_key, rid, nullptr);
+        continue;
+      }
+      pairs.emplace_back(index_key, rid);
+      if (pairs.size() == batch_size || key + 1 == TOTAL_KEYS) {
+        index.InsertBatch(pairs, nullptr);
+        pairs.clear();
+      }
+    }
+    auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+    fmt::print(stderr, "[info] insert: {:.0f} keys/s, batch={}\n", TOTAL_KEYS / static_cast<double>(elapsed) * 1000,
+               batch_size);
+  }
+
+  // Lookups on one thread, before the writers start, measure the search within pages without contention.
+  {
     bustub::GenericKey<8> index_key;
-    bustub::RID rid;
-    uint32_t value = key;
-    rid.Set(value, value);
-    index_key.SetFromInteger(key);
-    index.Insert(index_key, rid, nullptr);
+    std::vector<bustub::RID> rids;
+    std::vector<bustub::GenericKey<8>> keys;
+    std::vector<std::optional<bustub::RID>> values;
+    auto start = ClockMs();
+    for (size_t key = 0; key < TOTAL_KEYS; key++) {
+      index_key.SetFromInteger(key);
+      if (batch_size == 1) {
+        rids.clear();
+        index.GetValue(index_key, &rids);
+        continue;
+      }
+      keys.push_back(index_key);
+      if (keys.size() == batch_size || key + 1 == TOTAL_KEYS) {
+        index.GetValues(keys, &values);
+        keys.clear();
+      }
+    }
+    auto elapsed = std::max<uint64_t>(ClockMs() - start, 1);
+    fmt::print(stderr, "[info] lookup: {:.0f} keys/s, key_compare={}, batch={}\n",
+               TOTAL_KEYS / static_cast<double>(elapsed) * 1000, compare_integers ? "integers" : "values", batch_size);
   }
 
-  fmt::print(stderr, "[info] benchmark start\n");
+  fmt::print(stderr, "[info] benchmark start, pages={}\n", disk_manager->GetPageCount());
 
   BTreeTotalMetrics total_metrics;
   total_metrics.Begin();
@@ -165,7 +359,10 @@ auto main(int argc, char **argv) -> int {
   std::vector<std::thread> threads;
 
   for (size_t thread_id = 0; thread_id < BUSTUB_READ_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &index, duration_ms, pin_threads, &total_metrics] {
+      if (pin_threads) {
+        bustub::NumaUtil::PinThread(thread_id);
+      }
       BTreeMetrics metrics(fmt::format("read  {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
@@ -211,7 +408,10 @@ auto main(int argc, char **argv) -> int {
   }
 
   for (size_t thread_id = 0; thread_id < BUSTUB_WRITE_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &index, duration_ms, pin_threads, &total_metrics] {
+      if (pin_threads) {
+        bustub::NumaUtil::PinThread(BUSTUB_READ_THREAD + thread_id);
+      }
       BTreeMetrics metrics(fmt::format("write {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
@@ -261,6 +461,12 @@ auto main(int argc, char **argv) -> int {
     thread.join();
   }
 
+  // With page reuse, the delete / insert churn keeps the number of pages about where the initial load left it.
+  fmt::print(stderr, "[info] pages={}, free_pages={}\n", disk_manager->GetPageCount(),
+             disk_manager->GetFreePageCount());
+
+  PrintHotLatches(bpm.get(), 10);
+
   total_metrics.Report();
 
   return 0;
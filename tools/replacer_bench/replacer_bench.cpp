@@ -0,0 +1,110 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <cpp_random_distributions/zipfian_int_distribution.h>
+
+#include "argparse/argparse.hpp"
+#include "buffer/lru_k_replacer.h"
+#include "common/config.h"
+#include "common/util/string_util.h"
+#include "fmt/core.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t LRU_K_SIZE = 2;
+/** One out of MISS_INTERVAL operations is a miss that evicts a frame, the others are hits. */
+static const size_t MISS_INTERVAL = 5;
+
+/**
+ * Drive a replacer the way the buffer pool does and return the number of operations per second. A hit pins a frame,
+ * records an access and unpins it again; a miss evicts a victim and reuses its frame. Frames are picked with a
+ * zipfian distribution, so that some of them reach k accesses and others don't.
+ */
+auto RunReplacer(size_t num_frames, uint64_t duration_ms) -> double {
+  using bustub::frame_id_t;
+
+  bustub::LRUKReplacer replacer(num_frames, LRU_K_SIZE);
+  for (size_t i = 0; i < num_frames; i++) {
+    replacer.RecordAccess(static_cast<frame_id_t>(i));
+    replacer.SetEvictable(static_cast<frame_id_t>(i), true);
+  }
+
+  std::default_random_engine gen(0);
+  zipfian_int_distribution<size_t> dist(0, num_frames - 1, 0.8);
+
+  uint64_t op_cnt = 0;
+  auto start_time = ClockMs();
+  uint64_t elapsed = 0;
+  while (elapsed < duration_ms) {
+    // check the clock every few operations, the slowest replacers take milliseconds per operation at 1M frames
+    for (size_t i = 0; i < 16; i++, op_cnt++) {
+      frame_id_t frame_id;
+      if (op_cnt % MISS_INTERVAL == 0) {
+        if (!replacer.Evict(&frame_id)) {
+          throw std::runtime_error("no frame to evict");
+        }
+      } else {
+        frame_id = static_cast<frame_id_t>(dist(gen));
+        replacer.SetEvictable(frame_id, false);
+      }
+      replacer.RecordAccess(frame_id);
+      replacer.SetEvictable(frame_id, true);
+    }
+    elapsed = ClockMs() - start_time;
+  }
+  return op_cnt / static_cast<double>(elapsed) * 1000;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-bench");
+  program.add_argument("--duration").help("run each pool size for n milliseconds");
+  program.add_argument("--frames").help("comma-separated list of pool sizes, in frames");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 5000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  std::vector<size_t> frames{1 << 10, 1 << 14, 1 << 17, 1 << 20};
+  if (program.present("--frames")) {
+    frames.clear();
+    for (const auto &num_frames : bustub::StringUtil::Split(program.get("--frames"), ',')) {
+      frames.push_back(std::stoi(num_frames));
+    }
+  }
+
+  fmt::print(stderr, "[info] duration_ms={}, lru_k_size={}, miss_interval={}\n", duration_ms, LRU_K_SIZE,
+             MISS_INTERVAL);
+
+  std::vector<std::pair<size_t, double>> results;
+  for (auto num_frames : frames) {
+    fmt::print(stderr, "[info] running with {} frames\n", num_frames);
+    results.emplace_back(num_frames, RunReplacer(num_frames, duration_ms));
+  }
+
+  fmt::print("<<< BEGIN\n");
+  for (const auto &[num_frames, ops_per_sec] : results) {
+    fmt::print("frames={} ops: {}\n", num_frames, ops_per_sec);
+  }
+  fmt::print(">>> END\n");
+
+  return 0;
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -10,6 +11,7 @@
 
 #include "argparse/argparse.hpp"
 #include "binder/binder.h"
+#include "buffer/buffer_pool_manager.h"
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
@@ -27,6 +29,24 @@ auto ClockMs() -> uint64_t {
   return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
 }
 
+/** Prints the frames whose latches made threads wait the most, if the latch counts its contention. */
+static void PrintHotLatches(bustub::BufferPoolManager *bpm, size_t top_n) {
+  auto stats = bpm->GetLatchStats();
+  if (std::all_of(stats.begin(), stats.end(), [](const auto &s) { return s.second.acquisitions_ == 0; })) {
+    fmt::print(stderr, "[info] no latch counters, build with -DBUSTUB_RWLATCH=hybrid to get them\n");
+    return;
+  }
+  auto waits = [](const bustub::LatchStats &s) { return s.spins_ + s.parks_; };
+  top_n = std::min(top_n, stats.size());
+  std::partial_sort(stats.begin(), stats.begin() + top_n, stats.end(),
+                    [&](const auto &a, const auto &b) { return waits(a.second) > waits(b.second); });
+  for (size_t i = 0; i < top_n; i++) {
+    const auto &[page_id, s] = stats[i];
+    fmt::print(stderr, "[info] hot latch: page_id={} acquisitions={} spins={} parks={}\n", page_id, s.acquisitions_,
+               s.spins_, s.parks_);
+  }
+}
+
 static const size_t BUSTUB_TERRIER_THREAD = 2;
 static const size_t BUSTUB_TERRIER_CNT = 100;
 
@@ -515,6 +535,8 @@ auto main(int argc, char **argv) -> int {
     }
   }
 
+  PrintHotLatches(bustub->buffer_pool_manager_, 10);
+
   total_metrics.Report();
 
   if (total_metrics.committed_verify_txn_cnt_ <= 3 || total_metrics.committed_update_txn_cnt_ < 3 ||